@@ -13,6 +13,12 @@
 #include "CFileLoader.h"
 #include "CSprite2d.h"
 #include "CAudioEngine.h"
+#include "CPools.h"
+#include "CPed.h"
+#include "CTaskManager.h"
+#include "CWorld.h"
+#include "MinHook.h"
+#include "VehicleSFXTelemetry.h"
 #include "rwcore.h"  
 
 #include <filesystem>
@@ -22,9 +28,27 @@
 #include <mutex>
 #include <algorithm>
 #include <cstring>
+#include <cmath>
 #include <fstream>
 #include <ctime>
 #include <cstdarg>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <limits>
+#include <bit>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define VSFX_AVX2_TARGET
+#else
+#include <cpuid.h>
+#define VSFX_AVX2_TARGET __attribute__((target("avx2")))
+#endif
 
 using namespace plugin;
 namespace fs = std::filesystem;
@@ -34,7 +58,9 @@ namespace fs = std::filesystem;
 // Parmetros ajustveis (valores seguros por padro)
 // array simples, NO constexpr
 // ---- inicialize o array com defaults seguros ----
-static float START_PITCH_PER_GEAR[6] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; static float TARGET_PITCH;
+// cTransmission::m_aGears tem 6 entradas (0 = r/neutro), logo no mximo 5 marchas  frente
+static const int MAX_TRANSMISSION_GEARS = 5;
+static float START_PITCH_PER_GEAR[MAX_TRANSMISSION_GEARS + 1] = { 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f }; static float TARGET_PITCH;
 static float PITCH_SMOOTHING;
 static float PITCH_AMPLIFY_MAX;
 static float MAX_OVERSHOOT;
@@ -54,9 +80,24 @@ static float WIND_FADE_MS;      // dura
 static float MAX_WIND_RATE_PER_SEC; // quanta frao de volume pode mudar por segundo
 static float WIND_STOP_THRESHOLD; // abaixo disto paramos o canal
 
+static float SIGNAL_SPEED_TAU_MS;    // constante de tempo do filtro de velocidade (ms)
+static float BACKFIRE_DECEL_PER_SEC; // queda brusca: acelerao (speed/s) abaixo disto
+static float WHEELSPIN_ON;           // m_fWheelSpinForAudio acima disto liga o wheelspin
+static float WHEELSPIN_OFF;          // ... e abaixo disto desliga (histerese)
+
+static bool UPDATE_IN_PHYSICS;       // UpdateMode=physics: atualiza logo aps o ProcessControl do veculo
+
+static float DORMANT_AFTER_MS;       // instncia quieta h tanto tempo adormece (0 = nunca)
+static float DORMANT_RELEASE_DIST;   // ao adormecer mais longe do ouvinte do que isto, o loop  libertado
+
 
 // ---------------- logging ----------------
+// chamado do jogo, do init do FMOD, do prefetch e do hot reload: um escritor de
+// cada vez (e o asctime/localtime usam buffers estticos)
+static std::mutex g_logMutex;
+
 static void InitLog() {
+    std::lock_guard<std::mutex> lock(g_logMutex);
     std::ofstream f("VehicleSFX_log.txt", std::ios::trunc); // limpa o arquivo
     if (f.is_open()) {
         std::time_t t = std::time(nullptr);
@@ -70,6 +111,7 @@ static void InitLog() {
 static void WriteLog(const char* fmt, ...) {
     char buf[1024];
     va_list ap; va_start(ap, fmt); vsnprintf(buf, sizeof(buf), fmt, ap); va_end(ap);
+    std::lock_guard<std::mutex> lock(g_logMutex);
     std::ofstream f("VehicleSFX_log.txt", std::ios::app);
     if (f.is_open()) {
         std::time_t t = std::time(nullptr);
@@ -78,10 +120,25 @@ static void WriteLog(const char* fmt, ...) {
         f << ts << " : " << buf << std::endl;
         f.close();
     }
+#ifdef VSFX_TOOL
+    std::printf("%s\n", buf);
+#endif
 }
 
 // ---------------- config ----------------
-static std::map<std::string, float> g_config;
+// O LoadConfig monta um snapshot novo e troca-o de uma vez: os threads de trabalho
+// (hot reload, prefetch) leem sempre um ini inteiro, nunca um mapa a meio do reload.
+struct ConfigSnapshot {
+    std::map<std::string, float> values;
+    std::map<std::string, std::string> text;  // valor cru (curvas etc.)
+};
+typedef std::shared_ptr<const ConfigSnapshot> ConfigRef;
+
+static ConfigRef g_config = std::make_shared<ConfigSnapshot>();
+static std::mutex g_configLock;  // s protege a troca do ponteiro
+static std::string g_configPath;
+static fs::file_time_type g_configWriteTime;
+static unsigned int g_configGeneration = 1; // incrementa a cada reload (invalida tabelas)
 // ---- coloque isto no topo (utilitrios) ----
 static inline std::string Trim(const std::string& s) {
     size_t a = 0;
@@ -97,12 +154,37 @@ static inline std::string ToLower(const std::string& s) {
 }
 
 
+// snapshot fixado neste thread (ConfigScope); vazio = o atual
+static ConfigRef& PinnedConfig() {
+    static thread_local ConfigRef pinned;
+    return pinned;
+}
+
+static ConfigRef CurrentConfig() {
+    if (PinnedConfig()) return PinnedConfig();
+    std::lock_guard<std::mutex> lk(g_configLock);
+    return g_config;
+}
+
+// as leituras deste thread usam 'snapshot' enquanto o objeto vive: um trabalho
+// pedido num frame v o ini desse frame, mesmo que entretanto seja recarregado
+struct ConfigScope {
+    ConfigRef previous;
+    explicit ConfigScope(ConfigRef snapshot) : previous(PinnedConfig()) { PinnedConfig() = std::move(snapshot); }
+    ~ConfigScope() { PinnedConfig() = std::move(previous); }
+};
+
 // ---- substitua LoadConfig / GetConfig por isto ----
 static void LoadConfig(const std::string& path) {
-    g_config.clear();
+    auto next = std::make_shared<ConfigSnapshot>();
+    g_configPath = path;
+    std::error_code ec;
+    g_configWriteTime = fs::last_write_time(path, ec);
     std::ifstream f(path);
     if (!f.is_open()) {
         WriteLog("LoadConfig: arquivo %s no encontrado", path.c_str());
+        std::lock_guard<std::mutex> lk(g_configLock);
+        g_config = next;
         return;
     }
 
@@ -127,28 +209,41 @@ static void LoadConfig(const std::string& path) {
 
         if (key.empty() || val.empty()) continue;
 
+        // normaliza chave para lowercase (evita problemas de espaos/case)
+        key = ToLower(key);
+        next->text[key] = val;
+        // valores com ':' so listas de pontos (curvas), no nmeros;
+        // comeando por letra so texto (UpdateMode, OverlayRule<n>...)
+        if (val.find(':') != std::string::npos || std::isalpha((unsigned char)val[0])) continue;
+
         try {
             float fv = std::stof(val);
-            // normaliza chave para lowercase (evita problemas de espaos/case)
-            key = ToLower(key);
-            g_config[key] = fv;
+            next->values[key] = fv;
         }
         catch (const std::exception& e) {
             WriteLog("LoadConfig: failed to parse '%s'='%s' (%s)", key.c_str(), val.c_str(), e.what());
         }
     }
     f.close();
-    WriteLog("LoadConfig: carregado %zu entradas", g_config.size());
+    WriteLog("LoadConfig: carregado %zu entradas", next->values.size());
+    std::lock_guard<std::mutex> lk(g_configLock);
+    g_config = next;
 }
 
 static float GetConfig(const std::string& key, float def) {
-    std::string k = ToLower(key);
-    auto it = g_config.find(k);
-    return (it != g_config.end()) ? it->second : def;
+    ConfigRef config = CurrentConfig();
+    auto it = config->values.find(ToLower(key));
+    return (it != config->values.end()) ? it->second : def;
+}
+
+static std::string GetConfigText(const std::string& key, const std::string& def = std::string()) {
+    ConfigRef config = CurrentConfig();
+    auto it = config->text.find(ToLower(key));
+    return (it != config->text.end()) ? it->second : def;
 }
 
 void InitParams() {
-    for (int gear = 1; gear <= 5; gear++) {
+    for (int gear = 1; gear <= MAX_TRANSMISSION_GEARS; gear++) {
         std::string key = "StartPitchGear" + std::to_string(gear);
         START_PITCH_PER_GEAR[gear] = GetConfig(key, START_PITCH_PER_GEAR[gear]);
         WriteLog("InitParams: %s = %.3f", key.c_str(), START_PITCH_PER_GEAR[gear]);
@@ -171,6 +266,353 @@ void InitParams() {
     WIND_FADE_MS = GetConfig("WindFadeMs", 2500.0f);
     MAX_WIND_RATE_PER_SEC = GetConfig("MaxWindRatePerSec", 0.25f);
     WIND_STOP_THRESHOLD = GetConfig("WindStopThreshold", 0.1f);
+    SIGNAL_SPEED_TAU_MS = GetConfig("SignalSpeedTauMs", 40.0f);
+    BACKFIRE_DECEL_PER_SEC = GetConfig("BackfireDecelPerSec", -90.0f);
+    WHEELSPIN_ON = GetConfig("WheelSpinOn", 0.6f);
+    WHEELSPIN_OFF = GetConfig("WheelSpinOff", 0.5f);
+    UPDATE_IN_PHYSICS = ToLower(GetConfigText("UpdateMode", "scripts")) == "physics";
+    DORMANT_AFTER_MS = GetConfig("DormantAfterMs", 2000.0f);
+    DORMANT_RELEASE_DIST = GetConfig("DormantReleaseDistance", 100.0f);
+}
+
+// recarrega o ini quando o arquivo muda (tabelas de resposta so refeitas via g_configGeneration)
+static const unsigned int CONFIG_POLL_MS = 1000;
+
+static void ReloadConfigIfChanged() {
+    static unsigned int lastPollMs = 0;
+    unsigned int now = CTimer::m_snTimeInMilliseconds;
+    if ((now - lastPollMs) < CONFIG_POLL_MS) return;
+    lastPollMs = now;
+    if (g_configPath.empty()) return;
+
+    std::error_code ec;
+    fs::file_time_type wt = fs::last_write_time(g_configPath, ec);
+    if (ec || wt == g_configWriteTime) return;
+
+    WriteLog("ReloadConfigIfChanged: %s changed, reloading", g_configPath.c_str());
+    LoadConfig(g_configPath);
+    InitParams();
+    ++g_configGeneration;
+}
+
+// ---------------- FMOD memory ----------------
+// Alocador prprio para o FMOD (FMOD::Memory_Initialize):
+//  - blocos pequenos (<= 4 KB) em classes de tamanho com free list por classe;
+//  - blocos grandes (sample data) numa arena best-fit com coalescncia;
+//  - opcionalmente um pool fixo reservado no arranque (FMODMemoryPoolMB):
+//    o plugin nunca passa desse tamanho, alocaes alm disso falham (FMOD_ERR_MEMORY).
+// Cada bloco leva um cabealho de 16 bytes com o tamanho pedido, o tamanho real do
+// bloco na arena, a tag (modelo do banco a carregar, para as estatsticas por banco)
+// e se  sample data.
+class FmodArenaAllocator {
+public:
+    static const int SMALL_CLASS_COUNT = 9;              // 16 .. 4096
+    static const unsigned int SMALL_MAX = 4096;
+    static const size_t SMALL_PAGE_BYTES = 64 * 1024;
+    static const size_t ARENA_GROW_BYTES = 4 * 1024 * 1024;
+    static const size_t LARGE_ALIGN = 64;
+
+    struct Stats {
+        long long currentBytes = 0;      // pedidos vivos
+        long long peakBytes = 0;
+        long long sampleBytes = 0;       // FMOD_MEMORY_SAMPLEDATA vivos
+        long long reservedBytes = 0;     // memria tirada do sistema (ou tamanho do pool)
+        long long arenaFreeBytes = 0;
+        long long arenaLargestFree = 0;
+        long long smallFreeBytes = 0;    // slots livres nas classes
+        unsigned long long allocCount = 0;
+        unsigned long long failCount = 0;
+        unsigned long long badFrees = 0; // free/realloc de ponteiro sem o nosso cabealho (ou double free)
+    };
+
+    ~FmodArenaAllocator() { ReleaseAll(); }
+
+    // poolBytes > 0: reserva tudo agora e nunca cresce
+    void Init(size_t poolBytes) {
+        std::lock_guard<std::mutex> lk(m_lock);
+        m_fixedPool = poolBytes > 0;
+        if (m_fixedPool) AddRegion(RoundUp(poolBytes, LARGE_ALIGN));
+    }
+
+    void* Alloc(unsigned int size, unsigned int type) {
+        std::lock_guard<std::mutex> lk(m_lock);
+        return AllocLocked(size, type);
+    }
+
+    void* Realloc(void* ptr, unsigned int size, unsigned int type) {
+        if (!ptr) return Alloc(size, type);
+        std::lock_guard<std::mutex> lk(m_lock);
+        Header* h = HeaderOf(ptr);
+        if (!CheckMagic(h, "Realloc")) return nullptr;
+        // ainda cabe no mesmo slot/bloco: s atualiza as contas; um bloco grande
+        // que encolheu devolve a cauda  arena
+        if (size <= Capacity(h)) {
+            Account(h, -1);
+            h->size = size;
+            Account(h, +1);
+            if (h->sizeClass == LARGE_CLASS) {
+                size_t need = LargeBlockBytes(size);
+                if (need < h->blockBytes) {
+                    InsertFree((char*)h + need, h->blockBytes - need);
+                    h->blockBytes = (unsigned int)need;
+                }
+            }
+            return ptr;
+        }
+        void* p = AllocLocked(size, type);
+        if (!p) return nullptr;
+        std::memcpy(p, ptr, h->size);
+        FreeLocked(h);
+        return p;
+    }
+
+    void Free(void* ptr) {
+        if (!ptr) return;
+        std::lock_guard<std::mutex> lk(m_lock);
+        FreeLocked(HeaderOf(ptr));
+    }
+
+    Stats GetStats() {
+        std::lock_guard<std::mutex> lk(m_lock);
+        Stats s = m_stats;
+        for (auto& kv : m_arenaFree) {
+            s.arenaFreeBytes += (long long)kv.second;
+            s.arenaLargestFree = std::max(s.arenaLargestFree, (long long)kv.second);
+        }
+        for (int c = 0; c < SMALL_CLASS_COUNT; ++c) s.smallFreeBytes += (long long)m_smallFreeCount[c] * ClassSize(c);
+        return s;
+    }
+
+    long long TagBytes(int tag) {
+        std::lock_guard<std::mutex> lk(m_lock);
+        auto it = m_tagBytes.find(tag);
+        return (it != m_tagBytes.end()) ? it->second : 0;
+    }
+
+    std::map<int, long long> TagSnapshot() {
+        std::lock_guard<std::mutex> lk(m_lock);
+        return m_tagBytes;
+    }
+
+    void ReleaseAll() {
+        std::lock_guard<std::mutex> lk(m_lock);
+        for (auto& r : m_regions) ::operator delete(r.first, std::align_val_t(LARGE_ALIGN));
+        m_regions.clear();
+        m_arenaFree.clear();
+        m_tagBytes.clear();
+        for (int c = 0; c < SMALL_CLASS_COUNT; ++c) { m_smallFree[c] = nullptr; m_smallFreeCount[c] = 0; }
+        m_stats = Stats();
+    }
+
+    // tag corrente do thread (modelo do banco em carregamento); -1 = sem banco
+    static int& CurrentTag() {
+        static thread_local int tag = -1;
+        return tag;
+    }
+
+private:
+    struct Header {
+        unsigned int size;        // bytes pedidos
+        unsigned int blockBytes;  // bytes do bloco na arena, cabealho includo (0 nas classes)
+        int tag;
+        unsigned char sizeClass;  // LARGE_CLASS para blocos da arena
+        unsigned char flags;      // HF_*
+        unsigned short magic;
+    };
+    static_assert(sizeof(Header) == 16, "header must keep 16-byte alignment");
+    static const unsigned char LARGE_CLASS = 0xFF;
+    static const unsigned char HF_SAMPLE_DATA = 1 << 0;
+    static const unsigned short HEADER_MAGIC = 0x5EFD;
+    static const unsigned long long BAD_FREE_LOG_LIMIT = 8;
+
+    struct FreeSlot { FreeSlot* next; };
+
+    static size_t RoundUp(size_t v, size_t a) { return (v + a - 1) / a * a; }
+    static unsigned int ClassSize(int c) { return 16u << c; }
+    static int ClassFor(unsigned int size) {
+        int c = 0;
+        while (ClassSize(c) < size) ++c;
+        return c;
+    }
+    static size_t LargeBlockBytes(unsigned int size) { return RoundUp(size + sizeof(Header), LARGE_ALIGN); }
+    static Header* HeaderOf(void* p) { return (Header*)((char*)p - sizeof(Header)); }
+    unsigned int Capacity(const Header* h) const {
+        return (h->sizeClass == LARGE_CLASS) ? (unsigned int)(h->blockBytes - sizeof(Header)) : ClassSize(h->sizeClass);
+    }
+
+    void Account(const Header* h, int sign) {
+        m_stats.currentBytes += sign * (long long)h->size;
+        if (h->flags & HF_SAMPLE_DATA) m_stats.sampleBytes += sign * (long long)h->size;
+        if (h->tag >= 0) m_tagBytes[h->tag] += sign * (long long)h->size;
+        m_stats.peakBytes = std::max(m_stats.peakBytes, m_stats.currentBytes);
+    }
+
+    void AddRegion(size_t bytes) {
+        char* p = nullptr;
+        try { p = (char*)::operator new(bytes, std::align_val_t(LARGE_ALIGN)); }
+        catch (...) { return; }
+        m_regions.emplace_back(p, bytes);
+        m_stats.reservedBytes += (long long)bytes;
+        InsertFree(p, bytes);
+    }
+
+    void InsertFree(char* p, size_t bytes) {
+        auto next = m_arenaFree.lower_bound(p);
+        if (next != m_arenaFree.end() && p + bytes == next->first) {
+            bytes += next->second;
+            next = m_arenaFree.erase(next);
+        }
+        if (next != m_arenaFree.begin()) {
+            auto prev = std::prev(next);
+            if (prev->first + prev->second == p) { prev->second += bytes; return; }
+        }
+        m_arenaFree.emplace(p, bytes);
+    }
+
+    // best-fit na arena; cresce com uma regio nova se no houver pool fixo
+    char* TakeArena(size_t bytes) {
+        auto best = m_arenaFree.end();
+        for (auto it = m_arenaFree.begin(); it != m_arenaFree.end(); ++it) {
+            if (it->second >= bytes && (best == m_arenaFree.end() || it->second < best->second)) best = it;
+        }
+        if (best == m_arenaFree.end()) {
+            if (m_fixedPool) return nullptr;
+            size_t regions = m_regions.size();
+            AddRegion(std::max(ARENA_GROW_BYTES, bytes));
+            if (m_regions.size() == regions) return nullptr;
+            return TakeArena(bytes);
+        }
+        char* p = best->first;
+        size_t rest = best->second - bytes;
+        m_arenaFree.erase(best);
+        if (rest >= LARGE_ALIGN) m_arenaFree.emplace(p + bytes, rest);
+        return p;
+    }
+
+    void* AllocLocked(unsigned int size, unsigned int type) {
+        Header* h = nullptr;
+        if (size <= SMALL_MAX) {
+            int c = ClassFor(std::max(size, 1u));
+            if (!m_smallFree[c]) RefillClass(c);
+            FreeSlot* s = m_smallFree[c];
+            if (s) {
+                m_smallFree[c] = s->next;
+                --m_smallFreeCount[c];
+                h = (Header*)s;
+                h->sizeClass = (unsigned char)c;
+                h->blockBytes = 0;
+            }
+        }
+        else {
+            size_t bytes = LargeBlockBytes(size);
+            char* p = TakeArena(bytes);
+            if (p) {
+                h = (Header*)p;
+                h->sizeClass = LARGE_CLASS;
+                h->blockBytes = (unsigned int)bytes;
+            }
+        }
+        if (!h) {
+            ++m_stats.failCount;
+            return nullptr;
+        }
+        h->size = size;
+        h->flags = (type & FMOD_MEMORY_SAMPLEDATA) ? HF_SAMPLE_DATA : 0;
+        h->tag = CurrentTag();
+        h->magic = HEADER_MAGIC;
+        ++m_stats.allocCount;
+        Account(h, +1);
+        return h + 1;
+    }
+
+    void RefillClass(int c) {
+        char* page = TakeArena(SMALL_PAGE_BYTES);
+        if (!page) return;
+        size_t slot = sizeof(Header) + ClassSize(c);
+        for (size_t off = 0; off + slot <= SMALL_PAGE_BYTES; off += slot) {
+            FreeSlot* s = (FreeSlot*)(page + off);
+            s->next = m_smallFree[c];
+            m_smallFree[c] = s;
+            ++m_smallFreeCount[c];
+        }
+    }
+
+    // no  nosso (ou double free): no toca no bloco, mas conta e regista os primeiros
+    bool CheckMagic(const Header* h, const char* op) {
+        if (h->magic == HEADER_MAGIC) return true;
+        if (++m_stats.badFrees <= BAD_FREE_LOG_LIMIT)
+            WriteLog("FmodArenaAllocator: %s of %p without a valid header (magic=%04x), ignored", op, (const void*)(h + 1), h->magic);
+        return false;
+    }
+
+    void FreeLocked(Header* h) {
+        if (!CheckMagic(h, "Free")) return;
+        Account(h, -1);
+        h->magic = 0;
+        if (h->sizeClass == LARGE_CLASS) {
+            InsertFree((char*)h, h->blockBytes);
+            return;
+        }
+        int c = h->sizeClass;
+        FreeSlot* s = (FreeSlot*)h;
+        s->next = m_smallFree[c];
+        m_smallFree[c] = s;
+        ++m_smallFreeCount[c];
+    }
+
+    std::mutex m_lock;
+    bool m_fixedPool = false;
+    std::vector<std::pair<char*, size_t>> m_regions;
+    std::map<char*, size_t> m_arenaFree;  // por endereo, para coalescer vizinhos
+    FreeSlot* m_smallFree[SMALL_CLASS_COUNT] = {};
+    unsigned int m_smallFreeCount[SMALL_CLASS_COUNT] = {};
+    std::map<int, long long> m_tagBytes;
+    Stats m_stats;
+};
+
+static FmodArenaAllocator g_fmodAllocator;
+static bool g_fmodMemoryInstalled = false;
+
+static void* FMOD_F_CALLBACK FmodAlloc(unsigned int size, FMOD_MEMORY_TYPE type, const char*) {
+    return g_fmodAllocator.Alloc(size, type);
+}
+static void* FMOD_F_CALLBACK FmodRealloc(void* ptr, unsigned int size, FMOD_MEMORY_TYPE type, const char*) {
+    return g_fmodAllocator.Realloc(ptr, size, type);
+}
+static void FMOD_F_CALLBACK FmodFree(void* ptr, FMOD_MEMORY_TYPE, const char*) {
+    g_fmodAllocator.Free(ptr);
+}
+
+// atribui as alocaes deste thread a um banco enquanto o objeto vive
+struct FmodMemoryTag {
+    int previous;
+    explicit FmodMemoryTag(int tag) : previous(FmodArenaAllocator::CurrentTag()) { FmodArenaAllocator::CurrentTag() = tag; }
+    ~FmodMemoryTag() { FmodArenaAllocator::CurrentTag() = previous; }
+};
+
+// tem de correr antes de qualquer System_Create (FMODMemory=0 deixa o heap do CRT)
+static void InstallFMODMemory() {
+    if (g_fmodMemoryInstalled || GetConfig("FMODMemory", 1.0f) == 0.0f) return;
+    size_t poolBytes = (size_t)std::max(0.0f, GetConfig("FMODMemoryPoolMB", 0.0f)) * 1024 * 1024;
+    g_fmodAllocator.Init(poolBytes);
+    FMOD_RESULT r = FMOD::Memory_Initialize(nullptr, 0, FmodAlloc, FmodRealloc, FmodFree, FMOD_MEMORY_ALL);
+    g_fmodMemoryInstalled = (r == FMOD_OK);
+    WriteLog("InstallFMODMemory: r=%d pool=%s", (int)r, poolBytes ? (std::to_string(poolBytes >> 20) + " MB").c_str() : "grow on demand");
+}
+
+static void LogFMODMemory(const char* when) {
+    if (!g_fmodMemoryInstalled) return;
+    int fmodCurrent = 0, fmodMax = 0;
+    try { FMOD::Memory_GetStats(&fmodCurrent, &fmodMax, false); }
+    catch (...) {}
+    FmodArenaAllocator::Stats s = g_fmodAllocator.GetStats();
+    double frag = (s.arenaFreeBytes > 0) ? 1.0 - double(s.arenaLargestFree) / double(s.arenaFreeBytes) : 0.0;
+    WriteLog("FMOD memory (%s): fmod cur=%d KB max=%d KB | alloc cur=%lld KB peak=%lld KB samples=%lld KB reserved=%lld KB free=%lld KB (small %lld KB) frag=%.2f fails=%llu badFrees=%llu",
+        when, fmodCurrent >> 10, fmodMax >> 10, s.currentBytes >> 10, s.peakBytes >> 10, s.sampleBytes >> 10,
+        s.reservedBytes >> 10, s.arenaFreeBytes >> 10, s.smallFreeBytes >> 10, frag, s.failCount, s.badFrees);
+    for (auto& kv : g_fmodAllocator.TagSnapshot()) {
+        if (kv.second > 0) WriteLog("FMOD memory (%s): bank model=%d %lld KB", when, kv.first, kv.second >> 10);
+    }
 }
 
 // --- globals para o logo FMOD ---
@@ -179,8 +621,9 @@ static RwTexture* g_logoTex = nullptr;
 static bool g_fmodLogoLoaded = false;
 
 // ---------------- globals ----------------
-static FMOD::System* g_fmodCore = nullptr;
-static std::mutex g_mutex;
+static std::atomic<FMOD::System*> g_fmodCore{ nullptr };  // escrito pelo thread de init, lido via GetCoreSystem()
+static std::atomic<bool> g_fmodReady{ false };  // g_fmodCore publicado pelo thread de init
+static std::thread g_fmodInitThread;
 static std::string g_basePath = PLUGIN_PATH("vsfx");
 static bool g_gamePaused = false; // estado local de pausa
 
@@ -193,10 +636,293 @@ static const char* s_names[] = {
     "backfire.wav"
 };
 
-struct WavBank { std::map<std::string, FMOD::Sound*> sounds; };
+// ndices em s_names (mesma ordem)
+enum SoundSlot { SND_IDLE = 0, SND_ENGINE, SND_WIND, SND_SHIFTUP, SND_SHIFTDN, SND_BACKFIRE, SND_COUNT };
+
+// curvas de resposta pitch/volume amostradas sobre ratio = speed/gearMax (0..1)
+static const int RESPONSE_LUT_SIZE = 33;
+enum ResponseMode { RM_ACCEL = 0, RM_DECEL = 1, RM_COUNT };
+
+struct ResponseTable {
+    float pitch[RM_COUNT][RESPONSE_LUT_SIZE];
+    float volume[RM_COUNT][RESPONSE_LUT_SIZE];
+};
+
+// interpolao linear na tabela; ratio fora de 0..1  saturado
+static inline float SampleResponse(const float* lut, float ratio) {
+    float x = std::clamp(ratio, 0.0f, 1.0f) * float(RESPONSE_LUT_SIZE - 1);
+    int i = std::min((int)x, RESPONSE_LUT_SIZE - 2);
+    float f = x - float(i);
+    return lut[i] + (lut[i + 1] - lut[i]) * f;
+}
+
+// perfil de transmisso por modelo: a tabela de marchas  fixa por handling,
+// ento lemos uma vez ao anexar o banco em vez de a cada frame
+struct TransmissionProfile {
+    bool valid = false;
+    uintptr_t handlingPtr = 0;        // tHandlingData* de onde o perfil foi lido
+    unsigned int fingerprint = 0;     // hash da tabela de marchas (detecta reload do handling)
+    unsigned int lastValidateMs = 0;
+    int gearCount = 1;
+
+    // por marcha (ndice 1..gearCount)
+    float gearMaxVelocity[MAX_TRANSMISSION_GEARS + 1] = {};
+    float startPitch[MAX_TRANSMISSION_GEARS + 1] = {};
+    float pitchSpan[MAX_TRANSMISSION_GEARS + 1] = {};   // (TARGET_PITCH - start) * gearScale
+    float shiftDrop[MAX_TRANSMISSION_GEARS + 1] = {};   // drop transiente ao entrar na marcha
+
+    // curvas pr-calculadas por marcha/modo (refeitas quando o ini muda)
+    unsigned int configGeneration = 0;
+    ResponseTable response[MAX_TRANSMISSION_GEARS + 1];
+};
+
+// medidas de nvel de um som (analisadas no load, guardadas no vsfx.meta do banco)
+struct SoundMetrics {
+    unsigned long long sourceHash = 0;
+    float lengthMs = 0.0f;
+    float rmsDb = -120.0f;
+    float peakDb = -120.0f;
+    float loudness = -70.0f;   // integrado com gate  la BS.1770 (sem filtro K)
+    float seamRatio = 0.0f;    // salto na emenda do loop / diferena mdia entre samples
+};
+
+struct WavBank {
+    std::map<std::string, FMOD::Sound*> sounds;
+    FMOD::Sound* slots[SND_COUNT] = {};
+    unsigned int soundMask = 0;       // bit por SoundSlot presente (consultado sem tocar no map)
+    TransmissionProfile transmission;
+    SoundMetrics metrics[SND_COUNT];
+    float gain[SND_COUNT] = { 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f }; // normalizao de loudness
+
+    bool Has(SoundSlot slot) const { return (soundMask & (1u << slot)) != 0; }
+};
 
 enum LoopMode { LM_NONE = 0, LM_IDLE, LM_GEAR };
 
+// de onde (e de quem) o som sai nesta frame; lido do jogo ou de um trace
+struct AudioEmitter {
+    int modelIndex = -1;
+    FMOD_VECTOR pos = { 0.0f, 0.0f, 0.0f };
+    FMOD_VECTOR vel = { 0.0f, 0.0f, 0.0f };
+};
+
+// ---------------- timer wheel ----------------
+// Prazos em ms de jogo numa roda hierrquica de 4 nveis x 64 slots (1 ms, 64 ms, ~4 s e
+// ~4.4 min por slot, at ~4.6 h  frente). Agendar e cancelar so O(1); Advance s visita
+// os slots ocupados do nvel 0 (bitmap) e desce um slot dos nveis de cima quando o de
+// baixo d a volta. Cada prazo dispara uma vez, no tick exato do deadline, com o callback
+// a receber esse tick. S no thread do jogo.
+class TimerWheel {
+public:
+    typedef void (*Callback)(void* ctx, uint32_t arg, uint32_t nowMs);
+    static const int LEVELS = 4;
+    static const int SLOT_BITS = 6;
+    static const int SLOTS = 1 << SLOT_BITS;
+    static const uint32_t MAX_DELAY_MS = (1u << (SLOT_BITS * LEVELS)) - 1;
+
+    TimerWheel() { Clear(); }
+
+    // devolve um handle != 0; prazo j vencido dispara no prximo Advance
+    uint32_t Schedule(uint32_t nowMs, uint32_t delayMs, Callback fn, void* ctx, uint32_t arg) {
+        if (!pending_) now_ = nowMs;  // roda vazia: alinha ao relgio (load de jogo, trace)
+        uint32_t index;
+        if (!free_.empty()) { index = free_.back(); free_.pop_back(); }
+        else { index = (uint32_t)nodes_.size(); nodes_.emplace_back(); }
+        Node& n = nodes_[index];
+        n.deadline = nowMs + delayMs;
+        n.fn = fn;
+        n.ctx = ctx;
+        n.arg = arg;
+        n.gen = (n.gen + 1) & GEN_MASK;
+        n.armed = true;
+        Link(index, 1);
+        ++pending_;
+        ++scheduled_;
+        return (n.gen << INDEX_BITS) | (index + 1);
+    }
+
+    // false se o handle j disparou ou foi cancelado
+    bool Cancel(uint32_t handle) {
+        uint32_t index = (handle & INDEX_MASK) - 1;
+        if (!handle || index >= nodes_.size()) return false;
+        Node& n = nodes_[index];
+        if (!n.armed || n.gen != (handle >> INDEX_BITS)) return false;
+        if (n.level != DETACHED) Unlink(index);
+        Release(index);
+        return true;
+    }
+
+    void Advance(uint32_t nowMs) {
+        if (!pending_) { now_ = nowMs; return; }
+        uint32_t delta = nowMs - now_;
+        // relgio voltou atrs ou saltou mais do que a roda cobre (novo jogo, load): vence tudo
+        if ((int32_t)delta < 0 || delta > MAX_DELAY_MS) { ExpireAll(nowMs); return; }
+        while (now_ != nowMs && pending_) {
+            uint32_t idx = now_ & (SLOTS - 1);
+            // salta direto para o prximo slot ocupado do nvel 0 ou para a volta (cascata)
+            uint64_t ahead = (idx == SLOTS - 1) ? 0 : occupied_[0] & (~0ull << (idx + 1));
+            uint32_t step = ahead ? (uint32_t)std::countr_zero(ahead) - idx : SLOTS - idx;
+            now_ += std::min(step, nowMs - now_);
+            if ((now_ & (SLOTS - 1)) == 0) Cascade();
+            Expire(now_ & (SLOTS - 1));
+        }
+        now_ = nowMs;
+    }
+
+    // descarta tudo sem chamar callbacks (shutdown)
+    void Clear() {
+        nodes_.clear();
+        free_.clear();
+        for (auto& level : heads_) std::fill(std::begin(level), std::end(level), -1);
+        std::fill(std::begin(occupied_), std::end(occupied_), 0ull);
+        pending_ = 0;
+    }
+
+    size_t Pending() const { return pending_; }
+    unsigned long long Scheduled() const { return scheduled_; }
+    unsigned long long Fired() const { return fired_; }
+
+private:
+    static const uint32_t INDEX_BITS = 20;
+    static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+    static const uint32_t GEN_MASK = (1u << (32 - INDEX_BITS)) - 1;
+    static const uint8_t DETACHED = 0xFF;  // fora das listas (a meio do ExpireAll)
+
+    struct Node {
+        uint32_t deadline = 0;
+        Callback fn = nullptr;
+        void* ctx = nullptr;
+        uint32_t arg = 0;
+        int32_t prev = -1, next = -1;
+        uint32_t gen = 0;
+        uint8_t level = 0, slot = 0;
+        bool armed = false;
+    };
+
+    // minDelay 1 ao agendar (o tick atual j foi processado); 0 na cascata, que corre
+    // antes de expirar o slot do tick atual
+    void Link(uint32_t index, uint32_t minDelay) {
+        Node& n = nodes_[index];
+        int32_t delta = (int32_t)(n.deadline - now_);
+        uint32_t d = std::clamp<int64_t>(delta, minDelay, MAX_DELAY_MS);
+        uint32_t when = now_ + d;
+        int level = 0;
+        while (level < LEVELS - 1 && d >= (1u << (SLOT_BITS * (level + 1)))) ++level;
+        int slot = (when >> (SLOT_BITS * level)) & (SLOTS - 1);
+        n.level = (uint8_t)level;
+        n.slot = (uint8_t)slot;
+        n.prev = -1;
+        n.next = heads_[level][slot];
+        if (n.next >= 0) nodes_[n.next].prev = (int32_t)index;
+        heads_[level][slot] = (int32_t)index;
+        occupied_[level] |= 1ull << slot;
+    }
+
+    void Unlink(uint32_t index) {
+        Node& n = nodes_[index];
+        if (n.prev >= 0) nodes_[n.prev].next = n.next;
+        else heads_[n.level][n.slot] = n.next;
+        if (n.next >= 0) nodes_[n.next].prev = n.prev;
+        if (heads_[n.level][n.slot] < 0) occupied_[n.level] &= ~(1ull << n.slot);
+    }
+
+    void Release(uint32_t index) {
+        nodes_[index].armed = false;
+        free_.push_back(index);
+        --pending_;
+    }
+
+    // o nvel 0 deu a volta: redistribui o slot corrente do nvel 1 (e acima, em cadeia)
+    void Cascade() {
+        for (int level = 1; level < LEVELS; ++level) {
+            int slot = (now_ >> (SLOT_BITS * level)) & (SLOTS - 1);
+            int32_t i = heads_[level][slot];
+            heads_[level][slot] = -1;
+            occupied_[level] &= ~(1ull << slot);
+            while (i >= 0) {
+                int32_t next = nodes_[i].next;
+                Link((uint32_t)i, 0);
+                i = next;
+            }
+            if (slot != 0) break;
+        }
+    }
+
+    void Fire(uint32_t index, uint32_t nowMs) {
+        Node& n = nodes_[index];
+        Callback fn = n.fn;  // o callback pode agendar (e realocar nodes_)
+        void* ctx = n.ctx;
+        uint32_t arg = n.arg;
+        Release(index);
+        ++fired_;
+        fn(ctx, arg, nowMs);
+    }
+
+    void Expire(uint32_t slot) {
+        while (heads_[0][slot] >= 0) {
+            uint32_t index = (uint32_t)heads_[0][slot];
+            Unlink(index);
+            Fire(index, now_);
+        }
+    }
+
+    void ExpireAll(uint32_t nowMs) {
+        std::vector<uint32_t> due;
+        for (int level = 0; level < LEVELS; ++level) {
+            for (int slot = 0; slot < SLOTS; ++slot) {
+                for (int32_t i = heads_[level][slot]; i >= 0; i = nodes_[i].next) {
+                    nodes_[i].level = DETACHED;
+                    due.push_back((uint32_t)i);
+                }
+                heads_[level][slot] = -1;
+            }
+            occupied_[level] = 0;
+        }
+        now_ = nowMs;
+        // um callback pode cancelar outro prazo da lista: esse fica desarmado e  saltado
+        for (uint32_t index : due) if (nodes_[index].armed) Fire(index, nowMs);
+    }
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> free_;
+    int32_t heads_[LEVELS][SLOTS];
+    uint64_t occupied_[LEVELS] = {};
+    uint32_t now_ = 0;
+    size_t pending_ = 0;
+    unsigned long long scheduled_ = 0;
+    unsigned long long fired_ = 0;
+};
+
+// transientes por instncia com prazo na roda; o bit em timersActive fica ligado enquanto
+// o prazo corre, por isso quem no tem nada pendente no paga nada por frame
+enum InstanceTimer {
+    IT_SHIFT_DROP = 0,     // decay do drop de pitch da troca de marcha
+    IT_WIND_FADE,          // fade-in do wind
+    IT_RELEASE_HOLD,       // mantm o loop de marcha um pouco depois de soltar o acelerador
+    IT_RELEASE_SIGNAL,     // janela em que sincerelease das overlay rules  medido
+    IT_COOLDOWN_SHIFTUP,   // cooldowns dos overlays one-shot (mesma ordem dos SoundSlot)
+    IT_COOLDOWN_SHIFTDN,
+    IT_COOLDOWN_BACKFIRE,
+    IT_SETTLE,             // instncia quieta h DormantAfterMs: adormece no fim da frame
+    IT_COUNT
+};
+static_assert(SND_SHIFTDN == SND_SHIFTUP + 1 && SND_BACKFIRE == SND_SHIFTUP + 2, "cooldown timers follow the one-shot slots");
+
+static inline InstanceTimer CooldownTimer(SoundSlot slot) {
+    return (InstanceTimer)(IT_COOLDOWN_SHIFTUP + (slot - SND_SHIFTUP));
+}
+
+// ocluso cmara -> veculo (ver seco occlusion)
+struct OcclusionState {
+    float credit = 0.0f;          // audibilidade acumulada desde o ltimo raio
+    float target = 0.0f;          // 0 = linha de vista livre, 1 = bloqueado (cache)
+    float current = 0.0f;         // suavizado, o que vai para o FMOD
+    float applied = -1.0f;        // ltimo valor enviado
+    unsigned int checkedMs = 0;
+    bool valid = false;           // j teve pelo menos um raio
+    FMOD::Channel* appliedTo[4] = {};  // canais que j receberam 'applied'
+};
+
 struct VehicleAudioInstance {
     CVehicle* vehicle = nullptr;
 
@@ -218,12 +944,21 @@ struct VehicleAudioInstance {
 
     // estado / meta
     int lastGear = INT_MIN;
+
+    // medio de latncia mudana de marcha -> shiftup (ver hooks de ProcessControl)
+    unsigned int physicsFrame = 0;       // ltima frame atualizada a partir do hook de fsica
+    int physicsGear = -1;                // m_nCurrentGear visto logo aps a fsica
+    bool gearChangePending = false;
+    unsigned int gearChangeFrame = 0;
+    std::chrono::steady_clock::time_point gearChangeTime;
     int pendingGear = -1;
     bool inShift = false;
-    unsigned int attackEndTimeMs = 0;
 
     // meta dados de controlo/volume/pitch
-    float lastSpeed = 0.0f;
+    float lastSpeed = 0.0f;         // velocidade filtrada da frame anterior
+    float filteredSpeed = 0.0f;
+    bool signalsPrimed = false;     // primeira frame: filtro parte da velocidade atual
+    bool wheelspinActive = false;
     float currentPitch = 1.0f;
     float currentVolume = 0.0f;
 
@@ -237,28 +972,276 @@ struct VehicleAudioInstance {
     EngineMode engineMode = EM_NONE;
     float desiredEnginePitch = 1.0f; // alvo atual (acelerao / desacelerao)
 
-    // transient shift drop (negativo = engrossa), decai com o tempo
+    // transient shift drop (negativo = engrossa), decai at IT_SHIFT_DROP vencer
     float shiftPitchDrop = 0.0f;
     unsigned int shiftStartMs = 0;
 
     // membros extras usados no cdigo
     LoopMode loopMode = LM_NONE;
     bool wasAccelerating = false;
-    unsigned int lastAccelReleaseMs = 0;
-    unsigned int lastShiftUpMs = 0;
-    unsigned int lastShiftDnMs = 0;
-    unsigned int lastBackfireMs = 0;
+    unsigned int lastAccelReleaseMs = 0;   // vlido enquanto IT_RELEASE_SIGNAL corre
+    uint32_t rngState = 0;                 // stream xorshift32 prpria (0 = ainda por semear)
 
-    // timestamp de quando o wind foi (re)criado / iniciado para fazer fade-in
+    // incio do fade-in do wind (progresso enquanto IT_WIND_FADE corre)
     unsigned int windStartMs = 0;
+
+    // prazos pendentes na roda (ver timer wheel): bit por InstanceTimer + handle para cancelar
+    unsigned int timersActive = 0;
+    uint32_t timerHandle[IT_COUNT] = {};
+
+    // dormncia (ver dormant instances): fora da lista de update at acordar
+    bool dormant = false;
+    bool dormantReleased = false;  // canais libertados ao adormecer
+    bool dormantValid = true;      // IsVehicleValidForAudio ao adormecer
+    int dormantGear = 0;
+    bool sleepPending = false;     // IT_SETTLE venceu; adormece se continuar quieta
+
+    OcclusionState occlusion;
+    bool ambient = false;  // criada pelo AudibleVehicles (no  o carro do jogador)
+};
+
+// ---------------- epoch reclamation ----------------
+// Leitores entram num EpochGuard (sem locks) antes de seguir ponteiros publicados;
+// quem desliga um objeto chama Retire e ele s  libertado quando nenhum leitor que
+// entrou antes dessa poca continua ativo (Collect).
+class EpochReclaimer {
+public:
+    static const int MAX_THREADS = 32;
+
+    class Guard {
+    public:
+        explicit Guard(EpochReclaimer& r) : r_(r) { r_.Enter(); }
+        ~Guard() { r_.Exit(); }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+    private:
+        EpochReclaimer& r_;
+    };
+
+    ~EpochReclaimer() { Drain(); }
+
+    void Retire(void* p, void (*deleter)(void*)) {
+        if (!p) return;
+        std::lock_guard<std::mutex> lk(retireMutex_);
+        retired_.push_back({ p, deleter, global_.load(std::memory_order_seq_cst) });
+    }
+
+    // avana a poca e liberta o que j no pode estar a ser lido; devolve quantos
+    size_t Collect() {
+        global_.fetch_add(1, std::memory_order_seq_cst);
+        unsigned long long minActive = ~0ull;
+        for (const Participant& p : parts_) {
+            unsigned long long e = p.epoch.load(std::memory_order_seq_cst);
+            if (e) minActive = std::min(minActive, e);
+        }
+        if (overflowReaders_.load(std::memory_order_seq_cst) > 0) return 0;
+        std::vector<Retired> ready;
+        {
+            std::lock_guard<std::mutex> lk(retireMutex_);
+            auto keep = std::partition(retired_.begin(), retired_.end(), [minActive](const Retired& r) { return r.epoch >= minActive; });
+            ready.assign(keep, retired_.end());
+            retired_.erase(keep, retired_.end());
+        }
+        for (Retired& r : ready) r.deleter(r.p);
+        return ready.size();
+    }
+
+    // s com todos os leitores parados (shutdown)
+    void Drain() {
+        std::vector<Retired> all;
+        {
+            std::lock_guard<std::mutex> lk(retireMutex_);
+            all.swap(retired_);
+        }
+        for (Retired& r : all) r.deleter(r.p);
+    }
+
+    size_t Pending() {
+        std::lock_guard<std::mutex> lk(retireMutex_);
+        return retired_.size();
+    }
+
+private:
+    struct alignas(64) Participant {
+        std::atomic<unsigned long long> epoch{ 0 };  // 0 = fora de guard
+        std::atomic<bool> used{ false };
+    };
+    struct Retired {
+        void* p;
+        void (*deleter)(void*);
+        unsigned long long epoch;
+    };
+    // registo por thread (e por reclaimer); guards aninhados s contam o primeiro
+    struct ThreadState {
+        EpochReclaimer* owner = nullptr;
+        int index = -1;
+        int depth = 0;
+        ~ThreadState() { if (owner && index >= 0) owner->parts_[index].used.store(false, std::memory_order_release); }
+    };
+
+    ThreadState& State() {
+        static thread_local ThreadState states[4];
+        for (ThreadState& s : states) if (s.owner == this) return s;
+        for (ThreadState& s : states) {
+            if (s.owner) continue;
+            s.owner = this;
+            for (int i = 0; i < MAX_THREADS; ++i) {
+                bool expected = false;
+                if (parts_[i].used.compare_exchange_strong(expected, true)) { s.index = i; break; }
+            }
+            return s;
+        }
+        static thread_local ThreadState overflow;
+        return overflow;
+    }
+
+    void Enter() {
+        ThreadState& s = State();
+        if (s.depth++ > 0) return;
+        if (s.index < 0) { overflowReaders_.fetch_add(1, std::memory_order_seq_cst); return; }
+        parts_[s.index].epoch.store(global_.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+    }
+
+    void Exit() {
+        ThreadState& s = State();
+        if (--s.depth > 0) return;
+        if (s.index < 0) { overflowReaders_.fetch_sub(1, std::memory_order_seq_cst); return; }
+        parts_[s.index].epoch.store(0, std::memory_order_release);
+    }
+
+    Participant parts_[MAX_THREADS];
+    std::atomic<unsigned long long> global_{ 1 };
+    std::atomic<int> overflowReaders_{ 0 };  // threads sem slot: bloqueiam a recolha enquanto lem
+    std::mutex retireMutex_;                 // s quem retira/recolhe; leitores nunca o tocam
+    std::vector<Retired> retired_;
+};
+
+// ---------------- bank registry ----------------
+// Tabela plana de endereamento aberto (sondagem linear) por ID de modelo, s de leitura
+// no caminho quente: procurar um banco so loads atmicos, sem locks. Chaves entram por
+// CAS e nunca saem (o estado volta a BANK_ABSENT); o banco  publicado com release e
+// substitudo/removido com Retire no g_bankEpochs.
+enum BankState : int { BANK_ABSENT = 0, BANK_LOADING, BANK_READY, BANK_MISSING };
+
+class BankRegistry {
+public:
+    static const int CAPACITY = 4096;  // potncia de 2; IDs do SA (e de mods) cabem com folga
+
+    struct Slot {
+        std::atomic<int> key{ -1 };
+        std::atomic<int> state{ BANK_ABSENT };
+        std::atomic<WavBank*> bank{ nullptr };
+        std::atomic<unsigned int> prefetchedAtMs{ 0 };  // != 0: veio de prefetch e ainda no foi usado
+        std::atomic<bool> waitedOn{ false };            // algum pediu enquanto carregava
+    };
+
+    BankRegistry() : slots_(new Slot[CAPACITY]) {}
+
+    Slot* Find(int modelId) const {
+        for (unsigned int i = 0, h = Hash(modelId); i < (unsigned int)CAPACITY; ++i, h = (h + 1) & (CAPACITY - 1)) {
+            int k = slots_[h].key.load(std::memory_order_acquire);
+            if (k == modelId) return &slots_[h];
+            if (k == -1) return nullptr;
+        }
+        return nullptr;
+    }
+
+    // nullptr s com a tabela cheia
+    Slot* FindOrInsert(int modelId) {
+        for (unsigned int i = 0, h = Hash(modelId); i < (unsigned int)CAPACITY; ++i, h = (h + 1) & (CAPACITY - 1)) {
+            int k = slots_[h].key.load(std::memory_order_acquire);
+            if (k == -1 && slots_[h].key.compare_exchange_strong(k, modelId, std::memory_order_acq_rel)) return &slots_[h];
+            if (k == modelId) return &slots_[h];
+        }
+        return nullptr;
+    }
+
+    WavBank* Get(int modelId) const {
+        Slot* s = Find(modelId);
+        return (s && s->state.load(std::memory_order_acquire) == BANK_READY) ? s->bank.load(std::memory_order_acquire) : nullptr;
+    }
+
+    template<class F> void ForEach(F f) const {
+        for (int i = 0; i < CAPACITY; ++i) if (slots_[i].key.load(std::memory_order_acquire) != -1) f(slots_[i]);
+    }
+
+private:
+    static unsigned int Hash(int modelId) { return ((unsigned int)modelId * 2654435761u) & (CAPACITY - 1); }
+    std::unique_ptr<Slot[]> slots_;
 };
 
+static EpochReclaimer g_bankEpochs;
+static BankRegistry g_modelBanks;
+
+// libertao diferida: s a struct (os sons podem continuar noutro WavBank)
+static void DeleteBankStruct(void* p) { delete static_cast<WavBank*>(p); }
+
 // caches
-static std::map<int, WavBank*> g_modelBanks;
-static std::map<CVehicle*, VehicleAudioInstance> g_vehicleInstances;
+static std::map<CVehicle*, VehicleAudioInstance> g_vehicleInstances;  // s no thread do jogo
 
 // ---------------- FMOD helpers ----------------
-static FMOD::System* GetCoreSystem() { return g_fmodCore; }
+static FMOD::System* GetCoreSystem() { return g_fmodCore.load(std::memory_order_acquire); }
+
+// perfil de sada do FMOD (ini); 0 = deixa o default do FMOD
+struct OutputProfile {
+    unsigned int dspBufferLength = 0;  // samples por bloco de mix
+    int dspBufferCount = 0;            // blocos em fila no dispositivo
+    int sampleRate = 0;
+    int maxChannels = 512;             // canais virtuais (System::init)
+    int softwareChannels = 0;          // canais realmente mixados
+    int resampler = 0;                 // FMOD_DSP_RESAMPLER: 1 nointerp, 2 linear, 3 cubic, 4 spline
+};
+
+static OutputProfile LoadOutputProfile() {
+    OutputProfile p;
+    p.dspBufferLength = (unsigned int)GetConfig("DSPBufferLength", 0.0f);
+    p.dspBufferCount = (int)GetConfig("DSPBufferCount", 0.0f);
+    p.sampleRate = (int)GetConfig("OutputSampleRate", 0.0f);
+    p.maxChannels = std::max(1, (int)GetConfig("MaxChannels", 512.0f));
+    p.softwareChannels = (int)GetConfig("SoftwareChannels", 0.0f);
+    p.resampler = std::clamp((int)GetConfig("ResamplerMethod", 0.0f), 0, (int)FMOD_DSP_RESAMPLER_SPLINE);
+    return p;
+}
+
+// tem de ser chamado antes de System::init
+static void ApplyOutputProfile(FMOD::System* system, const OutputProfile& p) {
+    if (!system) return;
+    try {
+        if (p.dspBufferLength > 0 || p.dspBufferCount > 0) {
+            unsigned int length = 1024;
+            int count = 4;
+            system->getDSPBufferSize(&length, &count);
+            FMOD_RESULT r = system->setDSPBufferSize(p.dspBufferLength > 0 ? p.dspBufferLength : length, p.dspBufferCount > 0 ? p.dspBufferCount : count);
+            if (r != FMOD_OK) WriteLog("ApplyOutputProfile: setDSPBufferSize(%u, %d) failed r=%d", p.dspBufferLength, p.dspBufferCount, (int)r);
+        }
+        if (p.sampleRate > 0) {
+            FMOD_RESULT r = system->setSoftwareFormat(p.sampleRate, FMOD_SPEAKERMODE_DEFAULT, 0);
+            if (r != FMOD_OK) WriteLog("ApplyOutputProfile: setSoftwareFormat(%d) failed r=%d", p.sampleRate, (int)r);
+        }
+        if (p.softwareChannels > 0) system->setSoftwareChannels(p.softwareChannels);
+        if (p.resampler > 0) {
+            FMOD_ADVANCEDSETTINGS adv = {};
+            adv.cbSize = sizeof(adv);
+            adv.resamplerMethod = (FMOD_DSP_RESAMPLER)p.resampler;
+            system->setAdvancedSettings(&adv);
+        }
+    }
+    catch (...) {}
+}
+
+// latncia de sada = blocos em fila * tamanho do bloco / taxa
+static double OutputLatencyMs(FMOD::System* system, unsigned int* lengthOut = nullptr, int* countOut = nullptr, int* rateOut = nullptr) {
+    unsigned int length = 0;
+    int count = 0, rate = 0, speakers = 0;
+    FMOD_SPEAKERMODE mode = FMOD_SPEAKERMODE_DEFAULT;
+    try { system->getDSPBufferSize(&length, &count); system->getSoftwareFormat(&rate, &mode, &speakers); }
+    catch (...) {}
+    if (lengthOut) *lengthOut = length;
+    if (countOut) *countOut = count;
+    if (rateOut) *rateOut = rate;
+    return (rate > 0) ? 1000.0 * double(length) * double(count) / double(rate) : 0.0;
+}
 
 static FMOD::Sound* LoadWav(FMOD::System* core, const std::string& path, bool loop) {
     if (!core) return nullptr;
@@ -276,86 +1259,882 @@ static FMOD::Sound* LoadWav(FMOD::System* core, const std::string& path, bool lo
     return s;
 }
 
-static WavBank* LoadBankForModel(int modelId) {
-    std::lock_guard<std::mutex> lk(g_mutex);
-    auto it = g_modelBanks.find(modelId);
-    if (it != g_modelBanks.end()) return it->second;
+// ---------------- cpu features ----------------
+static void CpuId(int regs[4], int leaf) {
+#if defined(_MSC_VER)
+    __cpuidex(regs, leaf, 0);
+#else
+    unsigned int a, b, c, d;
+    __cpuid_count(leaf, 0, a, b, c, d);
+    regs[0] = (int)a; regs[1] = (int)b; regs[2] = (int)c; regs[3] = (int)d;
+#endif
+}
 
-    std::string folder = g_basePath + "\\" + std::to_string(modelId);
-    WriteLog("LoadBankForModel: modelId=%d folder=%s", modelId, folder.c_str());
-    if (!fs::exists(folder) || !fs::is_directory(folder)) {
-        WriteLog("LoadBankForModel: folder not found %s", folder.c_str());
-        g_modelBanks[modelId] = nullptr;
-        return nullptr;
+static unsigned long long XGetBV0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+struct CpuFeatures {
+    bool sse2 = false;
+    bool avx2 = false;
+};
+
+// DisableSIMD=1 fora os caminhos escalares em todos os kernels
+static CpuFeatures DetectCpuFeatures() {
+    CpuFeatures f;
+    int regs[4] = {};
+    CpuId(regs, 0);
+    int maxLeaf = regs[0];
+    CpuId(regs, 1);
+    f.sse2 = (regs[3] & (1 << 26)) != 0;
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool avx = (regs[2] & (1 << 28)) != 0;
+    if (maxLeaf >= 7 && osxsave && avx && (XGetBV0() & 0x6) == 0x6) {
+        CpuId(regs, 7);
+        f.avx2 = (regs[1] & (1 << 5)) != 0;
     }
+    if (GetConfig("DisableSIMD", 0.0f) != 0.0f) { f.avx2 = false; f.sse2 = false; }
+    return f;
+}
 
-    FMOD::System* core = GetCoreSystem();
-    if (!core) return nullptr;
+// ---------------- sample preprocessing ----------------
+// Cada wav do banco  convertido uma vez para o formato do mixer (taxa de sada,
+// mono para as camadas 3D, PCM16 ou float) e guardado em vsfx\cache; o nome do
+// arquivo leva o hash da fonte e o formato alvo, ento loads seguintes s abrem o cache.
+// Fontes que no so PCM/float (ADPCM etc.) continuam a ir direto para o FMOD.
+struct PcmData {
+    int rate = 0;
+    int channels = 0;
+    std::vector<float> samples; // intercalado
+    size_t Frames() const { return channels ? samples.size() / (size_t)channels : 0; }
+};
 
-    WavBank* bank = new WavBank();
-    for (const char* name : s_names) {
-        std::string p = folder + "\\" + name;
-        if (!fs::exists(p)) continue;
-        bool loop = (strcmp(name, "idle.wav") == 0) || (strcmp(name, "engine.wav") == 0) || (strcmp(name, "wind.wav") == 0);
-        FMOD::Sound* s = LoadWav(core, p, loop);
-        if (s) {
-            // Se for wind.wav, fora modos 2D+loop para evitar atenuao 3D indesejada
-            if (strcmp(name, "wind.wav") == 0) {
-                try {
-                    s->setMode(static_cast<FMOD_MODE>(FMOD_2D | FMOD_LOOP_NORMAL));
-                    s->setLoopCount(-1);
-                }
-                catch (...) {}
-            }
-            std::string key = name;
-            auto pos = key.rfind('.');
-            if (pos != std::string::npos) key = key.substr(0, pos);
-            bank->sounds[key] = s;
-        }
+struct SampleTarget {
+    int rate = 0;          // 0 = mantm
+    bool mono = false;
+    bool asFloat = false;
+};
+
+static unsigned long long HashBytes(const void* data, size_t n, unsigned long long h = 1469598103934665603ull) {
+    const unsigned char* c = (const unsigned char*)data;
+    for (size_t i = 0; i < n; ++i) { h ^= c[i]; h *= 1099511628211ull; }
+    return h;
+}
+
+static bool ReadFileBytes(const std::string& path, std::vector<char>& out) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f.is_open()) return false;
+    f.seekg(0, std::ios::end);
+    std::streamoff size = f.tellg();
+    f.seekg(0, std::ios::beg);
+    if (size <= 0) return false;
+    out.resize((size_t)size);
+    return (bool)f.read(out.data(), size);
+}
 
+static bool DecodeWav(const std::vector<char>& bytes, PcmData& out) {
+    auto u16 = [&](size_t o) { return (unsigned int)(unsigned char)bytes[o] | ((unsigned int)(unsigned char)bytes[o + 1] << 8); };
+    auto u32 = [&](size_t o) { return u16(o) | (u16(o + 2) << 16); };
+    if (bytes.size() < 12 || std::memcmp(bytes.data(), "RIFF", 4) != 0 || std::memcmp(bytes.data() + 8, "WAVE", 4) != 0) return false;
+
+    unsigned int format = 0, channels = 0, rate = 0, bits = 0;
+    const char* data = nullptr;
+    size_t dataBytes = 0;
+    for (size_t o = 12; o + 8 <= bytes.size();) {
+        unsigned int len = u32(o + 4);
+        size_t body = o + 8;
+        // sem somar: com size_t de 32 bits um len perto de 0xFFFFFFFF dava a volta
+        if (len > bytes.size() - body) len = (unsigned int)(bytes.size() - body);
+        if (std::memcmp(bytes.data() + o, "fmt ", 4) == 0 && len >= 16) {
+            format = u16(body);
+            channels = u16(body + 2);
+            rate = u32(body + 4);
+            bits = u16(body + 14);
+            // WAVE_FORMAT_EXTENSIBLE: o formato real est no incio do subformat GUID
+            if (format == 0xFFFE && len >= 26) format = u16(body + 24);
+        }
+        else if (std::memcmp(bytes.data() + o, "data", 4) == 0) {
+            data = bytes.data() + body;
+            dataBytes = len;
+        }
+        size_t next = body + len + (len & 1);
+        if (next <= o) break;  // chunk corrupto que no avana
+        o = next;
     }
-    g_modelBanks[modelId] = bank;
-    WriteLog("LoadBankForModel: finished modelId=%d sounds=%d", modelId, (int)bank->sounds.size());
-    return bank;
+    bool pcm = (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32));
+    bool ieee = (format == 3 && bits == 32);
+    if (!data || !channels || !rate || (!pcm && !ieee)) return false;
+
+    size_t bytesPerSample = bits / 8;
+    size_t count = dataBytes / bytesPerSample;
+    count -= count % channels;
+    out.rate = (int)rate;
+    out.channels = (int)channels;
+    out.samples.resize(count);
+    const unsigned char* p = (const unsigned char*)data;
+    for (size_t i = 0; i < count; ++i, p += bytesPerSample) {
+        float v;
+        if (ieee) std::memcpy(&v, p, 4);
+        else if (bits == 8) v = (float(p[0]) - 128.0f) / 128.0f;
+        else if (bits == 16) v = float((short)(p[0] | (p[1] << 8))) / 32768.0f;
+        else if (bits == 24) v = float(((int)(p[0] << 8 | p[1] << 16 | p[2] << 24)) >> 8) / 8388608.0f;
+        else v = float((int)(p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24)) / 2147483648.0f;
+        out.samples[i] = v;
+    }
+    return true;
 }
 
-// Se o jogo est pausado, no devemos iniciar novos canais
-static inline bool IsGamePaused() {
-    return CTimer::m_UserPause != 0;
+static void DownmixToMono(PcmData& pcm) {
+    if (pcm.channels <= 1) return;
+    size_t frames = pcm.Frames();
+    float scale = 1.0f / float(pcm.channels);
+    for (size_t f = 0; f < frames; ++f) {
+        float sum = 0.0f;
+        for (int c = 0; c < pcm.channels; ++c) sum += pcm.samples[f * pcm.channels + c];
+        pcm.samples[f] = sum * scale;
+    }
+    pcm.samples.resize(frames);
+    pcm.channels = 1;
 }
 
-static FMOD::Channel* PlayLoop(CVehicle* veh, FMOD::Sound* snd, float initVol, float initPitch) {
-    if (IsGamePaused()) {
-        // no iniciar loops durante pausa
-        return nullptr;
+// Hermite cbico; em loops a interpolao d a volta para o incio no criar clique na emenda
+static void ResamplePcm(PcmData& pcm, int rate, bool loop) {
+    if (rate <= 0 || rate == pcm.rate || pcm.Frames() < 2) return;
+    size_t inFrames = pcm.Frames();
+    size_t outFrames = (size_t)std::max<long long>(1, std::llround(double(inFrames) * rate / pcm.rate));
+    double step = double(inFrames) / double(outFrames);
+    int ch = pcm.channels;
+    std::vector<float> out(outFrames * ch);
+    auto at = [&](long long i, int c) {
+        if (loop) i = ((i % (long long)inFrames) + (long long)inFrames) % (long long)inFrames;
+        else i = std::clamp<long long>(i, 0, (long long)inFrames - 1);
+        return pcm.samples[(size_t)i * ch + c];
+    };
+    for (size_t o = 0; o < outFrames; ++o) {
+        double x = o * step;
+        long long i = (long long)x;
+        float t = float(x - double(i));
+        for (int c = 0; c < ch; ++c) {
+            float y0 = at(i - 1, c), y1 = at(i, c), y2 = at(i + 1, c), y3 = at(i + 2, c);
+            float a = 0.5f * (y3 - y0) + 1.5f * (y1 - y2);
+            float b = y0 - 2.5f * y1 + 2.0f * y2 - 0.5f * y3;
+            float d = 0.5f * (y2 - y0);
+            out[o * ch + c] = ((a * t + b) * t + d) * t + y1;
+        }
     }
-    FMOD::System* core = GetCoreSystem();
-    if (!core || !snd) return nullptr;
-    FMOD::Channel* ch = nullptr;
-    FMOD_RESULT r = core->playSound(snd, nullptr, true, &ch);
-    if (r != FMOD_OK || !ch) { WriteLog("PlayLoop failed r=%d", (int)r); return nullptr; }
-    CVector p = veh->GetPosition();
-    FMOD_VECTOR fv = { p.x, p.y, p.z };
-    FMOD_VECTOR vel = { veh->m_vecMoveSpeed.x, veh->m_vecMoveSpeed.y, veh->m_vecMoveSpeed.z };
-    try { ch->set3DAttributes(&fv, &vel); }
-    catch (...) {}
-    try { ch->set3DMinMaxDistance(1.0f, 300.0f); }
-    catch (...) {}
-    try { ch->setVolume(initVol); }
-    catch (...) {}
-    try { ch->setPitch(initPitch); }
-    catch (...) {}
-    try { ch->setPaused(false); }
-    catch (...) {}
-    return ch;
+    pcm.samples.swap(out);
+    pcm.rate = rate;
 }
 
-static FMOD::Channel* PlayOneShot(CVehicle* veh, FMOD::Sound* snd, float pitch = 1.0f, float volume = 1.0f) {
-    if (IsGamePaused()) {
-        // no iniciar one-shots durante pausa
-        return nullptr;
+static std::vector<char> EncodeWav(const PcmData& pcm, bool asFloat) {
+    unsigned int bits = asFloat ? 32 : 16;
+    unsigned int blockAlign = pcm.channels * bits / 8;
+    unsigned int dataBytes = (unsigned int)pcm.Frames() * blockAlign;
+    std::vector<char> out;
+    out.reserve(44 + dataBytes);
+    auto put16 = [&](unsigned int v) { out.push_back((char)(v & 0xFF)); out.push_back((char)((v >> 8) & 0xFF)); };
+    auto put32 = [&](unsigned int v) { put16(v & 0xFFFF); put16(v >> 16); };
+    out.insert(out.end(), { 'R', 'I', 'F', 'F' }); put32(36 + dataBytes);
+    out.insert(out.end(), { 'W', 'A', 'V', 'E', 'f', 'm', 't', ' ' }); put32(16);
+    put16(asFloat ? 3 : 1); put16(pcm.channels); put32(pcm.rate); put32(pcm.rate * blockAlign); put16(blockAlign); put16(bits);
+    out.insert(out.end(), { 'd', 'a', 't', 'a' }); put32(dataBytes);
+    for (float v : pcm.samples) {
+        if (asFloat) { unsigned int u; std::memcpy(&u, &v, 4); put32(u); }
+        else put16((unsigned int)(unsigned short)(short)std::lround(std::clamp(v, -1.0f, 1.0f) * 32767.0f));
     }
-    FMOD::System* core = GetCoreSystem();
+    return out;
+}
+
+static bool ConvertWav(const std::vector<char>& source, const SampleTarget& target, bool loop, std::vector<char>& out) {
+    PcmData pcm;
+    if (!DecodeWav(source, pcm)) return false;
+    if (target.mono) DownmixToMono(pcm);
+    ResamplePcm(pcm, target.rate, loop);
+    out = EncodeWav(pcm, target.asFloat);
+    return true;
+}
+
+// formato alvo a partir do mixer (chamado com o FMOD j iniciado)
+static SampleTarget MixerSampleTarget(FMOD::System* core, bool mono) {
+    SampleTarget t;
+    int speakers = 0;
+    FMOD_SPEAKERMODE mode = FMOD_SPEAKERMODE_DEFAULT;
+    try { if (core) core->getSoftwareFormat(&t.rate, &mode, &speakers); }
+    catch (...) {}
+    t.mono = mono;
+    t.asFloat = ToLower(GetConfigText("PreprocessFormat", "pcm16")) == "float";
+    return t;
+}
+
+// um WAV do cache s vale se o RIFF declarar exatamente o tamanho do arquivo
+// (um jogo fechado a meio da escrita deixava um arquivo truncado)
+static bool CachedWavIsComplete(const std::string& path) {
+    std::ifstream f(path, std::ios::binary | std::ios::ate);
+    if (!f.is_open()) return false;
+    std::streamoff fileSize = f.tellg();
+    char riff[12] = {};
+    f.seekg(0);
+    if (fileSize < 44 || !f.read(riff, sizeof(riff))) return false;
+    unsigned int riffSize = 0;
+    std::memcpy(&riffSize, riff + 4, 4);
+    return std::memcmp(riff, "RIFF", 4) == 0 && std::memcmp(riff + 8, "WAVE", 4) == 0 && (std::streamoff)riffSize + 8 == fileSize;
+}
+
+// devolve o caminho a dar ao FMOD: o cache convertido, ou a fonte se no der para converter
+static std::string PreprocessSample(const std::string& path, const std::vector<char>& source, unsigned long long sourceHash, const SampleTarget& target, bool loop) {
+    if (source.empty()) return path;
+    char name[96];
+    snprintf(name, sizeof(name), "%016llx_%d_%s_%s%s.wav", sourceHash, target.rate,
+        target.mono ? "mono" : "src", target.asFloat ? "f32" : "s16", loop ? "_loop" : "");
+    std::string cacheDir = g_basePath + "\\cache";
+    std::string cached = cacheDir + "\\" + name;
+
+    std::error_code ec;
+    if (fs::exists(cached, ec)) {
+        if (CachedWavIsComplete(cached)) return cached;
+        WriteLog("PreprocessSample: %s is incomplete, converting again", cached.c_str());
+        fs::remove(cached, ec);
+    }
+
+    std::vector<char> converted;
+    auto t0 = std::chrono::steady_clock::now();
+    if (!ConvertWav(source, target, loop, converted)) {
+        WriteLog("PreprocessSample: %s is not PCM/float wav, loading as is", path.c_str());
+        return path;
+    }
+    fs::create_directories(cacheDir, ec);
+    // escreve ao lado e s renomeia com tudo gravado: o cache nunca v um arquivo pela metade
+    // (temporrio por thread: o prefetch e o jogo podem converter a mesma fonte)
+    std::string temp = cached + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+    {
+        std::ofstream f(temp, std::ios::binary | std::ios::trunc);
+        f.write(converted.data(), (std::streamsize)converted.size());
+        f.close();
+        if (!f) {
+            WriteLog("PreprocessSample: cannot write %s", temp.c_str());
+            fs::remove(temp, ec);
+            return path;
+        }
+    }
+    fs::rename(temp, cached, ec);
+    if (ec) {
+        fs::remove(temp, ec);
+        if (CachedWavIsComplete(cached)) return cached;  // outro thread chegou primeiro
+        WriteLog("PreprocessSample: cannot rename %s", temp.c_str());
+        return path;
+    }
+    WriteLog("PreprocessSample: %s -> %s (%zu -> %zu bytes, %.1f ms)", path.c_str(), name, source.size(), converted.size(),
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    return cached;
+}
+
+// ---------------- loudness analysis ----------------
+// RMS, pico e diferena mdia entre samples consecutivos (por canal) num s passe;
+// os kernels seguem o mesmo esquema do batch de smoothing (escalar / SSE2 / AVX2).
+struct LevelAccum {
+    double sumSq = 0.0;
+    double sumAbsDiff = 0.0;  // |x[i] - x[i - stride]|
+    float peak = 0.0f;
+};
+
+typedef void (*LevelKernelFn)(const float* x, size_t begin, size_t end, size_t stride, LevelAccum& acc);
+
+static void LevelKernelScalar(const float* x, size_t begin, size_t end, size_t stride, LevelAccum& acc) {
+    float sq = 0.0f, df = 0.0f, pk = acc.peak;
+    for (size_t i = begin; i < end; ++i) {
+        float v = x[i];
+        sq += v * v;
+        pk = std::max(pk, std::fabs(v));
+        if (i >= stride) df += std::fabs(v - x[i - stride]);
+    }
+    acc.sumSq += sq;
+    acc.sumAbsDiff += df;
+    acc.peak = pk;
+}
+
+static void LevelKernelSSE2(const float* x, size_t begin, size_t end, size_t stride, LevelAccum& acc) {
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 sq = _mm_setzero_ps(), pk = _mm_setzero_ps(), df = _mm_setzero_ps();
+    size_t i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 v = _mm_loadu_ps(x + i);
+        sq = _mm_add_ps(sq, _mm_mul_ps(v, v));
+        pk = _mm_max_ps(pk, _mm_and_ps(v, absMask));
+    }
+    size_t d = std::max(begin, stride);
+    for (; d + 4 <= end; d += 4) {
+        __m128 delta = _mm_sub_ps(_mm_loadu_ps(x + d), _mm_loadu_ps(x + d - stride));
+        df = _mm_add_ps(df, _mm_and_ps(delta, absMask));
+    }
+    alignas(16) float s[4], p[4], f[4];
+    _mm_store_ps(s, sq); _mm_store_ps(p, pk); _mm_store_ps(f, df);
+    LevelAccum tail;
+    tail.peak = std::max(std::max(p[0], p[1]), std::max(p[2], p[3]));
+    LevelKernelScalar(x, i, end, end, tail);           // stride=end: sem diferenas aqui
+    for (size_t k = d; k < end; ++k) tail.sumAbsDiff += std::fabs(x[k] - x[k - stride]);
+    acc.sumSq += (double)s[0] + s[1] + s[2] + s[3] + tail.sumSq;
+    acc.sumAbsDiff += (double)f[0] + f[1] + f[2] + f[3] + tail.sumAbsDiff;
+    acc.peak = std::max(acc.peak, tail.peak);
+}
+
+VSFX_AVX2_TARGET static void LevelKernelAVX2(const float* x, size_t begin, size_t end, size_t stride, LevelAccum& acc) {
+    const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 sq = _mm256_setzero_ps(), pk = _mm256_setzero_ps(), df = _mm256_setzero_ps();
+    size_t i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 v = _mm256_loadu_ps(x + i);
+        sq = _mm256_add_ps(sq, _mm256_mul_ps(v, v));
+        pk = _mm256_max_ps(pk, _mm256_and_ps(v, absMask));
+    }
+    size_t d = std::max(begin, stride);
+    for (; d + 8 <= end; d += 8) {
+        __m256 delta = _mm256_sub_ps(_mm256_loadu_ps(x + d), _mm256_loadu_ps(x + d - stride));
+        df = _mm256_add_ps(df, _mm256_and_ps(delta, absMask));
+    }
+    alignas(32) float s[8], p[8], f[8];
+    _mm256_store_ps(s, sq); _mm256_store_ps(p, pk); _mm256_store_ps(f, df);
+    LevelAccum tail;
+    for (int k = 0; k < 8; ++k) {
+        tail.sumSq += s[k];
+        tail.sumAbsDiff += f[k];
+        tail.peak = std::max(tail.peak, p[k]);
+    }
+    LevelKernelScalar(x, i, end, end, tail);
+    for (size_t k = d; k < end; ++k) tail.sumAbsDiff += std::fabs(x[k] - x[k - stride]);
+    acc.sumSq += tail.sumSq;
+    acc.sumAbsDiff += tail.sumAbsDiff;
+    acc.peak = std::max(acc.peak, tail.peak);
+}
+
+static LevelKernelFn SelectLevelKernel(const char** name) {
+    CpuFeatures cpu = DetectCpuFeatures();
+    if (cpu.avx2) { *name = "AVX2"; return LevelKernelAVX2; }
+    if (cpu.sse2) { *name = "SSE2"; return LevelKernelSSE2; }
+    *name = "scalar";
+    return LevelKernelScalar;
+}
+
+static LevelKernelFn g_levelKernel = nullptr;
+
+static inline float ToDb(double power) { return (power > 1e-12) ? float(10.0 * std::log10(power)) : -120.0f; }
+
+// sub-blocos de 100 ms; janelas de 400 ms com 75% de sobreposio, gate absoluto
+// -70 e relativo -10 como no BS.1770 (sem o filtro K: serve para comparar bancos)
+static SoundMetrics AnalyzePcm(const PcmData& pcm, bool loop, LevelKernelFn kernel) {
+    SoundMetrics m;
+    size_t frames = pcm.Frames();
+    if (!frames || !pcm.rate) return m;
+    size_t ch = (size_t)pcm.channels;
+    m.lengthMs = 1000.0f * float(frames) / float(pcm.rate);
+
+    size_t subFrames = std::max<size_t>(1, (size_t)pcm.rate / 10);
+    std::vector<double> subPower;  // soma dos quadrados por sub-bloco
+    LevelAccum total;
+    for (size_t f = 0; f < frames; f += subFrames) {
+        size_t e = std::min(frames, f + subFrames);
+        double before = total.sumSq;
+        kernel(pcm.samples.data(), f * ch, e * ch, ch, total);
+        subPower.push_back(total.sumSq - before);
+    }
+    m.rmsDb = ToDb(total.sumSq / double(frames * ch));
+    m.peakDb = (total.peak > 0.0f) ? float(20.0 * std::log10(total.peak)) : -120.0f;
+
+    // potncia por janela = soma dos canais da mdia quadrtica
+    std::vector<double> windows;
+    size_t span = std::min<size_t>(4, subPower.size());
+    for (size_t w = 0; w + span <= subPower.size(); ++w) {
+        double sum = 0.0;
+        for (size_t k = 0; k < span; ++k) sum += subPower[w + k];
+        size_t wFrames = std::min(frames - w * subFrames, span * subFrames);
+        windows.push_back(sum / double(wFrames));
+    }
+    auto gatedMean = [&](double threshold) {
+        double sum = 0.0;
+        int n = 0;
+        for (double p : windows) if (-0.691 + 10.0 * std::log10(std::max(p, 1e-12)) > threshold) { sum += p; ++n; }
+        return n ? sum / n : 0.0;
+    };
+    double absGated = gatedMean(-70.0);
+    if (absGated > 0.0) {
+        double relGate = -0.691 + 10.0 * std::log10(absGated) - 10.0;
+        double rel = gatedMean(relGate);
+        m.loudness = float(-0.691 + 10.0 * std::log10(std::max(rel, 1e-12)));
+    }
+
+    if (loop && frames > 1) {
+        float jump = 0.0f;
+        for (size_t c = 0; c < ch; ++c) jump = std::max(jump, std::fabs(pcm.samples[(frames - 1) * ch + c] - pcm.samples[c]));
+        double meanDiff = total.sumAbsDiff / double((frames - 1) * ch);
+        m.seamRatio = float(jump / std::max(meanDiff, 1e-6));
+    }
+    return m;
+}
+
+// ganho para levar o som a TargetLoudness sem passar de 0 dBFS no pico
+static float NormalizeGain(const SoundMetrics& m) {
+    if (GetConfig("NormalizeLoudness", 1.0f) == 0.0f || m.loudness <= -70.0f) return 1.0f;
+    float target = GetConfig("TargetLoudness", -18.0f);
+    float gainDb = std::min(target - m.loudness, -m.peakDb);
+    return std::clamp(std::pow(10.0f, gainDb / 20.0f), 0.25f, 4.0f);
+}
+
+static inline float BankGain(const WavBank* bank, SoundSlot slot) {
+    return bank ? bank->gain[slot] : 1.0f;
+}
+
+// vsfx.meta: uma linha por som, "nome=hash,lengthMs,rmsDb,peakDb,loudness,seam"
+static void LoadBankMeta(const std::string& folder, std::map<std::string, SoundMetrics>& meta) {
+    std::ifstream f(folder + "\\vsfx.meta");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == ';') continue;
+        auto eq = line.find('=');
+        if (eq == std::string::npos) continue;
+        SoundMetrics m;
+        if (sscanf(line.c_str() + eq + 1, "%llx,%f,%f,%f,%f,%f", &m.sourceHash, &m.lengthMs, &m.rmsDb, &m.peakDb, &m.loudness, &m.seamRatio) == 6) {
+            meta[line.substr(0, eq)] = m;
+        }
+    }
+}
+
+static void SaveBankMeta(const std::string& folder, const std::map<std::string, SoundMetrics>& meta) {
+    std::ofstream f(folder + "\\vsfx.meta", std::ios::trunc);
+    if (!f.is_open()) { WriteLog("SaveBankMeta: cannot write %s\\vsfx.meta", folder.c_str()); return; }
+    f << "; VehicleSFX: medidas de loudness por som (gerado automaticamente)\n";
+    char buf[256];
+    for (auto& kv : meta) {
+        const SoundMetrics& m = kv.second;
+        snprintf(buf, sizeof(buf), "%s=%016llx,%.1f,%.2f,%.2f,%.2f,%.2f\n", kv.first.c_str(), m.sourceHash, m.lengthMs, m.rmsDb, m.peakDb, m.loudness, m.seamRatio);
+        f << buf;
+    }
+}
+
+static bool AnalyzeSoundFile(const std::vector<char>& source, bool loop, SoundMetrics& out, double* mbPerSec) {
+    PcmData pcm;
+    if (!DecodeWav(source, pcm)) return false;
+    if (!g_levelKernel) {
+        const char* kname = "";
+        g_levelKernel = SelectLevelKernel(&kname);
+        WriteLog("AnalyzeSoundFile: using %s level kernel", kname);
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    out = AnalyzePcm(pcm, loop, g_levelKernel);
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    if (mbPerSec) *mbPerSec = (sec > 0.0) ? double(pcm.samples.size() * sizeof(float)) / (1024.0 * 1024.0) / sec : 0.0;
+    return true;
+}
+
+static inline bool SlotLoops(int slot) { return slot == SND_IDLE || slot == SND_ENGINE || slot == SND_WIND; }
+
+// carrega um som do banco a partir dos bytes j lidos: medidas de nvel (vsfx.meta ou
+// anlise), pr-processamento e createSound. Tambm usado pelo hot reload.
+static FMOD::Sound* LoadBankSlot(FMOD::System* core, const std::string& folder, int modelId, int slot,
+    const std::vector<char>& source, unsigned long long sourceHash,
+    std::map<std::string, SoundMetrics>& meta, bool& metaDirty, SoundMetrics& metrics, float& gain) {
+    const char* name = s_names[slot];
+    std::string p = folder + "\\" + name;
+    bool loop = SlotLoops(slot);
+
+    // medidas de nvel: do vsfx.meta se a fonte no mudou, seno analisa agora
+    auto mi = meta.find(name);
+    double mbPerSec = 0.0;
+    if (mi != meta.end() && mi->second.sourceHash == sourceHash) metrics = mi->second;
+    else if (AnalyzeSoundFile(source, loop, metrics, &mbPerSec)) {
+        metrics.sourceHash = sourceHash;
+        meta[name] = metrics;
+        metaDirty = true;
+    }
+    metrics.sourceHash = sourceHash;
+    gain = NormalizeGain(metrics);
+    WriteLog("BankMeta: model=%d %s len=%.0fms rms=%.1fdB peak=%.1fdB loudness=%.1f seam=%.1f gain=%.2f (%s%.1f MB/s)",
+        modelId, name, metrics.lengthMs, metrics.rmsDb, metrics.peakDb, metrics.loudness, metrics.seamRatio, gain,
+        mbPerSec > 0.0 ? "analysed " : "cached ", mbPerSec);
+    if (loop && metrics.seamRatio > 8.0f) WriteLog("BankMeta: model=%d %s loop seam looks discontinuous (may click)", modelId, name);
+
+    // wind  2D: mantm os canais; o resto toca em 3D e vira mono
+    if (GetConfig("PreprocessSamples", 1.0f) != 0.0f) p = PreprocessSample(p, source, sourceHash, MixerSampleTarget(core, slot != SND_WIND), loop);
+    FMOD::Sound* s = LoadWav(core, p, loop);
+    if (s && slot == SND_WIND) {
+        // Se for wind.wav, fora modos 2D+loop para evitar atenuao 3D indesejada
+        try {
+            s->setMode(static_cast<FMOD_MODE>(FMOD_2D | FMOD_LOOP_NORMAL));
+            s->setLoopCount(-1);
+        }
+        catch (...) {}
+    }
+    return s;
+}
+
+// chave do som no map do banco: nome sem extenso
+static std::string SlotKey(int slot) {
+    std::string key = s_names[slot];
+    auto pos = key.rfind('.');
+    if (pos != std::string::npos) key = key.substr(0, pos);
+    return key;
+}
+
+// ---------------- bank loading ----------------
+// O estado de cada modelo vive no g_modelBanks: quem passa BANK_ABSENT -> BANK_LOADING
+// por CAS carrega sem lock e publica. Quem pede um modelo a carregar (prefetch) no
+// espera: recebe nullptr e tenta de novo na frame seguinte.
+struct PrefetchStats {
+    std::atomic<unsigned int> requests{ 0 };  // primeiro uso de um banco ainda no residente ou vindo de prefetch
+    std::atomic<unsigned int> hits{ 0 };      // j estava pronto
+    std::atomic<unsigned int> late{ 0 };      // prefetch ainda a carregar quando foi pedido
+    std::atomic<unsigned int> misses{ 0 };    // carregado na hora
+    std::atomic<unsigned int> issued{ 0 };    // prefetches concludos com banco
+    std::atomic<unsigned int> wasted{ 0 };    // expirados sem uso (libertados)
+};
+
+static PrefetchStats g_prefetchStats;
+
+// bytes de PCM do banco (independente do alocador)
+static unsigned long long BankBytes(const WavBank* bank) {
+    unsigned long long total = 0;
+    if (!bank) return 0;
+    for (FMOD::Sound* s : bank->slots) {
+        unsigned int len = 0;
+        if (s && s->getLength(&len, FMOD_TIMEUNIT_PCMBYTES) == FMOD_OK) total += len;
+    }
+    return total;
+}
+
+// l a pasta do modelo e cria os sons; nullptr se no houver pasta
+static WavBank* BuildBank(FMOD::System* core, int modelId) {
+    std::string folder = g_basePath + "\\" + std::to_string(modelId);
+    WriteLog("LoadBankForModel: modelId=%d folder=%s", modelId, folder.c_str());
+    if (!fs::exists(folder) || !fs::is_directory(folder)) {
+        WriteLog("LoadBankForModel: folder not found %s", folder.c_str());
+        return nullptr;
+    }
+
+    WavBank* bank = new WavBank();
+    FmodMemoryTag memTag(modelId);
+    std::map<std::string, SoundMetrics> meta;
+    bool metaDirty = false;
+    LoadBankMeta(folder, meta);
+    for (int slot = 0; slot < SND_COUNT; ++slot) {
+        std::string p = folder + "\\" + s_names[slot];
+        if (!fs::exists(p)) continue;
+
+        std::vector<char> source;
+        ReadFileBytes(p, source);
+        unsigned long long sourceHash = HashBytes(source.data(), source.size());
+        FMOD::Sound* s = LoadBankSlot(core, folder, modelId, slot, source, sourceHash, meta, metaDirty, bank->metrics[slot], bank->gain[slot]);
+        if (s) {
+            bank->sounds[SlotKey(slot)] = s;
+            bank->slots[slot] = s;
+            bank->soundMask |= 1u << slot;
+        }
+    }
+    if (metaDirty) SaveBankMeta(folder, meta);
+    WriteLog("LoadBankForModel: finished modelId=%d sounds=%d memory=%lld KB", modelId, (int)bank->sounds.size(),
+        g_fmodAllocator.TagBytes(modelId) >> 10);
+    return bank;
+}
+
+// prefetch=true: pedido do preditor (no conta como uso do banco); a expirao conta
+// a partir de prefetchRequestedMs, o relgio do jogo quando o pedido foi feito
+static WavBank* LoadBankForModel(int modelId, bool prefetch = false, unsigned int prefetchRequestedMs = 0) {
+    FMOD::System* core = GetCoreSystem();
+    if (!core) return nullptr;
+
+    BankRegistry::Slot* slot = g_modelBanks.FindOrInsert(modelId);
+    if (!slot) {
+        static bool warned = false;
+        if (!warned) { WriteLog("LoadBankForModel: bank registry full, model=%d not loaded", modelId); warned = true; }
+        return nullptr;
+    }
+
+    for (;;) {
+        int state = slot->state.load(std::memory_order_acquire);
+        if (state == BANK_MISSING) return nullptr;
+        if (state == BANK_LOADING) {
+            if (!prefetch) slot->waitedOn.store(true, std::memory_order_relaxed);
+            return nullptr;
+        }
+        if (state == BANK_READY) {
+            WavBank* bank = slot->bank.load(std::memory_order_acquire);
+            if (!prefetch && slot->prefetchedAtMs.exchange(0, std::memory_order_acq_rel) != 0) {
+                bool late = slot->waitedOn.exchange(false, std::memory_order_relaxed);
+                ++g_prefetchStats.requests;
+                ++(late ? g_prefetchStats.late : g_prefetchStats.hits);
+                WriteLog("Prefetch: model=%d %s", modelId, late ? "late (requested while the prefetch was loading)" : "hit");
+            }
+            return bank;
+        }
+        if (slot->state.compare_exchange_strong(state, BANK_LOADING, std::memory_order_acq_rel)) break;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    WavBank* bank = BuildBank(core, modelId);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    slot->bank.store(bank, std::memory_order_release);
+    if (bank) {
+        if (prefetch) {
+            slot->prefetchedAtMs.store(prefetchRequestedMs | 1u, std::memory_order_release);
+            ++g_prefetchStats.issued;
+        }
+        else {
+            ++g_prefetchStats.requests;
+            ++g_prefetchStats.misses;
+            WriteLog("Prefetch: model=%d miss (loaded on first use in %.1f ms)", modelId, ms);
+        }
+    }
+    slot->state.store(bank ? BANK_READY : BANK_MISSING, std::memory_order_release);
+    return bank;
+}
+
+// ---------------- transmission profile ----------------
+// offsets em CVehicle / tHandlingData / cTransmission
+static const uintptr_t VEH_HANDLING_OFFSET = 0x384;
+static const uintptr_t HANDLING_TRANSMISSION_OFFSET = 0x2C;
+static const uintptr_t TRANSMISSION_GEAR_STRIDE = 0x0C;
+static const uintptr_t TRANSMISSION_GEAR_VELOCITY_OFFSET = 0x4;
+static const uintptr_t TRANSMISSION_NUM_GEARS_OFFSET = 0x4A;
+static const uintptr_t TRANSMISSION_SPEED_OFFSET = 0x64;
+
+static const unsigned int TRANSMISSION_REVALIDATE_MS = 1000; // re-hash da tabela de marchas
+
+static inline uintptr_t ReadHandlingPtr(CVehicle* veh) {
+    return *(uintptr_t*)(reinterpret_cast<uintptr_t>(veh) + VEH_HANDLING_OFFSET);
+}
+
+// FNV-1a sobre o n de marchas e a tabela de velocidades
+static unsigned int HashTransmission(uintptr_t handlingPtr) {
+    uintptr_t transmissionPtr = handlingPtr + HANDLING_TRANSMISSION_OFFSET;
+    unsigned int h = 2166136261u;
+    auto mix = [&h](const void* p, size_t n) {
+        const unsigned char* b = (const unsigned char*)p;
+        for (size_t i = 0; i < n; ++i) { h ^= b[i]; h *= 16777619u; }
+    };
+    mix((const void*)(transmissionPtr + TRANSMISSION_NUM_GEARS_OFFSET), 1);
+    mix((const void*)transmissionPtr, TRANSMISSION_GEAR_STRIDE * (MAX_TRANSMISSION_GEARS + 1));
+    return h;
+}
+
+// constantes por marcha a partir do gearCount e dos params do ini
+static void ComputeGearConstants(TransmissionProfile& prof) {
+    for (int g = 1; g <= MAX_TRANSMISSION_GEARS; ++g) {
+        int src = std::min(g, prof.gearCount);
+        // Factor que cresce com a marcha (0 em gear=1, 1 na ltima marcha real)
+        float gearFactor = (prof.gearCount > 1) ? float(src - 1) / float(prof.gearCount - 1) : 0.0f;
+        // escala proporcional: nas marchas altas aplicamos mais ganho ao delta
+        float gearScale = 1.0f + gearFactor * (PITCH_AMPLIFY_MAX - 1.0f);
+
+        prof.startPitch[g] = START_PITCH_PER_GEAR[src];
+        prof.pitchSpan[g] = (TARGET_PITCH - START_PITCH_PER_GEAR[src]) * gearScale;
+        prof.shiftDrop[g] = BASE_SHIFT_DROP * (1.0f + gearFactor * EXTRA_DROP_PER_GEAR);
+    }
+}
+
+// frmula de referncia (a mesma que UpdateInstance fazia a cada frame)
+static void FormulaResponse(const TransmissionProfile& prof, int g, float ratio, float& accelTarget, float& decelTarget, float& vol) {
+    float startPitch = prof.startPitch[g];
+    accelTarget = startPitch + ratio * prof.pitchSpan[g];
+    accelTarget = std::clamp(accelTarget, startPitch, TARGET_PITCH + MAX_OVERSHOOT);
+    decelTarget = startPitch + ratio * prof.pitchSpan[g] * DECEL_FACTOR;
+    decelTarget = std::clamp(decelTarget, startPitch, accelTarget);
+    decelTarget = std::max(decelTarget, MIN_PITCH);
+    vol = 0.45f + ratio * 0.55f;
+}
+
+// ---- curvas customizadas no ini: "ratio:valor, ratio:valor, ..." ----
+struct CurvePoint { float x, y; };
+
+static bool ParseCurve(const std::string& text, std::vector<CurvePoint>& out) {
+    out.clear();
+    size_t pos = 0;
+    while (pos < text.size()) {
+        size_t end = text.find(',', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string item = Trim(text.substr(pos, end - pos));
+        pos = end + 1;
+        if (item.empty()) continue;
+        size_t colon = item.find(':');
+        if (colon == std::string::npos) return false;
+        try { out.push_back({ std::stof(item.substr(0, colon)), std::stof(item.substr(colon + 1)) }); }
+        catch (...) { return false; }
+    }
+    if (out.empty()) return false;
+    std::sort(out.begin(), out.end(), [](const CurvePoint& a, const CurvePoint& b) { return a.x < b.x; });
+    return true;
+}
+
+static float EvalCurve(const std::vector<CurvePoint>& pts, float x) {
+    if (x <= pts.front().x) return pts.front().y;
+    for (size_t i = 1; i < pts.size(); ++i) {
+        if (x <= pts[i].x) {
+            float span = pts[i].x - pts[i - 1].x;
+            float t = (span > 1e-6f) ? (x - pts[i - 1].x) / span : 1.0f;
+            return pts[i - 1].y + (pts[i].y - pts[i - 1].y) * t;
+        }
+    }
+    return pts.back().y;
+}
+
+// tenta "<base>Gear<n>" e depois "<base>" (vale para todas as marchas)
+static bool LoadCurveForGear(const std::string& base, int gear, std::vector<CurvePoint>& out) {
+    std::string key = base + "Gear" + std::to_string(gear);
+    std::string text = GetConfigText(key);
+    if (text.empty()) { key = base; text = GetConfigText(key); }
+    if (text.empty()) return false;
+    if (!ParseCurve(text, out)) {
+        WriteLog("LoadCurveForGear: invalid curve %s='%s' -> using formula", key.c_str(), text.c_str());
+        return false;
+    }
+    return true;
+}
+
+// assa as curvas de pitch/volume por marcha e modo; sem curva no ini usa a frmula original
+static void BakeResponseTables(TransmissionProfile& prof) {
+    std::vector<CurvePoint> accelCurve, decelCurve, accelVolCurve, decelVolCurve;
+
+    for (int g = 1; g <= MAX_TRANSMISSION_GEARS; ++g) {
+        int src = std::min(g, prof.gearCount);
+        bool hasAccel = LoadCurveForGear("AccelCurve", src, accelCurve);
+        bool hasDecel = LoadCurveForGear("DecelCurve", src, decelCurve);
+        bool hasAccelVol = LoadCurveForGear("AccelVolumeCurve", src, accelVolCurve);
+        bool hasDecelVol = LoadCurveForGear("DecelVolumeCurve", src, decelVolCurve);
+
+        ResponseTable& rt = prof.response[g];
+        for (int i = 0; i < RESPONSE_LUT_SIZE; ++i) {
+            float ratio = float(i) / float(RESPONSE_LUT_SIZE - 1);
+            float accelTarget, decelTarget, vol;
+            FormulaResponse(prof, g, ratio, accelTarget, decelTarget, vol);
+
+            rt.pitch[RM_ACCEL][i] = hasAccel ? EvalCurve(accelCurve, ratio) : accelTarget;
+            rt.pitch[RM_DECEL][i] = hasDecel ? EvalCurve(decelCurve, ratio) : decelTarget;
+            rt.volume[RM_ACCEL][i] = hasAccelVol ? EvalCurve(accelVolCurve, ratio) : vol;
+            rt.volume[RM_DECEL][i] = hasDecelVol ? EvalCurve(decelVolCurve, ratio) : vol;
+        }
+        if (g == src && (hasAccel || hasDecel || hasAccelVol || hasDecelVol)) {
+            WriteLog("BakeResponseTables: gear=%d custom accel=%d decel=%d accelVol=%d decelVol=%d",
+                g, hasAccel ? 1 : 0, hasDecel ? 1 : 0, hasAccelVol ? 1 : 0, hasDecelVol ? 1 : 0);
+        }
+    }
+    prof.configGeneration = g_configGeneration;
+}
+
+static void BuildTransmissionProfile(TransmissionProfile& prof, CVehicle* veh) {
+    prof = TransmissionProfile();
+    uintptr_t handlingPtr = 0;
+    try { handlingPtr = ReadHandlingPtr(veh); }
+    catch (...) { handlingPtr = 0; }
+    if (!handlingPtr) {
+        WriteLog("BuildTransmissionProfile: no handling for model=%d", veh->m_nModelIndex);
+        return;
+    }
+
+    uintptr_t transmissionPtr = handlingPtr + HANDLING_TRANSMISSION_OFFSET;
+    int gears = (int)*(unsigned char*)(transmissionPtr + TRANSMISSION_NUM_GEARS_OFFSET);
+    prof.gearCount = std::clamp(gears, 1, MAX_TRANSMISSION_GEARS);
+    prof.handlingPtr = handlingPtr;
+    prof.fingerprint = HashTransmission(handlingPtr);
+    prof.lastValidateMs = CTimer::m_snTimeInMilliseconds;
+
+    for (int g = 1; g <= MAX_TRANSMISSION_GEARS; ++g) {
+        // marchas acima de gearCount repetem a ltima (o jogo no deve chegar l)
+        int src = std::min(g, prof.gearCount);
+        float maybe = *(float*)(transmissionPtr + TRANSMISSION_GEAR_STRIDE * (uintptr_t)src + TRANSMISSION_GEAR_VELOCITY_OFFSET);
+        prof.gearMaxVelocity[g] = (maybe > 0.0001f) ? maybe : 1.0f;
+    }
+    ComputeGearConstants(prof);
+    BakeResponseTables(prof);
+    prof.valid = true;
+
+    WriteLog("BuildTransmissionProfile: model=%d gears=%d vmax=[%.2f %.2f %.2f %.2f %.2f]",
+        veh->m_nModelIndex, prof.gearCount, prof.gearMaxVelocity[1], prof.gearMaxVelocity[2],
+        prof.gearMaxVelocity[3], prof.gearMaxVelocity[4], prof.gearMaxVelocity[5]);
+}
+
+// garante que o perfil do banco corresponde ao handling atual do veculo e ao ini;
+// o ponteiro  comparado a cada frame, a tabela s  re-hashada periodicamente
+static const TransmissionProfile& EnsureTransmissionProfile(WavBank* bank, CVehicle* veh) {
+    TransmissionProfile& prof = bank->transmission;
+    uintptr_t handlingPtr = 0;
+    try { handlingPtr = ReadHandlingPtr(veh); }
+    catch (...) { handlingPtr = 0; }
+
+    bool rebuild = !prof.valid || handlingPtr != prof.handlingPtr || prof.configGeneration != g_configGeneration;
+    unsigned int now = CTimer::m_snTimeInMilliseconds;
+    if (!rebuild && handlingPtr && (now - prof.lastValidateMs) >= TRANSMISSION_REVALIDATE_MS) {
+        prof.lastValidateMs = now;
+        if (HashTransmission(handlingPtr) != prof.fingerprint) {
+            WriteLog("EnsureTransmissionProfile: handling reloaded for model=%d", veh->m_nModelIndex);
+            rebuild = true;
+        }
+    }
+    if (rebuild && handlingPtr) BuildTransmissionProfile(prof, veh);
+    return prof;
+}
+
+// m_fCurrentSpeed vive no handling, que  partilhado por modelo: s diz respeito ao
+// ltimo carro desse modelo que a fsica processou. Serve para o carro do jogador.
+static inline float ReadLiveSpeed(const TransmissionProfile& prof) {
+    if (!prof.valid) return 0.0f;
+    return *(float*)(prof.handlingPtr + HANDLING_TRANSMISSION_OFFSET + TRANSMISSION_SPEED_OFFSET);
+}
+
+// velocidade do prprio veculo: m_vecMoveSpeed projetado no eixo da frente (matrix->up
+// no SA), a mesma grandeza que a transmisso guarda em m_fCurrentSpeed (com sinal)
+static inline float ReadVehicleSpeed(CVehicle* veh) {
+    CMatrix* m = veh->GetMatrix();
+    const CVector& v = veh->m_vecMoveSpeed;
+    if (!m) return v.Magnitude();
+    return v.x * m->up.x + v.y * m->up.y + v.z * m->up.z;
+}
+
+static inline int ClampGear(const TransmissionProfile& prof, int gear) {
+    return std::clamp(gear <= 0 ? 1 : gear, 1, prof.gearCount);
+}
+
+// Se o jogo est pausado, no devemos iniciar novos canais
+static inline bool IsGamePaused() {
+    return CTimer::m_UserPause != 0;
+}
+
+// posio/velocidade vm das entradas j lidas (e gravadas no trace), no do CVehicle
+static FMOD::Channel* PlayLoop(const FMOD_VECTOR& fv, const FMOD_VECTOR& vel, FMOD::Sound* snd, float initVol, float initPitch, unsigned int startMs = 0) {
+    if (IsGamePaused()) {
+        // no iniciar loops durante pausa
+        return nullptr;
+    }
+    FMOD::System* core = GetCoreSystem();
+    if (!core || !snd) return nullptr;
+    FMOD::Channel* ch = nullptr;
+    FMOD_RESULT r = core->playSound(snd, nullptr, true, &ch);
+    if (r != FMOD_OK || !ch) { WriteLog("PlayLoop failed r=%d", (int)r); return nullptr; }
+    try { ch->set3DAttributes(&fv, &vel); }
+    catch (...) {}
+    try { ch->set3DMinMaxDistance(1.0f, 300.0f); }
+    catch (...) {}
+    try { ch->setVolume(initVol); }
+    catch (...) {}
+    try { ch->setPitch(initPitch); }
+    catch (...) {}
+    if (startMs) {
+        try { ch->setPosition(startMs, FMOD_TIMEUNIT_MS); }
+        catch (...) {}
+    }
+    try { ch->setPaused(false); }
+    catch (...) {}
+    return ch;
+}
+
+static FMOD::Channel* PlayOneShot(const FMOD_VECTOR& fv, const FMOD_VECTOR& vel, FMOD::Sound* snd, float pitch = 1.0f, float volume = 1.0f) {
+    if (IsGamePaused()) {
+        // no iniciar one-shots durante pausa
+        return nullptr;
+    }
+    FMOD::System* core = GetCoreSystem();
     if (!core || !snd) return nullptr;
     try { snd->setMode(FMOD_LOOP_OFF); snd->setLoopCount(0); }
     catch (...) {}
@@ -364,9 +2143,6 @@ static FMOD::Channel* PlayOneShot(CVehicle* veh, FMOD::Sound* snd, float pitch =
     if (r != FMOD_OK || !ch) { WriteLog("PlayOneShot playSound failed r=%d", (int)r); return nullptr; }
     try { ch->setLoopCount(0); ch->setMode(FMOD_LOOP_OFF); }
     catch (...) {}
-    CVector p = veh->GetPosition();
-    FMOD_VECTOR fv = { p.x, p.y, p.z };
-    FMOD_VECTOR vel = { veh->m_vecMoveSpeed.x, veh->m_vecMoveSpeed.y, veh->m_vecMoveSpeed.z };
     try { ch->set3DAttributes(&fv, &vel); }
     catch (...) {}
     // importante: define min/max distance para evitar atenuao indesejada
@@ -385,6 +2161,14 @@ static void StopChannelSafe(FMOD::Channel*& ch) {
     ch = nullptr;
 }
 
+static void StopInstanceChannels(VehicleAudioInstance& inst) {
+    StopChannelSafe(inst.loopChannel);
+    StopChannelSafe(inst.pendingLoopChannel);
+    StopChannelSafe(inst.attackChannel);
+    StopChannelSafe(inst.shiftChannel);
+    StopChannelSafe(inst.windChannel);
+}
+
 static unsigned int GetSoundLengthMs(FMOD::Sound* s) {
     if (!s) return 150;
     unsigned int len = 150;
@@ -410,10 +2194,207 @@ static void MuteGameVehicleAudio(CVehicle* veh) {
             va.m_aEngineSounds[i].m_pSound = nullptr;
         }
     }
-    if (va.m_pRoadNoiseSound) { try { va.m_pRoadNoiseSound->StopSoundAndForget(); } catch (...) {} va.m_pRoadNoiseSound = nullptr; }
+    if (va.m_pRoadNoiseSound && GetConfig("KeepGameRoadNoise", 0.0f) == 0.0f) {
+        try { va.m_pRoadNoiseSound->StopSoundAndForget(); }
+        catch (...) {}
+        va.m_pRoadNoiseSound = nullptr;
+    }
     WriteLog("MuteGameVehicleAudio: done model=%d", veh->m_nModelIndex);
 }
 
+// ---------------- game engine audio hooks ----------------
+// O MuteGameVehicleAudio s desliga o motor do jogo depois de ele ter carregado os bancos
+// e arrancado os m_aEngineSounds, e o jogo pode reinicializar a entidade mais tarde.
+// Com SuppressGameEngineAudio=1 (padro) os hooks abaixo cortam o que d na origem para
+// as entidades com banco vsfx: o ProcessPlayerVehicleEngine no corre, e Initialise e
+// JustGotInVehicleAsDriver registam a entidade antes do original. Esses dois originais
+// continuam a correr inteiros (tambm montam estado que no  do motor), por isso o pedido
+// do banco do motor que fazem no  evitado:  contado em LogGameEngineAudio. O
+// ProcessDummyVehicleEngine no  interceptado (o endereo no foi conferido contra o
+// gta_sa 1.0 US); os carros da IA com vsfx ficam s com o MuteGameVehicleAudio.
+// Buzina, road noise (KeepGameRoadNoise=1), derrapagem etc. continuam com o jogo. O custo
+// mdio do motor do jogo por veculo  medido nos veculos no suprimidos e d a
+// estimativa de CPU poupado.
+static const uintptr_t ADDR_AEVEHICLE_INITIALISE = 0x4F7670;
+static const uintptr_t ADDR_AEVEHICLE_JUST_GOT_IN_AS_DRIVER = 0x4F5700;
+static const uintptr_t ADDR_AEVEHICLE_PROCESS_PLAYER_ENGINE = 0x4FBB10;
+
+typedef void(__fastcall* AEVehicleInitialiseFn)(CAEVehicleAudioEntity*, void*, CEntity*);
+typedef void(__fastcall* AEVehicleVoidFn)(CAEVehicleAudioEntity*, void*);
+typedef void(__fastcall* AEVehicleEngineFn)(CAEVehicleAudioEntity*, void*, cVehicleParams*);
+
+static AEVehicleInitialiseFn g_origAEInitialise = nullptr;
+static AEVehicleVoidFn g_origAEJustGotInAsDriver = nullptr;
+static AEVehicleEngineFn g_origAEProcessPlayerEngine = nullptr;
+static bool g_gameAudioHooks = false;
+
+// entidades cujo motor  do vsfx (s tocadas no thread do jogo)
+static std::map<CAEVehicleAudioEntity*, int> g_suppressedEngines;
+
+struct GameEngineAudioStats {
+    unsigned long long processedCalls = 0;   // chamadas do motor do jogo que correram
+    double processedUs = 0.0;
+    unsigned long long suppressedCalls = 0;  // chamadas cortadas
+    unsigned int suppressedEntities = 0;     // entidades registadas (total)
+    unsigned long long setupCalls = 0;       // Initialise/JustGotIn que correram em entidades registadas
+    double setupUs = 0.0;
+    unsigned long long setupBankRequests = 0; // ...e deixaram um banco do motor pedido
+};
+static GameEngineAudioStats g_gameEngineStats;
+
+// resultado do is_directory por modelo; esquecido quando o ini  recarregado e quando o
+// hot reload aplica trocas (pastas podem ter sido criadas/removidas entretanto)
+static std::map<int, bool> g_vsfxModelCache;
+static unsigned int g_vsfxModelCacheGeneration = 0;
+
+// o modelo tem pasta vsfx? (o banco pode ainda no estar carregado)
+static bool IsVsfxModel(int modelId) {
+    if (BankRegistry::Slot* s = g_modelBanks.Find(modelId)) {
+        int state = s->state.load(std::memory_order_acquire);
+        if (state == BANK_READY || state == BANK_LOADING) return true;
+        if (state == BANK_MISSING) return false;
+    }
+    if (g_vsfxModelCacheGeneration != g_configGeneration) {
+        g_vsfxModelCache.clear();
+        g_vsfxModelCacheGeneration = g_configGeneration;
+    }
+    auto it = g_vsfxModelCache.find(modelId);
+    if (it != g_vsfxModelCache.end()) return it->second;
+    std::error_code ec;
+    bool has = fs::is_directory(g_basePath + "\\" + std::to_string(modelId), ec);
+    g_vsfxModelCache[modelId] = has;
+    return has;
+}
+
+static void SuppressGameEngine(CVehicle* veh, const char* why) {
+    if (!g_gameAudioHooks || !veh) return;
+    CAEVehicleAudioEntity* va = &veh->m_vehicleAudio;
+    if (g_suppressedEngines.count(va)) return;
+    g_suppressedEngines[va] = veh->m_nModelIndex;
+    ++g_gameEngineStats.suppressedEntities;
+    WriteLog("GameEngineAudio: suppressing engine of model=%d (%s)", veh->m_nModelIndex, why);
+}
+
+static void ReleaseGameEngine(CVehicle* veh) {
+    if (veh) g_suppressedEngines.erase(&veh->m_vehicleAudio);
+}
+
+// o original de uma entidade registada corre na mesma; conta quanto custou e se deixou um
+// banco do motor atribudo (o pedido ao loader do jogo que no conseguimos evitar)
+template<class F> static void RunEngineSetup(CAEVehicleAudioEntity* self, F original) {
+    bool suppressed = g_suppressedEngines.count(self) != 0;
+    auto t0 = std::chrono::steady_clock::now();
+    original();
+    if (!suppressed) return;
+    g_gameEngineStats.setupUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    ++g_gameEngineStats.setupCalls;
+    if (self->m_nEngineBankSlotId != (short)-1 || self->m_nEngineAccelerateSoundBankId != (short)-1 || self->m_nEngineDecelerateSoundBankId != (short)-1)
+        ++g_gameEngineStats.setupBankRequests;
+}
+
+static void __fastcall HookAEInitialise(CAEVehicleAudioEntity* self, void* edx, CEntity* entity) {
+    g_suppressedEngines.erase(self);
+    // reinicializao de um veculo que j tem instncia vsfx: registado antes do original
+    CVehicle* veh = static_cast<CVehicle*>(entity);
+    auto it = veh ? g_vehicleInstances.find(veh) : g_vehicleInstances.end();
+    bool vsfx = it != g_vehicleInstances.end() && it->second.bank;
+    if (vsfx) SuppressGameEngine(veh, "re-initialised");
+    RunEngineSetup(self, [&] { g_origAEInitialise(self, edx, entity); });
+    if (vsfx) MuteGameVehicleAudio(veh);
+}
+
+static void __fastcall HookAEJustGotInAsDriver(CAEVehicleAudioEntity* self, void* edx) {
+    // o player vai conduzir: se o modelo tem vsfx fica registado antes do original, e o
+    // ProcessPlayerVehicleEngine nunca chega a correr para ele
+    CVehicle* veh = static_cast<CVehicle*>(self->m_pEntity);
+    if (veh && IsVsfxModel(veh->m_nModelIndex)) SuppressGameEngine(veh, "player got in");
+    RunEngineSetup(self, [&] { g_origAEJustGotInAsDriver(self, edx); });
+}
+
+static void ProcessGameEngine(AEVehicleEngineFn orig, CAEVehicleAudioEntity* self, void* edx, cVehicleParams* params) {
+    if (g_suppressedEngines.count(self)) {
+        ++g_gameEngineStats.suppressedCalls;
+        return;
+    }
+    auto t0 = std::chrono::steady_clock::now();
+    orig(self, edx, params);
+    g_gameEngineStats.processedUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+    ++g_gameEngineStats.processedCalls;
+}
+
+static void __fastcall HookAEProcessPlayerEngine(CAEVehicleAudioEntity* self, void* edx, cVehicleParams* params) {
+    ProcessGameEngine(g_origAEProcessPlayerEngine, self, edx, params);
+}
+
+// ---- MinHook: um grupo de hooks entra todo ou nenhum ----
+struct GameHook {
+    uintptr_t addr;
+    void* detour;
+    void** original;
+    const char* name;
+};
+
+static bool g_minHookReady = false;
+
+static bool InstallHookGroup(const GameHook* hooks, int count, const char* group) {
+    if (!g_minHookReady) {
+        if (MH_Initialize() != MH_OK) { WriteLog("%s: MH_Initialize failed", group); return false; }
+        g_minHookReady = true;
+    }
+    int created = 0;
+    for (; created < count; ++created) {
+        const GameHook& h = hooks[created];
+        MH_STATUS st = MH_CreateHook(reinterpret_cast<LPVOID>(h.addr), h.detour, reinterpret_cast<LPVOID*>(h.original));
+        if (st != MH_OK) { WriteLog("%s: %s at 0x%X failed (%d)", group, h.name, (unsigned int)h.addr, (int)st); break; }
+        if (MH_EnableHook(reinterpret_cast<LPVOID>(h.addr)) != MH_OK) {
+            WriteLog("%s: enabling %s failed", group, h.name);
+            MH_RemoveHook(reinterpret_cast<LPVOID>(h.addr));
+            break;
+        }
+    }
+    if (created == count) return true;
+    for (int i = 0; i < created; ++i) MH_RemoveHook(reinterpret_cast<LPVOID>(hooks[i].addr));
+    return false;
+}
+
+static void ShutdownMinHook() {
+    if (!g_minHookReady) return;
+    MH_DisableHook(MH_ALL_HOOKS);
+    MH_Uninitialize();
+    g_minHookReady = false;
+}
+
+static void InstallGameAudioHooks() {
+    if (GetConfig("SuppressGameEngineAudio", 1.0f) == 0.0f) return;
+    static const GameHook hooks[] = {
+        { ADDR_AEVEHICLE_INITIALISE, (void*)&HookAEInitialise, (void**)&g_origAEInitialise, "Initialise" },
+        { ADDR_AEVEHICLE_JUST_GOT_IN_AS_DRIVER, (void*)&HookAEJustGotInAsDriver, (void**)&g_origAEJustGotInAsDriver, "JustGotInVehicleAsDriver" },
+        { ADDR_AEVEHICLE_PROCESS_PLAYER_ENGINE, (void*)&HookAEProcessPlayerEngine, (void**)&g_origAEProcessPlayerEngine, "ProcessPlayerVehicleEngine" },
+    };
+    if (!InstallHookGroup(hooks, (int)std::size(hooks), "InstallGameAudioHooks")) {
+        WriteLog("InstallGameAudioHooks: disabled, falling back to muting after the game starts its engine sounds");
+        return;
+    }
+    g_gameAudioHooks = true;
+    WriteLog("InstallGameAudioHooks: player engine audio of vsfx vehicles is suppressed at the source");
+}
+
+static void RemoveGameAudioHooks() {
+    g_gameAudioHooks = false;
+    g_suppressedEngines.clear();
+}
+
+static void LogGameEngineAudio(const char* when) {
+    if (!g_gameAudioHooks) return;
+    const GameEngineAudioStats& s = g_gameEngineStats;
+    double avgUs = s.processedCalls ? s.processedUs / double(s.processedCalls) : 0.0;
+    WriteLog("GameEngineAudio (%s): game engine %.2f us/vehicle/call over %llu calls; suppressed %llu calls on %d vehicles (%u total) ~%.1f ms CPU saved",
+        when, avgUs, s.processedCalls, s.suppressedCalls, (int)g_suppressedEngines.size(), s.suppressedEntities, avgUs * double(s.suppressedCalls) / 1000.0);
+    if (s.setupCalls)
+        WriteLog("GameEngineAudio (%s): setup still ran on suppressed vehicles: %llu Initialise/JustGotInVehicleAsDriver calls, %.1f us, %llu left an engine bank requested",
+            when, s.setupCalls, s.setupUs, s.setupBankRequests);
+}
+
 // ---------------- thresholds ----------------
 static const float IDLE_SPEED_THRESHOLD = 0.01f; // detecta movimento cedo
 static const float PAD_ACCEL_THRESHOLD_SHORT = 10; // threshold para pad
@@ -433,55 +2414,119 @@ static bool IsVehicleValidForAudio(CVehicle* veh) {
     return true;
 }
 
-static void EnsureLoopPlaying(VehicleAudioInstance& inst, const std::string& loopKey, int gearForPitch) {
-    CVehicle* veh = inst.vehicle;
-    if (!veh || !inst.bank) return;
+// decide se um overlay pode tocar agora (cooldown, som presente, pausa).
+// No toca no FMOD: roda no clculo por instncia; quem toca  PlayOverlay.
+// O cooldown  um prazo na roda (CooldownTimer), armado por quem dispara.
+static bool OverlayReady(const VehicleAudioInstance& inst, SoundSlot slot, bool paused) {
+    if (!inst.bank) return false;
+    if (inst.timersActive & (1u << CooldownTimer(slot))) return false;
+    if (!inst.bank->Has(slot)) return false;
+    if (paused) return false;
+    return true;
+}
 
-    bool already = (inst.loopMode == LM_IDLE && loopKey == "idle") || (inst.loopMode == LM_GEAR && loopKey == "engine");
-    if (already && inst.loopChannel) return;
+// ---------------- instance timers ----------------
+// A roda pertence ao thread do jogo: o clculo por instncia (paralelo) s liga o bit e
+// pede o prazo nos comandos; a submisso arma-o (ArmInstanceTimers). Os callbacks correm
+// no Advance do incio da frame, antes do clculo.
+static TimerWheel g_instanceTimers;
+static const unsigned int RELEASE_HOLD_MS = 1500;  // loop de marcha mantido aps soltar o acelerador
+static const float DORMANT_PITCH_EPS = 0.002f;     // loop "convergido" para a dormncia
+static const float DORMANT_VOLUME_EPS = 0.002f;
+
+static void OnInstanceTimer(void* ctx, uint32_t timer, uint32_t) {
+    VehicleAudioInstance& inst = *static_cast<VehicleAudioInstance*>(ctx);
+    inst.timerHandle[timer] = 0;
+    inst.timersActive &= ~(1u << timer);
+    if (timer == IT_SHIFT_DROP) inst.shiftPitchDrop = 0.0f;
+    else if (timer == IT_SETTLE) inst.sleepPending = true;
+}
 
-    StopChannelSafe(inst.loopChannel);
+static void ArmInstanceTimer(TimerWheel& wheel, VehicleAudioInstance& inst, InstanceTimer timer, uint32_t delayMs, uint32_t nowMs) {
+    if (inst.timerHandle[timer]) wheel.Cancel(inst.timerHandle[timer]);
+    inst.timerHandle[timer] = wheel.Schedule(nowMs, delayMs, OnInstanceTimer, &inst, timer);
+    inst.timersActive |= 1u << timer;
+}
 
-    auto it = inst.bank->sounds.find(loopKey);
-    if (it == inst.bank->sounds.end()) {
-        WriteLog("EnsureLoopPlaying: missing '%s' for model=%d", loopKey.c_str(), veh->m_nModelIndex);
-        inst.loopMode = LM_NONE;
-        return;
-    }
-    FMOD::Sound* s = it->second;
+static void CancelInstanceTimer(TimerWheel& wheel, VehicleAudioInstance& inst, InstanceTimer timer) {
+    if (inst.timerHandle[timer]) wheel.Cancel(inst.timerHandle[timer]);
+    inst.timerHandle[timer] = 0;
+    inst.timersActive &= ~(1u << timer);
+}
 
-    int gIndex = std::clamp(gearForPitch <= 0 ? 1 : gearForPitch, 1, 5);
-    float startPitch = START_PITCH_PER_GEAR[gIndex];
+// antes de a instncia sair do mapa: a roda guarda o ponteiro
+static void CancelInstanceTimers(TimerWheel& wheel, VehicleAudioInstance& inst) {
+    for (int t = 0; t < IT_COUNT; ++t) CancelInstanceTimer(wheel, inst, (InstanceTimer)t);
+}
 
-    inst.loopChannel = PlayLoop(veh, s, inst.currentVolume, startPitch);
-    if (!inst.loopChannel) {
-        inst.loopMode = LM_NONE;
-        WriteLog("EnsureLoopPlaying: not started (possibly paused) '%s' model=%d", loopKey.c_str(), veh->m_nModelIndex);
-        return;
-    }
-    inst.currentPitch = startPitch;
-    inst.loopMode = (loopKey == "idle") ? LM_IDLE : LM_GEAR;
+static void StartWindFade(TimerWheel& wheel, VehicleAudioInstance& inst, unsigned int nowMs) {
+    inst.windStartMs = nowMs;
+    if (WIND_FADE_MS > 0.0f) ArmInstanceTimer(wheel, inst, IT_WIND_FADE, (uint32_t)WIND_FADE_MS, nowMs);
+    else CancelInstanceTimer(wheel, inst, IT_WIND_FADE);
+}
 
-    WriteLog("EnsureLoopPlaying: started '%s' model=%d gear=%d pitch=%.2f", loopKey.c_str(), veh->m_nModelIndex, gIndex, startPitch);
+// latncia por modo de update: frames e ms entre o jogo mudar de marcha e o playSound do shiftup
+struct ShiftLatencyStats {
+    unsigned int count = 0;
+    double sumFrames = 0.0;
+    double sumMs = 0.0;
+    double maxMs = 0.0;
+};
+static ShiftLatencyStats g_shiftLatency[2];  // [0] scripts, [1] physics
+
+static void RecordShiftLatency(VehicleAudioInstance& inst, int modelIndex) {
+    if (!inst.gearChangePending) return;
+    inst.gearChangePending = false;
+    unsigned int frames = CTimer::m_FrameCounter - inst.gearChangeFrame;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - inst.gearChangeTime).count();
+    ShiftLatencyStats& s = g_shiftLatency[UPDATE_IN_PHYSICS ? 1 : 0];
+    ++s.count;
+    s.sumFrames += frames;
+    s.sumMs += ms;
+    s.maxMs = std::max(s.maxMs, ms);
+    WriteLog("Latency (%s): model=%d gear change -> shiftup playSound %u frames %.2f ms (avg %.2f frames %.2f ms, max %.2f ms over %u)",
+        UPDATE_IN_PHYSICS ? "physics" : "scripts", modelIndex, frames, ms, s.sumFrames / s.count, s.sumMs / s.count, s.maxMs, s.count);
 }
 
-static void PlayOverlayOnceIfReady(VehicleAudioInstance& inst, const std::string& key, unsigned int& lastMs, unsigned int cooldownMs) {
-    CVehicle* veh = inst.vehicle;
-    if (!veh || !inst.bank) return;
-    unsigned int now = CTimer::m_snTimeInMilliseconds;
-    if ((now - lastMs) < cooldownMs) return;
-    auto it = inst.bank->sounds.find(key);
-    if (it == inst.bank->sounds.end()) return;
-    FMOD::Sound* s = it->second;
-    if (IsGamePaused()) return;
-    FMOD::Channel* ch = PlayOneShot(veh, s, 1.0f, 1.0f);
+static void PlayOverlay(VehicleAudioInstance& inst, const AudioEmitter& em, SoundSlot slot) {
+    if (!inst.bank) return;
+    FMOD::Channel* ch = PlayOneShot(em.pos, em.vel, inst.bank->slots[slot], 1.0f, BankGain(inst.bank, slot));
     if (ch) {
         // armazena o channel para podermos parar/mutar mais tarde
-        if (key == "shiftup" || key == "shiftdn") inst.shiftChannel = ch;
+        if (slot == SND_SHIFTUP || slot == SND_SHIFTDN) inst.shiftChannel = ch;
         else inst.attackChannel = ch;
+        if (slot == SND_SHIFTUP) RecordShiftLatency(inst, em.modelIndex);
+    }
+    WriteLog("PlayOverlay: played '%s' for model=%d", s_names[slot], em.modelIndex);
+}
+
+// (re)inicia o loop pedido pelo clculo; em falha o modo fica LM_NONE e tenta-se de novo no prximo frame
+static inline SoundSlot LoopSlot(LoopMode mode) { return (mode == LM_IDLE) ? SND_IDLE : SND_ENGINE; }
+
+static bool StartLoop(VehicleAudioInstance& inst, const AudioEmitter& em, LoopMode mode, int gIndex, float startPitch) {
+    if (!inst.bank) return false;
+    const char* name = s_names[LoopSlot(mode)];
+
+    StopChannelSafe(inst.loopChannel);
+
+    FMOD::Sound* s = inst.bank->slots[LoopSlot(mode)];
+    if (!s) {
+        WriteLog("StartLoop: missing '%s' for model=%d", name, em.modelIndex);
+        inst.loopMode = LM_NONE;
+        return false;
+    }
+
+    inst.loopChannel = PlayLoop(em.pos, em.vel, s, inst.currentVolume * BankGain(inst.bank, LoopSlot(mode)), startPitch);
+    if (!inst.loopChannel) {
+        inst.loopMode = LM_NONE;
+        WriteLog("StartLoop: not started (possibly paused) '%s' model=%d", name, em.modelIndex);
+        return false;
     }
-    lastMs = now;
-    WriteLog("PlayOverlayOnceIfReady: played '%s' for model=%d", key.c_str(), veh->m_nModelIndex);
+    inst.currentPitch = startPitch;
+    inst.loopMode = mode;
+
+    WriteLog("StartLoop: started '%s' model=%d gear=%d pitch=%.2f", name, em.modelIndex, gIndex, startPitch);
+    return true;
 }
 
 // helper: tenta carregar a txd/texture (chame isto em InitFMOD)
@@ -555,362 +2600,1972 @@ static void DrawFMODLogoIfNeeded() {
     }
 }
 
+// ---------------- smoothing batch (SoA) ----------------
+// A parte numrica do smoothing (pitch, shift drop, volume, wind)  acumulada
+// em structure-of-arrays durante UpdateInstance e processada de uma vez por um
+// kernel SSE2/AVX2 (escolhido em runtime); depois ApplySmoothingBatch envia ao FMOD.
+struct SmoothingBatch {
+    int count = 0;
+    float minPitch = 0.5f;
+    float maxPitch = 2.0f;
+
+    // pitch: estado + alvo + taxa
+    std::vector<float> currentPitch, desiredPitch, pitchAlpha;
+    // shift drop transiente: amplitude e progresso 0..1
+    std::vector<float> shiftDrop, shiftT;
+    // volume do loop
+    std::vector<float> currentVolume, desiredVolume, volumeAlpha;
+    // wind: estado, alvo j com fade-in, cap por-frame (0 = sem wind)
+    std::vector<float> currentWind, desiredWind, windMaxDelta;
+    // sada
+    std::vector<float> displayPitch;
+
+    std::vector<VehicleAudioInstance*> owner;
+
+    // uma lane por instncia do frame; lanes com owner nulo so ignoradas na submisso
+    void Resize(int n) {
+        if ((size_t)n > owner.size()) {
+            size_t cap = ((size_t)n + 63) & ~(size_t)63;
+            for (std::vector<float>* v : { &currentPitch, &desiredPitch, &pitchAlpha, &shiftDrop, &shiftT,
+                &currentVolume, &desiredVolume, &volumeAlpha, &currentWind, &desiredWind, &windMaxDelta, &displayPitch }) {
+                v->resize(cap, 0.0f);
+            }
+            owner.resize(cap, nullptr);
+        }
+        count = n;
+        std::fill(owner.begin(), owner.begin() + n, nullptr);
+    }
+};
+
+static SmoothingBatch g_smoothBatch;
+
+static void SmoothKernelScalar(SmoothingBatch& b, int begin, int end) {
+    for (int i = begin; i < end; ++i) {
+        // atualiza pitch com blend; segurana: no permitir pitch absurdo
+        float p = b.currentPitch[i] + (b.desiredPitch[i] - b.currentPitch[i]) * b.pitchAlpha[i];
+        p = std::min(std::max(p, b.minPitch), b.maxPitch);
+        b.currentPitch[i] = p;
+
+        // decay suavizado (ease-out): (1 - t)^2
+        float k = 1.0f - b.shiftT[i];
+        b.displayPitch[i] = p + b.shiftDrop[i] * (k * k);
+
+        b.currentVolume[i] = b.currentVolume[i] + (b.desiredVolume[i] - b.currentVolume[i]) * b.volumeAlpha[i];
+
+        // wind: cap por-frame (no ultrapassar maxDelta)
+        float diff = b.desiredWind[i] - b.currentWind[i];
+        diff = std::min(std::max(diff, -b.windMaxDelta[i]), b.windMaxDelta[i]);
+        b.currentWind[i] += diff;
+    }
+}
+
+static void SmoothKernelSSE2(SmoothingBatch& b, int begin, int end) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minP = _mm_set1_ps(b.minPitch);
+    const __m128 maxP = _mm_set1_ps(b.maxPitch);
+    const __m128 zero = _mm_setzero_ps();
+    int i = begin;
+    for (; i + 4 <= end; i += 4) {
+        __m128 cur = _mm_loadu_ps(&b.currentPitch[i]);
+        __m128 p = _mm_add_ps(cur, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.desiredPitch[i]), cur), _mm_loadu_ps(&b.pitchAlpha[i])));
+        p = _mm_min_ps(_mm_max_ps(p, minP), maxP);
+        _mm_storeu_ps(&b.currentPitch[i], p);
+
+        __m128 k = _mm_sub_ps(one, _mm_loadu_ps(&b.shiftT[i]));
+        _mm_storeu_ps(&b.displayPitch[i], _mm_add_ps(p, _mm_mul_ps(_mm_loadu_ps(&b.shiftDrop[i]), _mm_mul_ps(k, k))));
+
+        __m128 vol = _mm_loadu_ps(&b.currentVolume[i]);
+        vol = _mm_add_ps(vol, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(&b.desiredVolume[i]), vol), _mm_loadu_ps(&b.volumeAlpha[i])));
+        _mm_storeu_ps(&b.currentVolume[i], vol);
+
+        __m128 wind = _mm_loadu_ps(&b.currentWind[i]);
+        __m128 md = _mm_loadu_ps(&b.windMaxDelta[i]);
+        __m128 diff = _mm_sub_ps(_mm_loadu_ps(&b.desiredWind[i]), wind);
+        diff = _mm_min_ps(_mm_max_ps(diff, _mm_sub_ps(zero, md)), md);
+        _mm_storeu_ps(&b.currentWind[i], _mm_add_ps(wind, diff));
+    }
+    SmoothKernelScalar(b, i, end);
+}
+
+VSFX_AVX2_TARGET static void SmoothKernelAVX2(SmoothingBatch& b, int begin, int end) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 minP = _mm256_set1_ps(b.minPitch);
+    const __m256 maxP = _mm256_set1_ps(b.maxPitch);
+    const __m256 zero = _mm256_setzero_ps();
+    int i = begin;
+    for (; i + 8 <= end; i += 8) {
+        __m256 cur = _mm256_loadu_ps(&b.currentPitch[i]);
+        __m256 p = _mm256_add_ps(cur, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&b.desiredPitch[i]), cur), _mm256_loadu_ps(&b.pitchAlpha[i])));
+        p = _mm256_min_ps(_mm256_max_ps(p, minP), maxP);
+        _mm256_storeu_ps(&b.currentPitch[i], p);
+
+        __m256 k = _mm256_sub_ps(one, _mm256_loadu_ps(&b.shiftT[i]));
+        _mm256_storeu_ps(&b.displayPitch[i], _mm256_add_ps(p, _mm256_mul_ps(_mm256_loadu_ps(&b.shiftDrop[i]), _mm256_mul_ps(k, k))));
+
+        __m256 vol = _mm256_loadu_ps(&b.currentVolume[i]);
+        vol = _mm256_add_ps(vol, _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(&b.desiredVolume[i]), vol), _mm256_loadu_ps(&b.volumeAlpha[i])));
+        _mm256_storeu_ps(&b.currentVolume[i], vol);
+
+        __m256 wind = _mm256_loadu_ps(&b.currentWind[i]);
+        __m256 md = _mm256_loadu_ps(&b.windMaxDelta[i]);
+        __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(&b.desiredWind[i]), wind);
+        diff = _mm256_min_ps(_mm256_max_ps(diff, _mm256_sub_ps(zero, md)), md);
+        _mm256_storeu_ps(&b.currentWind[i], _mm256_add_ps(wind, diff));
+    }
+    _mm256_zeroupper();
+    SmoothKernelSSE2(b, i, end);
+}
+
+typedef void (*SmoothKernelFn)(SmoothingBatch&, int, int);
+
+static SmoothKernelFn SelectSmoothKernel(const char** name) {
+    CpuFeatures cpu = DetectCpuFeatures();
+    if (cpu.avx2) { *name = "AVX2"; return SmoothKernelAVX2; }
+    if (cpu.sse2) { *name = "SSE2"; return SmoothKernelSSE2; }
+    *name = "scalar";
+    return SmoothKernelScalar;
+}
+
+static SmoothKernelFn g_smoothKernel = nullptr;
+
+static void RunSmoothingKernel(SmoothingBatch& b) {
+    if (!g_smoothKernel) {
+        const char* name = "";
+        g_smoothKernel = SelectSmoothKernel(&name);
+        WriteLog("RunSmoothingKernel: using %s kernel", name);
+    }
+    b.minPitch = MIN_PITCH;
+    b.maxPitch = TARGET_PITCH + MAX_OVERSHOOT;
+    g_smoothKernel(b, 0, b.count);
+}
+
+// ---------------- worker pool ----------------
+// Pool pequeno com work-stealing: cada thread tem a sua fila de faixas [begin,end),
+// tira da frente da prpria fila e rouba do fim das outras. O thread que chama
+// ParallelFor tambm trabalha e s retorna quando todas as faixas terminaram.
+class WorkStealingPool {
+public:
+    typedef std::function<void(int, int)> RangeFn;
+
+    ~WorkStealingPool() { Stop(); }
+
+    void Start(int workerCount) {
+        Stop();
+        m_stop = false;
+        m_queues.clear();
+        for (int i = 0; i <= workerCount; ++i) m_queues.emplace_back(new RangeQueue());
+        for (int i = 0; i < workerCount; ++i) m_workers.emplace_back([this, i] { WorkerMain(i); });
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lk(m_wakeMutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread& t : m_workers) if (t.joinable()) t.join();
+        m_workers.clear();
+    }
+
+    // inclui o thread chamador
+    int ThreadCount() const { return (int)m_workers.size() + 1; }
+
+    void ParallelFor(int count, int grain, const RangeFn& fn) {
+        if (count <= 0) return;
+        if (m_workers.empty() || count <= grain) { fn(0, count); return; }
+
+        int chunks = (count + grain - 1) / grain;
+        m_job = &fn;
+        m_pending.store(chunks, std::memory_order_relaxed);
+        // distribui em round-robin; o chamador fica com a ltima fila
+        for (int c = 0; c < chunks; ++c) {
+            RangeQueue& q = *m_queues[c % m_queues.size()];
+            std::lock_guard<std::mutex> lk(q.m);
+            q.ranges.emplace_back(c * grain, std::min(count, (c + 1) * grain));
+        }
+        {
+            std::lock_guard<std::mutex> lk(m_wakeMutex);
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        int self = (int)m_queues.size() - 1;
+        while (m_pending.load(std::memory_order_acquire) > 0) {
+            if (!RunOne(self)) std::this_thread::yield();
+        }
+        m_job = nullptr;
+    }
+
+private:
+    struct RangeQueue {
+        std::mutex m;
+        std::deque<std::pair<int, int>> ranges;
+    };
+
+    bool Pop(int idx, std::pair<int, int>& out, bool front) {
+        RangeQueue& q = *m_queues[idx];
+        std::lock_guard<std::mutex> lk(q.m);
+        if (q.ranges.empty()) return false;
+        if (front) { out = q.ranges.front(); q.ranges.pop_front(); }
+        else { out = q.ranges.back(); q.ranges.pop_back(); }
+        return true;
+    }
+
+    bool RunOne(int self) {
+        std::pair<int, int> r;
+        bool found = Pop(self, r, true);
+        for (size_t k = 1; !found && k < m_queues.size(); ++k) {
+            found = Pop((int)((self + k) % m_queues.size()), r, false);
+        }
+        if (!found) return false;
+        (*m_job)(r.first, r.second);
+        m_pending.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    void WorkerMain(int idx) {
+        unsigned int seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(m_wakeMutex);
+                m_wake.wait(lk, [&] { return m_stop || m_generation != seen; });
+                if (m_stop) return;
+                seen = m_generation;
+            }
+            while (RunOne(idx)) {}
+        }
+    }
+
+    std::vector<std::unique_ptr<RangeQueue>> m_queues;
+    std::vector<std::thread> m_workers;
+    std::mutex m_wakeMutex;
+    std::condition_variable m_wake;
+    unsigned int m_generation = 0;
+    bool m_stop = false;
+    std::atomic<int> m_pending{ 0 };
+    const RangeFn* m_job = nullptr;
+};
+
+static WorkStealingPool g_workerPool;
+static bool g_workerPoolStarted = false;
+static int PARALLEL_MIN_INSTANCES = 32; // abaixo disto o clculo roda em srie
+static const int PARALLEL_GRAIN = 8;
+
+// WorkerThreads=0 -> hardware_concurrency - 1 (mx. 7); 1 desliga o pool
+static void EnsureWorkerPool() {
+    if (g_workerPoolStarted) return;
+    g_workerPoolStarted = true;
+    int threads = (int)GetConfig("WorkerThreads", 0.0f);
+    if (threads <= 0) threads = std::clamp((int)std::thread::hardware_concurrency(), 1, 8);
+    PARALLEL_MIN_INSTANCES = (int)GetConfig("ParallelMinInstances", 32.0f);
+    g_workerPool.Start(threads - 1);
+    WriteLog("EnsureWorkerPool: %d threads (min instances %d)", g_workerPool.ThreadCount(), PARALLEL_MIN_INSTANCES);
+}
+
 // ---------------- Update per-vehicle ----------------
-static void UpdateInstance(VehicleAudioInstance& inst) {
+// O update de cada instncia tem trs fases:
+//  1. GatherInputs (thread principal): l o jogo, carrega banco/perfil;
+//  2. ComputeInstance (pool): mquina de estados pura, no toca no FMOD nem no jogo;
+//  3. SubmitInstance (thread principal, em ordem): aplica os comandos e o batch no FMOD.
+// Como o clculo s depende das entradas e do estado da prpria instncia,
+// o resultado  o mesmo com qualquer nmero de threads.
+
+struct InstanceInputs {
+    bool active = false;       // h banco/perfil e o veculo  vlido
+    bool stopAll = false;      // veculo no  vlido para audio -> parar canais
+    uintptr_t vehKey = 0;      // ponteiro do veculo (semente do roll de backfire)
+    int modelIndex = -1;
+    AudioEmitter emitter;
+    bool padPressed = false;
+    bool gasPressed = false;
+    int gear = 0;
+    float speed = 0.0f;
+    float gearMax = 0.0f;      // s diagnstico/trace; o clculo usa o perfil
+    float wheelSpin = 0.0f;
+    float timeStep = 0.0f;
+    unsigned int nowMs = 0;
+    bool paused = false;
+};
+
+// eventos s para log (emitidos na submisso, em ordem determinstica)
+enum InstanceEvent {
+    IE_ACCEL_START = 1 << 0,
+    IE_ACCEL_RELEASE = 1 << 1,
+    IE_GEAR_CHANGE = 1 << 2,
+    IE_BACKFIRE_CHECK = 1 << 3,
+    IE_BACKFIRE_MISSING = 1 << 4,
+    IE_INITIAL_DROP = 1 << 5,
+};
+
+// ms_fTimeStep est em unidades de 1/50 s
+static const float GAME_TIMESTEP_HZ = 50.0f;
+
+// sinais derivados calculados uma vez por update; todos os consumidores
+// (backfire, escolha do loop, pitch, wind) leem daqui.
+// Derivadas so normalizadas pelo tempo, no por frame, para o
+// comportamento ser o mesmo a 30 ou 144 FPS.
+struct VehicleSignals {
+    float dtFrames = 0.0f;       // timeStep do jogo (1.0 = 1/50 s)
+    float dtSec = 0.0f;
+    float speed = 0.0f;          // cru, como lido do jogo
+    float filteredSpeed = 0.0f;  // passa-baixa com SIGNAL_SPEED_TAU_MS
+    float accel = 0.0f;          // derivada da velocidade filtrada, em speed/s
+    float ratio = 0.0f;          // proxy de RPM: velocidade / mx. da marcha, 0..1
+    bool throttle = false;       // pad ou pedal
+    bool throttlePressed = false;  // borda de subida nesta frame
+    bool throttleReleased = false; // borda de descida nesta frame
+    bool wheelspin = false;      // com histerese WHEELSPIN_ON/OFF
+};
+
+static void UpdateSignals(VehicleAudioInstance& inst, const InstanceInputs& in, const TransmissionProfile& prof, VehicleSignals& sig) {
+    sig = VehicleSignals();
+    sig.dtFrames = std::max(0.0f, in.timeStep);
+    sig.dtSec = sig.dtFrames / GAME_TIMESTEP_HZ;
+    sig.speed = in.speed;
+
+    if (!inst.signalsPrimed) {
+        inst.filteredSpeed = in.speed;
+        inst.lastSpeed = in.speed;
+        inst.signalsPrimed = true;
+    }
+    else if (SIGNAL_SPEED_TAU_MS > 0.0f) {
+        float k = 1.0f - std::exp(-(sig.dtSec * 1000.0f) / SIGNAL_SPEED_TAU_MS);
+        inst.filteredSpeed += (in.speed - inst.filteredSpeed) * k;
+    }
+    else {
+        inst.filteredSpeed = in.speed;
+    }
+    sig.filteredSpeed = inst.filteredSpeed;
+    // frame sem tempo (pausa) no tem derivada
+    sig.accel = (sig.dtSec > 0.0f) ? (inst.filteredSpeed - inst.lastSpeed) / sig.dtSec : 0.0f;
+    inst.lastSpeed = inst.filteredSpeed;
+
+    float gearMax = prof.gearMaxVelocity[ClampGear(prof, in.gear)];
+    sig.ratio = (gearMax > 0.0001f) ? std::clamp(sig.filteredSpeed / gearMax, 0.0f, 1.0f) : 0.0f;
+
+    sig.throttle = in.padPressed || in.gasPressed;
+    sig.throttlePressed = sig.throttle && !inst.wasAccelerating;
+    sig.throttleReleased = !sig.throttle && inst.wasAccelerating;
+    inst.wasAccelerating = sig.throttle;
+
+    inst.wheelspinActive = inst.wheelspinActive ? (in.wheelSpin > WHEELSPIN_OFF) : (in.wheelSpin > WHEELSPIN_ON);
+    sig.wheelspin = inst.wheelspinActive;
+}
+
+// ---------------- overlay rules ----------------
+// Quando tocam os sons one-shot, definido no ini (sem regras no ini valem as padro):
+//   OverlayRule<n> = <som>, <chance %>, <cooldown ms>, <condio> [& <condio> ...]
+//   som:      shiftup | shiftdn | backfire
+//   condio: <sinal> <op> <valor> (op: < <= > >= ==), <sinal> (verdadeiro) ou !<sinal>
+//   sinais:   speed accel ratio throttle pressed released sincerelease wheelspin spin gear gearup geardown
+// n vai de 1 a OVERLAY_MAX_RULES; por som vale a primeira regra (menor n) que casar na frame.
+// Ex.: OverlayRule6 = backfire, 50, 400, released & ratio > 0.9 & gear >= 3
+// Ao carregar, cada condio vira um intervalo aberto (lo, hi) sobre um sinal numa tabela
+// plana; por frame a avaliao  s comparar floats e juntar bits, sem parsing nem ramos
+// por tipo de condio.
+static const int OVERLAY_MAX_RULES = 64;
+static const float RULE_NEVER_RELEASED_MS = 1.0e9f;  // sincerelease fora da janela do ltimo release
+
+enum RuleSignal {
+    RS_SPEED = 0, RS_ACCEL, RS_RATIO, RS_THROTTLE, RS_PRESSED, RS_RELEASED, RS_SINCE_RELEASE,
+    RS_WHEELSPIN, RS_SPIN, RS_GEAR, RS_GEAR_UP, RS_GEAR_DOWN, RS_COUNT
+};
+static const char* const s_ruleSignalNames[RS_COUNT] = {
+    "speed", "accel", "ratio", "throttle", "pressed", "released", "sincerelease",
+    "wheelspin", "spin", "gear", "gearup", "geardown"
+};
+
+struct OverlayRuleTerm {
+    uint8_t signal;
+    float lo;   // exclusivo
+    float hi;   // exclusivo
+};
+
+struct OverlayRule {
+    uint16_t firstTerm;
+    uint8_t termCount;
+    uint8_t slot;
+    uint32_t threshold;   // dispara se o sorteio de 32 bits < threshold (UINT32_MAX = sempre, sem sorteio)
+    uint32_t cooldownMs;
+    uint8_t chance;       // % original, s para o log
+    uint8_t number;       // n da OverlayRule<n>
+};
+
+struct OverlayRuleTable {
+    std::vector<OverlayRuleTerm> terms;
+    std::vector<OverlayRule> rules;
+    uint64_t slotRules[SND_COUNT] = {};  // bit r = regra r toca este som
+    uint32_t releaseWindowMs = 0;        // maior limite finito de sincerelease + 1 (durao de IT_RELEASE_SIGNAL)
+    unsigned int configGeneration = 0;
+};
+static OverlayRuleTable g_overlayRules;
+
+static bool ParseRuleSignal(const std::string& name, uint8_t& signal) {
+    for (int s = 0; s < RS_COUNT; ++s) {
+        if (name == s_ruleSignalNames[s]) { signal = (uint8_t)s; return true; }
+    }
+    return false;
+}
+
+static bool ParseRuleCondition(const std::string& text, OverlayRuleTerm& term, std::string& err) {
+    const float inf = std::numeric_limits<float>::infinity();
+    std::string t = ToLower(Trim(text));
+    term.lo = -inf;
+    term.hi = inf;
+    if (!t.empty() && t[0] == '!') {
+        if (!ParseRuleSignal(Trim(t.substr(1)), term.signal)) { err = "sinal desconhecido em '" + t + "'"; return false; }
+        term.hi = 0.5f;
+        return true;
+    }
+    size_t op = t.find_first_of("<>=");
+    if (op == std::string::npos) {
+        if (!ParseRuleSignal(t, term.signal)) { err = "sinal desconhecido em '" + t + "'"; return false; }
+        term.lo = 0.5f;
+        return true;
+    }
+    if (!ParseRuleSignal(Trim(t.substr(0, op)), term.signal)) { err = "sinal desconhecido em '" + t + "'"; return false; }
+    std::string opText = t.substr(op, (op + 1 < t.size() && t[op + 1] == '=') ? 2 : 1);
+    float v = 0.0f;
+    try { v = std::stof(t.substr(op + opText.size())); }
+    catch (...) { err = "valor invlido em '" + t + "'"; return false; }
+    if (opText == "<") term.hi = v;
+    else if (opText == "<=") term.hi = std::nextafter(v, inf);
+    else if (opText == ">") term.lo = v;
+    else if (opText == ">=") term.lo = std::nextafter(v, -inf);
+    else if (opText == "==") { term.lo = std::nextafter(v, -inf); term.hi = std::nextafter(v, inf); }
+    else { err = "operador invlido em '" + t + "'"; return false; }
+    return true;
+}
+
+static bool CompileOverlayRule(int number, const std::string& text, OverlayRuleTable& table, std::string& err) {
+    // <som>, <chance>, <cooldown>, <condies>: as condies so o resto depois da 3 vrgula
+    std::string field[4];
+    size_t pos = 0;
+    for (int i = 0; i < 3; ++i) {
+        size_t comma = text.find(',', pos);
+        if (comma == std::string::npos) { err = "esperado <som>, <chance>, <cooldown>, <condio>"; return false; }
+        field[i] = Trim(text.substr(pos, comma - pos));
+        pos = comma + 1;
+    }
+    field[3] = text.substr(pos);
+
+    // s os sons one-shot: loops e wind tm lgica prpria
+    int slot = -1;
+    for (int s = SND_SHIFTUP; s <= SND_BACKFIRE; ++s) {
+        std::string name = s_names[s];
+        if (ToLower(field[0]) == name.substr(0, name.size() - 4)) slot = s;
+    }
+    if (slot < 0) { err = "som '" + field[0] + "' no  shiftup/shiftdn/backfire"; return false; }
+
+    float chance = 0.0f, cooldown = 0.0f;
+    try { chance = std::stof(field[1]); cooldown = std::stof(field[2]); }
+    catch (...) { err = "chance/cooldown invlidos"; return false; }
+    chance = std::clamp(chance, 0.0f, 100.0f);
+    cooldown = std::max(cooldown, 0.0f);
+
+    OverlayRule rule = {};
+    rule.firstTerm = (uint16_t)table.terms.size();
+    size_t begin = 0;
+    for (;;) {
+        size_t amp = field[3].find('&', begin);
+        OverlayRuleTerm term = {};
+        if (!ParseRuleCondition(field[3].substr(begin, amp == std::string::npos ? std::string::npos : amp - begin), term, err)) {
+            table.terms.resize(rule.firstTerm);
+            return false;
+        }
+        table.terms.push_back(term);
+        // a janela tem de passar do maior limite, inferior ou superior: com "sincerelease > 500"
+        // o valor real tem de ser visto at l e s depois vira RULE_NEVER_RELEASED_MS
+        if (term.signal == RS_SINCE_RELEASE) {
+            for (float bound : { term.lo, term.hi }) {
+                if (!std::isfinite(bound) || bound >= RULE_NEVER_RELEASED_MS) continue;
+                table.releaseWindowMs = std::max(table.releaseWindowMs, (uint32_t)std::ceil(std::max(bound, 0.0f)) + 1);
+            }
+        }
+        if (amp == std::string::npos) break;
+        begin = amp + 1;
+    }
+    rule.termCount = (uint8_t)std::min<size_t>(table.terms.size() - rule.firstTerm, 255);
+    rule.slot = (uint8_t)slot;
+    rule.threshold = (chance >= 100.0f) ? UINT32_MAX : (uint32_t)(double(chance) / 100.0 * 4294967296.0);
+    rule.cooldownMs = (uint32_t)cooldown;
+    rule.chance = (uint8_t)(chance + 0.5f);
+    rule.number = (uint8_t)number;
+    table.slotRules[slot] |= 1ull << table.rules.size();
+    table.rules.push_back(rule);
+    return true;
+}
+
+// regras padro: o comportamento clssico (troca de marcha, wheelspin, queda brusca, soltar o acelerador)
+static std::vector<std::string> DefaultOverlayRules() {
+    char heavy[96];
+    snprintf(heavy, sizeof(heavy), "backfire, 70, %u, accel < %g & ratio > 0.35", COOLDOWN_BACKFIRE_MS, BACKFIRE_DECEL_PER_SEC);
+    return {
+        "shiftup, 100, " + std::to_string(COOLDOWN_SHIFT_MS) + ", gearup",
+        "shiftdn, 100, " + std::to_string(COOLDOWN_SHIFT_MS) + ", geardown",
+        "backfire, 80, " + std::to_string(COOLDOWN_BACKFIRE_MS / 2) + ", wheelspin",
+        heavy,
+        "backfire, 30, " + std::to_string(COOLDOWN_BACKFIRE_MS) + ", sincerelease < 800 & ratio > 0.20",
+    };
+}
+
+static void CompileOverlayRules(OverlayRuleTable& table, const std::vector<std::pair<int, std::string>>& source) {
+    table.terms.clear();
+    table.rules.clear();
+    std::fill(std::begin(table.slotRules), std::end(table.slotRules), 0ull);
+    table.releaseWindowMs = 0;
+    for (const auto& src : source) {
+        std::string err;
+        if (!CompileOverlayRule(src.first, src.second, table, err))
+            WriteLog("OverlayRules: OverlayRule%d='%s' ignored (%s)", src.first, src.second.c_str(), err.c_str());
+    }
+}
+
+// recompila quando o ini muda; s no main thread, antes do clculo paralelo
+static void EnsureOverlayRules() {
+    if (g_overlayRules.configGeneration == g_configGeneration) return;
+    std::vector<std::pair<int, std::string>> source;
+    for (int n = 1; n <= OVERLAY_MAX_RULES; ++n) {
+        std::string text = GetConfigText("OverlayRule" + std::to_string(n));
+        if (!text.empty()) source.emplace_back(n, text);
+    }
+    bool defaults = source.empty();
+    if (defaults) {
+        std::vector<std::string> def = DefaultOverlayRules();
+        for (size_t i = 0; i < def.size(); ++i) source.emplace_back((int)i + 1, def[i]);
+    }
+    CompileOverlayRules(g_overlayRules, source);
+    g_overlayRules.configGeneration = g_configGeneration;
+    WriteLog("OverlayRules: %zu rules, %zu terms (%s)", g_overlayRules.rules.size(), g_overlayRules.terms.size(), defaults ? "defaults" : "ini");
+}
+
+static void FillRuleSignals(const VehicleAudioInstance& inst, const InstanceInputs& in, const VehicleSignals& sig, int gearStep, float* out) {
+    out[RS_SPEED] = sig.filteredSpeed;
+    out[RS_ACCEL] = sig.accel;
+    out[RS_RATIO] = sig.ratio;
+    out[RS_THROTTLE] = sig.throttle ? 1.0f : 0.0f;
+    out[RS_PRESSED] = sig.throttlePressed ? 1.0f : 0.0f;
+    out[RS_RELEASED] = sig.throttleReleased ? 1.0f : 0.0f;
+    out[RS_SINCE_RELEASE] = (inst.timersActive & (1u << IT_RELEASE_SIGNAL)) ? float(in.nowMs - inst.lastAccelReleaseMs) : RULE_NEVER_RELEASED_MS;
+    out[RS_WHEELSPIN] = sig.wheelspin ? 1.0f : 0.0f;
+    out[RS_SPIN] = in.wheelSpin;
+    out[RS_GEAR] = float(in.gear);
+    out[RS_GEAR_UP] = gearStep > 0 ? 1.0f : 0.0f;
+    out[RS_GEAR_DOWN] = gearStep < 0 ? 1.0f : 0.0f;
+}
+
+// bit r = todas as condies da regra r valem
+static uint64_t EvaluateOverlayRules(const OverlayRuleTable& table, const float* signals) {
+    const OverlayRuleTerm* terms = table.terms.data();
+    uint64_t matched = 0;
+    for (size_t r = 0; r < table.rules.size(); ++r) {
+        const OverlayRule& rule = table.rules[r];
+        unsigned int ok = 1;
+        for (const OverlayRuleTerm* t = terms + rule.firstTerm, *end = t + rule.termCount; t != end; ++t) {
+            float v = signals[t->signal];
+            ok &= (unsigned int)(v > t->lo) & (unsigned int)(v < t->hi);
+        }
+        matched |= uint64_t(ok) << r;
+    }
+    return matched;
+}
+
+// xorshift32, um stream por instncia semeado pelo ponteiro do veculo
+static inline uint32_t NextOverlayRandom(VehicleAudioInstance& inst, uintptr_t vehKey) {
+    uint32_t x = inst.rngState;
+    if (!x) {
+        uint64_t k = (uint64_t)vehKey;
+        x = (uint32_t)(k ^ (k >> 32));
+        x ^= x >> 16; x *= 0x85ebca6bu; x ^= x >> 13; x *= 0xc2b2ae35u; x ^= x >> 16;
+        x |= 1u;
+    }
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    inst.rngState = x;
+    return x;
+}
+
+struct InstanceCommands {
+    VehicleSignals signals;
+    unsigned int events = 0;
+    unsigned int overlays = 0;     // bit por SoundSlot a tocar
+    bool startLoop = false;
+    LoopMode loopMode = LM_NONE;
+    int loopGear = 1;
+    float loopStartPitch = 1.0f;
+    bool startWind = false;
+    bool hasLane = false;          // h lane vlida no batch de smoothing
+
+    // valores para os logs
+    int oldGear = 0;
+    float shiftDrop = 0.0f;
+    int roll = 0;
+    int chance = 0;
+    int rule = 0;                  // n da OverlayRule<n> que decidiu o backfire
+
+    // prazos a cancelar / (re)armar na submisso (ver instance timers)
+    unsigned int dropTimers = 0;
+    unsigned int armTimers = 0;
+    uint32_t timerDelayMs[IT_COUNT] = {};
+};
+
+// liga j o bit na instncia (o clculo desta frame v-o) e pede o prazo  submisso
+static void RequestInstanceTimer(VehicleAudioInstance& inst, InstanceCommands& cmd, InstanceTimer timer, uint32_t delayMs) {
+    inst.timersActive |= 1u << timer;
+    cmd.armTimers |= 1u << timer;
+    cmd.dropTimers &= ~(1u << timer);
+    cmd.timerDelayMs[timer] = delayMs;
+}
+
+static void DropInstanceTimer(VehicleAudioInstance& inst, InstanceCommands& cmd, InstanceTimer timer) {
+    inst.timersActive &= ~(1u << timer);
+    cmd.dropTimers |= 1u << timer;
+    cmd.armTimers &= ~(1u << timer);
+}
+
+static void ArmInstanceTimers(TimerWheel& wheel, VehicleAudioInstance& inst, const InstanceCommands& cmd, unsigned int nowMs) {
+    for (unsigned int m = cmd.dropTimers; m; m &= m - 1) CancelInstanceTimer(wheel, inst, (InstanceTimer)std::countr_zero(m));
+    for (unsigned int m = cmd.armTimers; m; m &= m - 1) {
+        int t = std::countr_zero(m);
+        ArmInstanceTimer(wheel, inst, (InstanceTimer)t, cmd.timerDelayMs[t], nowMs);
+    }
+}
+
+static void GatherInputs(VehicleAudioInstance& inst, InstanceInputs& in) {
+    in = InstanceInputs();
     CVehicle* veh = inst.vehicle;
     if (!veh) return;
 
     // Se veculo no  vlido para audio -> pra canais e sinaliza sem loop
     if (!IsVehicleValidForAudio(veh)) {
-        StopChannelSafe(inst.loopChannel);
-        StopChannelSafe(inst.pendingLoopChannel);
-        StopChannelSafe(inst.attackChannel);
-        StopChannelSafe(inst.shiftChannel);
-        StopChannelSafe(inst.windChannel);
-        inst.loopMode = LM_NONE;
+        in.stopAll = true;
         return;
     }
 
+    // lazy load bank & mute once; o perfil de transmisso  construdo ao anexar
+    if (!inst.bank) {
+        inst.bank = LoadBankForModel(veh->m_nModelIndex);
+        if (inst.bank && !inst.mutedGameAudio) {
+            MuteGameVehicleAudio(veh);
+            SuppressGameEngine(veh, "bank attached");
+            inst.mutedGameAudio = true;
+        }
+    }
+    // sem banco no h nada a tocar para este modelo
+    if (!inst.bank) return;
+
+    // gear table vem do perfil; por frame s lemos a velocidade atual
+    const TransmissionProfile& prof = EnsureTransmissionProfile(inst.bank, veh);
+    if (!prof.valid) return;
+
     // read inputs  s pega input do jogador se o jogador estiver dentro deste veculo
     CPad* pad = CPad::GetPad(0);
-    short padAccel = 0;
     CVehicle* playerVeh = FindPlayerVehicle(-1, true);
-    bool padPressed = false;
     if (veh == playerVeh && pad) {
-        padAccel = pad->GetAccelerate();
-        padPressed = (padAccel > (short)PAD_ACCEL_THRESHOLD_SHORT);
+        short padAccel = pad->GetAccelerate();
+        in.padPressed = (padAccel > (short)PAD_ACCEL_THRESHOLD_SHORT);
     }
-    unsigned int now = CTimer::m_snTimeInMilliseconds;
+    in.gasPressed = (veh->m_fGasPedal > GASPEDAL_ACCEL_THRESHOLD);
+
+    in.vehKey = (uintptr_t)veh;
+    in.modelIndex = veh->m_nModelIndex;
+    in.gear = (int)veh->m_nCurrentGear;
+    // o handling  partilhado por modelo: os outros carros usam a prpria velocidade
+    try { in.speed = (veh == playerVeh) ? ReadLiveSpeed(prof) : ReadVehicleSpeed(veh); }
+    catch (...) { in.speed = 0.0f; }
+    in.gearMax = prof.gearMaxVelocity[ClampGear(prof, in.gear)];
+    CVector pos = veh->GetPosition();
+    in.emitter.modelIndex = in.modelIndex;
+    in.emitter.pos = { pos.x, pos.y, pos.z };
+    in.emitter.vel = { veh->m_vecMoveSpeed.x, veh->m_vecMoveSpeed.y, veh->m_vecMoveSpeed.z };
+    in.wheelSpin = veh->m_fWheelSpinForAudio;
+    in.timeStep = CTimer::ms_fTimeStep;
+    in.nowMs = CTimer::m_snTimeInMilliseconds;
+    in.paused = IsGamePaused();
+    in.active = true;
+}
+
+static void ComputeInstance(VehicleAudioInstance& inst, const InstanceInputs& in, InstanceCommands& cmd, SmoothingBatch& b, int lane) {
+    cmd = InstanceCommands();
+    b.owner[lane] = nullptr;
+    if (!in.active) return;
+
+    const TransmissionProfile& prof = inst.bank->transmission;
+    unsigned int now = in.nowMs;
+    int gearNow = in.gear;
 
-    bool vehGasPressed = (veh->m_fGasPedal > GASPEDAL_ACCEL_THRESHOLD);
+    VehicleSignals& sig = cmd.signals;
+    UpdateSignals(inst, in, prof, sig);
+    float speed = sig.filteredSpeed;
+    float ratio = sig.ratio;
+    bool isAccelerating = sig.throttle;
 
     // detect accel release to create short window
-    if (padPressed || vehGasPressed) {
-        if (!inst.wasAccelerating) {
-            inst.wasAccelerating = true;
-            WriteLog("UpdateInstance: accel started model=%d", veh->m_nModelIndex);
+    if (sig.throttlePressed) cmd.events |= IE_ACCEL_START;
+    if (sig.throttleReleased) {
+        inst.lastAccelReleaseMs = now;
+        RequestInstanceTimer(inst, cmd, IT_RELEASE_HOLD, RELEASE_HOLD_MS);
+        if (g_overlayRules.releaseWindowMs) RequestInstanceTimer(inst, cmd, IT_RELEASE_SIGNAL, g_overlayRules.releaseWindowMs);
+        cmd.events |= IE_ACCEL_RELEASE;
+    }
+
+    // gear change overlays (one-shot) + transient start-of-gear reset
+    if (inst.lastGear == INT_MIN) inst.lastGear = gearNow;
+    int gearStep = gearNow - inst.lastGear;  // os overlays de troca vm das overlay rules (gearup/geardown)
+    if (gearNow != inst.lastGear) {
+        int oldGear = inst.lastGear;
+
+        // transient: pequeno drop grave para dar "thump" na troca (negativo = engrossa)
+        int gIdx = ClampGear(prof, gearNow);
+        float drop = prof.shiftDrop[gIdx];
+        inst.shiftPitchDrop = drop;
+        inst.shiftStartMs = now;
+        if (drop != 0.0f) RequestInstanceTimer(inst, cmd, IT_SHIFT_DROP, (uint32_t)std::max(SHIFT_DROP_DURATION_MS, 0));
+        else DropInstanceTimer(inst, cmd, IT_SHIFT_DROP);
+
+        // **IMPORTANTE**: reiniciar o pitch imediatamente para a base da marcha
+        //  isso faz a sensao "comear do 0" por marcha.
+        inst.currentPitch = prof.startPitch[gIdx] + 0.15f * (inst.currentPitch - prof.startPitch[gIdx]);
+        inst.desiredEnginePitch = inst.currentPitch; // garante consistncia com smoothing
+        inst.lastGear = gearNow;
+
+        cmd.events |= IE_GEAR_CHANGE;
+        cmd.oldGear = oldGear;
+        cmd.shiftDrop = drop;
+    }
+
+    // --- overlays one-shot (shiftup/shiftdn/backfire) pelas overlay rules ---
+    float ruleSignals[RS_COUNT];
+    FillRuleSignals(inst, in, sig, gearStep, ruleSignals);
+    uint64_t matched = EvaluateOverlayRules(g_overlayRules, ruleSignals);
+    for (int slot = SND_SHIFTUP; matched && slot <= SND_BACKFIRE; ++slot) {
+        uint64_t m = matched & g_overlayRules.slotRules[slot];
+        if (!m) continue;
+        const OverlayRule& rule = g_overlayRules.rules[std::countr_zero(m)];
+        if (!inst.bank->Has((SoundSlot)slot)) {
+            if (slot == SND_BACKFIRE) cmd.events |= IE_BACKFIRE_MISSING;
+            continue;
+        }
+        uint32_t roll = 0;
+        bool hit = true;
+        if (rule.threshold != UINT32_MAX) {
+            roll = NextOverlayRandom(inst, in.vehKey);
+            hit = roll < rule.threshold;
+        }
+        if (slot == SND_BACKFIRE) {
+            cmd.events |= IE_BACKFIRE_CHECK;
+            cmd.roll = (int)(((uint64_t)roll * 100u) >> 32);
+            cmd.chance = rule.chance;
+            cmd.rule = rule.number;
+        }
+        if (hit && OverlayReady(inst, (SoundSlot)slot, in.paused)) {
+            cmd.overlays |= 1u << slot;
+            if (rule.cooldownMs) RequestInstanceTimer(inst, cmd, CooldownTimer((SoundSlot)slot), rule.cooldownMs);
         }
     }
-    else {
-        if (inst.wasAccelerating) {
-            inst.wasAccelerating = false;
-            inst.lastAccelReleaseMs = now;
-            WriteLog("UpdateInstance: accel released model=%d at t=%u", veh->m_nModelIndex, now);
+
+    // decide desired loop:
+    // - se estamos acelerando (pad ou pedal) -> gear loop
+    // - se estamos em movimento (velocidade > threshold) -> gear loop
+    // - se parado -> idle
+    bool padRecentlyReleased = (inst.timersActive & (1u << IT_RELEASE_HOLD)) != 0;
+    bool wantGearLoop = (speed > IDLE_SPEED_THRESHOLD) || isAccelerating || (padRecentlyReleased && speed > 0.5f);
+
+    // drop inicial
+    if (gearNow == 1 && inst.lastGear == 1 && isAccelerating && !(inst.timersActive & (1u << IT_SHIFT_DROP))) {
+        inst.shiftPitchDrop = BASE_START_DROP;
+        inst.shiftStartMs = now;
+        RequestInstanceTimer(inst, cmd, IT_SHIFT_DROP, (uint32_t)std::max(SHIFT_DROP_DURATION_MS, 0));
+        cmd.events |= IE_INITIAL_DROP;
+    }
+
+    // loop pedido; se j est a tocar no modo certo nada muda, seno a submisso (re)inicia
+    int gIndex = ClampGear(prof, gearNow);
+    LoopMode wantLoop = wantGearLoop ? LM_GEAR : LM_IDLE;
+    float lanePitch = inst.currentPitch;
+    bool loopActive = (inst.loopMode == wantLoop && inst.loopChannel);
+    if (!loopActive) {
+        cmd.startLoop = true;
+        cmd.loopMode = wantLoop;
+        cmd.loopGear = gIndex;
+        cmd.loopStartPitch = prof.startPitch[gIndex];
+        // se o som existe assume-se que o loop arranca; se falhar a lane  ignorada
+        loopActive = inst.bank->Has(wantLoop == LM_IDLE ? SND_IDLE : SND_ENGINE);
+        lanePitch = cmd.loopStartPitch;
+    }
+    if (!loopActive) return;
+
+    // pitch/volume smoothing for active loop
+    // alvos de pitch/volume vm das tabelas assadas por marcha e modo
+    const ResponseTable& rt = prof.response[gIndex];
+    ResponseMode mode = isAccelerating ? RM_ACCEL : RM_DECEL;
+    inst.engineMode = isAccelerating ? VehicleAudioInstance::EM_ACCEL : VehicleAudioInstance::EM_DECEL;
+    inst.desiredEnginePitch = SampleResponse(rt.pitch[mode], ratio);
+
+    // smoothing: usa taxas diferentes para acelerao/desacelerao
+    // forma exponencial: duas frames de dt/2 do o mesmo resultado que uma de dt
+    // (o multiplicador entra no expoente: fora dele o alpha passava de 1 e deixava de
+    // ser invariante ao frame rate)
+    float dt = sig.dtFrames;
+    float baseAlpha = 1.0f - std::exp(-dt * PITCH_SMOOTHING);
+    float alpha = 1.0f - std::exp(-dt * PITCH_SMOOTHING * (isAccelerating ? ACCEL_SPEED_MULT : DECEL_SPEED_MULT));
+
+    // --- shift drop decay (transient): progresso 0..1, o decay em si roda no kernel ---
+    // (IT_SHIFT_DROP zera o drop quando vence)
+    float shiftT = 0.0f;
+    float shiftDrop = 0.0f;
+    if (inst.timersActive & (1u << IT_SHIFT_DROP)) {
+        shiftDrop = inst.shiftPitchDrop;
+        shiftT = (SHIFT_DROP_DURATION_MS > 0) ? std::min(1.0f, float(now - inst.shiftStartMs) / float(SHIFT_DROP_DURATION_MS)) : 1.0f;
+    }
+
+    // volume (curva do modo atual)
+    float desiredVol = SampleResponse(rt.volume[mode], ratio);
+
+    // --- WIND loop control (fade-in temporal + cap por-frame) ---
+    float desiredWithFade = 0.0f;
+    float windMaxDelta = 0.0f;
+    if (inst.bank->Has(SND_WIND)) {
+        // calcula target a partir de velocidade/ratio e if accelerating
+        float speedFactor = std::clamp(speed / WIND_SPEED_SCALE, 0.0f, 1.0f);
+        float accelBoost = isAccelerating ? 1.0f : 0.6f;
+        inst.targetWindVolume = WIND_MAX_VOL * speedFactor * accelBoost;
+
+        // cap por-frame
+        windMaxDelta = MAX_WIND_RATE_PER_SEC * dt; // ex: 0.25 * 0.016 = 0.004 por frame (~60fps)
+
+        // garante canal ativo (comea com volume 0): a submisso cria o canal e o fade-in parte de 0
+        float fadeFactor = 1.0f;
+        if (!inst.windChannel) {
+            cmd.startWind = true;
+            fadeFactor = 0.0f;
         }
+        else if (inst.timersActive & (1u << IT_WIND_FADE)) {
+            // fade-in em curso (canal novo ou despausa, ver StartWindFade)
+            fadeFactor = std::clamp(float(now - inst.windStartMs) / WIND_FADE_MS, 0.0f, 1.0f);
+        }
+
+        // desired volume considerando fade-in
+        desiredWithFade = inst.targetWindVolume * fadeFactor;
     }
 
-    // read speed & gear with safe access to offsets (mesma lgica tua)
-    int gearNow = (int)veh->m_nCurrentGear;
-    float speed = 0.0f;
-    float gearMax = 1.0f;
-    try {
-        uintptr_t vehPtr = reinterpret_cast<uintptr_t>(veh);
-        uintptr_t handlingPtrAddr = *(uintptr_t*)(vehPtr + 0x384);
-        if (handlingPtrAddr) {
-            uintptr_t transmissionPtr = handlingPtrAddr + 0x2C;
-            speed = *(float*)(transmissionPtr + 0x64);
-            uintptr_t gearEntry = transmissionPtr + (0x0C * (uintptr_t)std::max(1, gearNow));
-            float maybe = *(float*)(gearEntry + 0x4);
-            if (maybe > 0.0001f) gearMax = maybe;
+    // numrico vai para o batch; o kernel roda depois sobre todas as lanes
+    b.owner[lane] = &inst;
+    b.currentPitch[lane] = lanePitch;
+    b.desiredPitch[lane] = inst.desiredEnginePitch;
+    b.pitchAlpha[lane] = alpha;
+    b.shiftDrop[lane] = shiftDrop;
+    b.shiftT[lane] = shiftT;
+    b.currentVolume[lane] = inst.currentVolume;
+    b.desiredVolume[lane] = desiredVol;
+    b.volumeAlpha[lane] = baseAlpha;
+    b.currentWind[lane] = inst.currentWindVolume;
+    b.desiredWind[lane] = desiredWithFade;
+    b.windMaxDelta[lane] = windMaxDelta;
+    cmd.hasLane = true;
+
+    // quieta: parada, sem acelerador, mesma marcha, loop convergido, wind mudo e nenhum
+    // transiente a correr; assim durante DormantAfterMs -> adormece (ver dormant instances)
+    if (DORMANT_AFTER_MS <= 0.0f) return;
+    bool quiet = !isAccelerating && speed <= IDLE_SPEED_THRESHOLD && gearStep == 0 && !cmd.startLoop
+        && !(inst.timersActive & ~(1u << IT_SETTLE))
+        && std::fabs(inst.desiredEnginePitch - lanePitch) < DORMANT_PITCH_EPS
+        && std::fabs(desiredVol - inst.currentVolume) < DORMANT_VOLUME_EPS
+        && inst.currentWindVolume < WIND_STOP_THRESHOLD && desiredWithFade < WIND_STOP_THRESHOLD;
+    if (!quiet) {
+        inst.sleepPending = false;
+        if (inst.timersActive & (1u << IT_SETTLE)) DropInstanceTimer(inst, cmd, IT_SETTLE);
+    }
+    else if (!(inst.timersActive & (1u << IT_SETTLE)) && !inst.sleepPending) {
+        RequestInstanceTimer(inst, cmd, IT_SETTLE, (uint32_t)DORMANT_AFTER_MS);
+    }
+}
+
+// clculo de todas as instncias do frame (em paralelo quando h muitas)
+static void ComputeInstances(WorkStealingPool& pool, std::vector<VehicleAudioInstance*>& list, const std::vector<InstanceInputs>& inputs,
+    std::vector<InstanceCommands>& cmds, SmoothingBatch& b, int minParallel) {
+    int n = (int)list.size();
+    auto fn = [&](int begin, int end) {
+        for (int i = begin; i < end; ++i) ComputeInstance(*list[i], inputs[i], cmds[i], b, i);
+    };
+    if (n >= minParallel) pool.ParallelFor(n, PARALLEL_GRAIN, fn);
+    else fn(0, n);
+}
+
+// ---------------- telemetry ----------------
+// Telemetry=1: cada instncia publica o seu estado por frame no anel em memria partilhada
+// de VehicleSFXTelemetry.h (um memcpy por instncia, sem locks nem I/O). Substitui o grep
+// das linhas WIND:/Backfire no log, que deixam de ser escritas enquanto est ativa.
+static_assert((int)IE_ACCEL_START == (int)VSFX_EV_ACCEL_START && (int)IE_ACCEL_RELEASE == (int)VSFX_EV_ACCEL_RELEASE
+    && (int)IE_GEAR_CHANGE == (int)VSFX_EV_GEAR_CHANGE && (int)IE_BACKFIRE_CHECK == (int)VSFX_EV_BACKFIRE_CHECK
+    && (int)IE_BACKFIRE_MISSING == (int)VSFX_EV_BACKFIRE_MISSING && (int)IE_INITIAL_DROP == (int)VSFX_EV_INITIAL_DROP,
+    "InstanceEvent and VsfxTelemetryEvent must match");
+
+class TelemetryExport {
+public:
+    bool Active() const { return block_ != nullptr; }
+
+    // 'name' s muda nas ferramentas, para no publicarem no mapping do jogo
+    bool Open(const char* name = VSFX_TELEMETRY_NAME) {
+        if (block_) return true;
+        mapping_ = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(VsfxTelemetryBlock), name);
+        if (!mapping_) { WriteLog("Telemetry: CreateFileMapping failed err=%lu", (unsigned long)GetLastError()); return false; }
+        block_ = static_cast<VsfxTelemetryBlock*>(MapViewOfFile(mapping_, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(VsfxTelemetryBlock)));
+        if (!block_) {
+            WriteLog("Telemetry: MapViewOfFile failed err=%lu", (unsigned long)GetLastError());
+            CloseHandle(mapping_);
+            mapping_ = nullptr;
+            return false;
         }
+        // o leitor s aceita o bloco depois do magic. O head continua de onde estava (um
+        // mapping reaberto mantm os seq/index dos slots antigos);  o leitor que, ao ver
+        // o pid mudar, recomea a partir do head atual
+        VsfxTelemetryHeader& h = block_->header;
+        h.magic = 0;
+        h.version = VSFX_TELEMETRY_VERSION;
+        h.recordSize = sizeof(VsfxTelemetryRecord);
+        h.capacity = VSFX_TELEMETRY_CAPACITY;
+        h.writerPid = GetCurrentProcessId();
+        head_ = h.head.load(std::memory_order_relaxed);
+        published_ = 0;
+        std::atomic_thread_fence(std::memory_order_release);
+        h.magic = VSFX_TELEMETRY_MAGIC;
+        WriteLog("Telemetry: publishing to %s (%u records x %u bytes)", name, VSFX_TELEMETRY_CAPACITY, (unsigned int)sizeof(VsfxTelemetryRecord));
+        return true;
     }
-    catch (...) { speed = 0.0f; gearMax = 1.0f; }
 
-    // lazy load bank & mute once (permanece igual)
-    if (!inst.bank) {
-        inst.bank = LoadBankForModel(veh->m_nModelIndex);
-        if (inst.bank && !inst.mutedGameAudio) { MuteGameVehicleAudio(veh); inst.mutedGameAudio = true; }
+    void Close() {
+        if (!block_) return;
+        WriteLog("Telemetry: closed after %llu records", published_);
+        UnmapViewOfFile(block_);
+        CloseHandle(mapping_);
+        block_ = nullptr;
+        mapping_ = nullptr;
     }
 
-    // gear change overlays (one-shot) + transient start-of-gear reset
-    if (inst.lastGear == INT_MIN) inst.lastGear = gearNow;
-    if (gearNow != inst.lastGear) {
-        int oldGear = inst.lastGear;
-        if (gearNow > oldGear) {
-            PlayOverlayOnceIfReady(inst, "shiftup", inst.lastShiftUpMs, COOLDOWN_SHIFT_MS);
+    // nunca espera: um leitor lento s perde registos antigos
+    void Publish(VsfxTelemetryRecord rec) {
+        uint32_t idx = head_++;
+        rec.index = idx;
+        VsfxTelemetrySlot& s = block_->slots[idx & (VSFX_TELEMETRY_CAPACITY - 1)];
+        uint32_t seq = s.seq.load(std::memory_order_relaxed);
+        s.seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy((void*)&s.rec, &rec, sizeof(rec));
+        s.seq.store(seq + 2, std::memory_order_release);
+        block_->header.head.store(head_, std::memory_order_release);
+        ++published_;
+    }
+
+    void EndFrame(uint32_t frame) { block_->header.frame.store(frame, std::memory_order_release); }
+
+private:
+    HANDLE mapping_ = nullptr;
+    VsfxTelemetryBlock* block_ = nullptr;
+    uint32_t head_ = 0;
+    unsigned long long published_ = 0;
+};
+
+static TelemetryExport g_telemetry;  // s no thread do jogo
+
+static void UpdateTelemetry() {
+    bool wanted = GetConfig("Telemetry", 0.0f) != 0.0f;
+    if (wanted && !g_telemetry.Active()) {
+        static bool failed = false;  // no insiste a cada frame
+        if (!failed) failed = !g_telemetry.Open();
+    }
+    else if (!wanted && g_telemetry.Active()) g_telemetry.Close();
+}
+
+static void PublishTelemetry(const VehicleAudioInstance& inst, const InstanceInputs& in, const InstanceCommands& cmd, const SmoothingBatch& b, int lane) {
+    if (!in.active) return;
+    VsfxTelemetryRecord r;
+    r.index = 0;
+    r.frame = CTimer::m_FrameCounter;
+    r.timeMs = in.nowMs;
+    r.vehicle = (uint32_t)in.vehKey;
+    r.model = (int16_t)in.modelIndex;
+    r.gear = (int8_t)in.gear;
+    r.loopMode = (uint8_t)inst.loopMode;
+    r.events = (uint16_t)cmd.events;
+    r.overlays = (uint16_t)cmd.overlays;
+    r.speed = cmd.signals.filteredSpeed;
+    r.ratio = cmd.signals.ratio;
+    r.desiredPitch = cmd.hasLane ? b.desiredPitch[lane] : inst.currentPitch;
+    r.currentPitch = inst.currentPitch;
+    r.volume = inst.currentVolume;
+    r.windTarget = cmd.hasLane ? b.desiredWind[lane] : inst.targetWindVolume;
+    r.windCurrent = inst.currentWindVolume;
+    r.occlusion = inst.occlusion.current;
+    g_telemetry.Publish(r);
+}
+
+// thread principal, na ordem das instncias: eventos, overlays, loops e smoothing no FMOD
+static void SubmitInstance(VehicleAudioInstance& inst, const InstanceInputs& in, const InstanceCommands& cmd, SmoothingBatch& b, int lane) {
+    if (in.stopAll) {
+        StopInstanceChannels(inst);
+        inst.loopMode = LM_NONE;
+        return;
+    }
+    if (!in.active) return;
+    ArmInstanceTimers(g_instanceTimers, inst, cmd, in.nowMs);
+
+    if (cmd.events & IE_ACCEL_START) WriteLog("UpdateInstance: accel started model=%d", in.modelIndex);
+    if (cmd.events & IE_ACCEL_RELEASE) WriteLog("UpdateInstance: accel released model=%d at t=%u", in.modelIndex, in.nowMs);
+    if (cmd.overlays & (1u << SND_SHIFTUP)) PlayOverlay(inst, in.emitter, SND_SHIFTUP);
+    if (cmd.overlays & (1u << SND_SHIFTDN)) PlayOverlay(inst, in.emitter, SND_SHIFTDN);
+    if (cmd.events & IE_GEAR_CHANGE) {
+        WriteLog("Gear change: model=%d old=%d new=%d drop=%.3f startPitch=%.2f",
+            in.modelIndex, cmd.oldGear, in.gear, cmd.shiftDrop, inst.currentPitch);
+    }
+    if ((cmd.events & IE_BACKFIRE_CHECK) && !g_telemetry.Active()) {
+        const VehicleSignals& sig = cmd.signals;
+        WriteLog("Backfire check model=%d speed=%.2f filtered=%.2f accel=%.1f/s ratio=%.2f wheelspin=%.2f rule=%d roll=%d chance=%d",
+            in.modelIndex, sig.speed, sig.filteredSpeed, sig.accel, sig.ratio, in.wheelSpin, cmd.rule, cmd.roll, cmd.chance);
+    }
+    if (cmd.events & IE_BACKFIRE_MISSING) {
+        WriteLog("Backfire missing for model=%d (folder=%s\\%d)", in.modelIndex, g_basePath.c_str(), in.modelIndex);
+    }
+    if (cmd.overlays & (1u << SND_BACKFIRE)) PlayOverlay(inst, in.emitter, SND_BACKFIRE);
+    if (cmd.events & IE_INITIAL_DROP) WriteLog("Initial first gear drop applied model=%d", in.modelIndex);
+
+    if (cmd.startLoop) StartLoop(inst, in.emitter, cmd.loopMode, cmd.loopGear, cmd.loopStartPitch);
+
+    // lane sem loop a tocar (arranque falhou) -> nada a aplicar
+    if (!cmd.hasLane || !inst.loopChannel || inst.loopMode == LM_NONE) return;
+
+    if (cmd.startWind && inst.bank->slots[SND_WIND]) {
+        inst.windChannel = PlayLoop(in.emitter.pos, in.emitter.vel, inst.bank->slots[SND_WIND], 0.0f, 1.0f);
+        if (inst.windChannel) {
+            try { inst.windChannel->setVolume(0.0f); }
+            catch (...) {}
+            StartWindFade(g_instanceTimers, inst, in.nowMs);
         }
-        else {
-            PlayOverlayOnceIfReady(inst, "shiftdn", inst.lastShiftDnMs, COOLDOWN_SHIFT_MS);
+    }
+
+    float speed = cmd.signals.filteredSpeed;
+    bool isAccelerating = cmd.signals.throttle;
+
+    inst.currentPitch = b.currentPitch[lane];
+    inst.currentVolume = b.currentVolume[lane];
+    inst.currentWindVolume = b.currentWind[lane];
+
+    // update 3D attributes (usado tanto no loop quanto no wind)
+    FMOD_VECTOR fv = in.emitter.pos;
+    FMOD_VECTOR vel = in.emitter.vel;
+
+    try { inst.loopChannel->setPitch(b.displayPitch[lane]); }
+    catch (...) {}
+    try { inst.loopChannel->setVolume(inst.currentVolume * BankGain(inst.bank, LoopSlot(inst.loopMode))); }
+    catch (...) {}
+
+    if (inst.bank->Has(SND_WIND) && !g_telemetry.Active()) {
+        // debug para log (com Telemetry=1 vai para a memria partilhada)
+        WriteLog("WIND: model=%d speed=%.2f target=%.3f want=%.3f cur=%.3f accel=%d ch=%p",
+            in.modelIndex, speed, inst.targetWindVolume, b.desiredWind[lane], inst.currentWindVolume,
+            isAccelerating ? 1 : 0, (void*)inst.windChannel);
+    }
+
+    // aplica volume e 3D attrs (se aplicvel)
+    if (inst.windChannel) {
+        try { inst.windChannel->setVolume(inst.currentWindVolume * BankGain(inst.bank, SND_WIND)); }
+        catch (...) {}
+        try { inst.windChannel->set3DAttributes(&fv, &vel); }
+        catch (...) {}
+
+        // parar o canal se muito baixo e veculo praticamente parado
+        if (inst.currentWindVolume < WIND_STOP_THRESHOLD && !isAccelerating && speed < 0.5f) {
+            StopChannelSafe(inst.windChannel);
+            inst.currentWindVolume = 0.0f;
+            inst.targetWindVolume = 0.0f;
+            CancelInstanceTimer(g_instanceTimers, inst, IT_WIND_FADE);
+        }
+    }
+
+    try { inst.loopChannel->set3DAttributes(&fv, &vel); }
+    catch (...) {}
+
+    // restart if channel died (no tentar iniciar novo se jogo est pausado)
+    bool isPlaying = true;
+    if (inst.loopChannel && inst.loopChannel->isPlaying(&isPlaying) == FMOD_OK && !isPlaying) {
+        WriteLog("Loop died; restarting loop for model=%d mode=%d", in.modelIndex, (int)inst.loopMode);
+        StopChannelSafe(inst.loopChannel);
+        if (!IsGamePaused()) {
+            FMOD::Sound* s = inst.bank->slots[LoopSlot(inst.loopMode)];
+            if (s) inst.loopChannel = PlayLoop(fv, vel, s, inst.currentVolume * BankGain(inst.bank, LoopSlot(inst.loopMode)), inst.currentPitch);
+        }
+    }
+}
+
+// buffers reaproveitados entre frames
+static std::vector<VehicleAudioInstance*> g_frameInstances;
+static std::vector<InstanceInputs> g_frameInputs;
+static std::vector<InstanceCommands> g_frameCommands;
+
+// fases 2 e 3 sobre g_frameInputs j preenchido (pelo jogo ou por um trace)
+static void ComputeAndSubmit(std::vector<VehicleAudioInstance*>& list, unsigned int nowMs) {
+    int n = (int)list.size();
+    EnsureOverlayRules();
+    g_instanceTimers.Advance(nowMs);  // prazos vencidos mudam o estado antes do clculo
+    g_frameCommands.resize(n);
+    g_smoothBatch.Resize(n);
+
+    ComputeInstances(g_workerPool, list, g_frameInputs, g_frameCommands, g_smoothBatch, PARALLEL_MIN_INSTANCES);
+    // smoothing numrico de todas as instncias de uma vez, depois submisso ao FMOD
+    RunSmoothingKernel(g_smoothBatch);
+    for (int i = 0; i < n; ++i) SubmitInstance(*list[i], g_frameInputs[i], g_frameCommands[i], g_smoothBatch, i);
+    if (!g_telemetry.Active()) return;
+    for (int i = 0; i < n; ++i) PublishTelemetry(*list[i], g_frameInputs[i], g_frameCommands[i], g_smoothBatch, i);
+    g_telemetry.EndFrame(CTimer::m_FrameCounter);
+}
+
+static void UpdateInstances(std::vector<VehicleAudioInstance*>& list) {
+    int n = (int)list.size();
+    g_frameInputs.resize(n);
+    for (int i = 0; i < n; ++i) GatherInputs(*list[i], g_frameInputs[i]);
+    ComputeAndSubmit(list, CTimer::m_snTimeInMilliseconds);
+}
+
+// s com o prefetcher e o watcher parados
+static void ReleaseModelBanks() {
+    g_modelBanks.ForEach([](BankRegistry::Slot& s) {
+        if (WavBank* bank = s.bank.exchange(nullptr, std::memory_order_acq_rel)) {
+            for (auto& p : bank->sounds) if (p.second) p.second->release();
+            delete bank;
+        }
+        s.prefetchedAtMs.store(0, std::memory_order_relaxed);
+        s.waitedOn.store(false, std::memory_order_relaxed);
+        s.state.store(BANK_ABSENT, std::memory_order_release);
+    });
+    g_bankEpochs.Drain();
+}
+
+// ---------------- dormant instances ----------------
+// Instncia quieta (ver fim do ComputeInstance) durante DormantAfterMs adormece: sai da lista
+// de update e o loop de idle fica entregue ao FMOD como voz estvel, sem set* por frame. Longe
+// do ouvinte (DormantReleaseDistance) o loop  libertado. Acorda numa mudana de input (marcha,
+// acelerador, velocidade, validade), ao aproximar-se o ouvinte ou num evento de ciclo de vida
+// (jogador entra, reload do ini, hot reload do banco).
+enum WakeReason { WAKE_INPUT, WAKE_PROXIMITY, WAKE_LIFECYCLE, WAKE_COUNT };
+static const char* s_wakeNames[WAKE_COUNT] = { "input", "proximity", "lifecycle" };
+
+struct DormancyStats {
+    unsigned long long sleeps = 0;
+    unsigned long long released = 0;   // adormecidas sem canais (longe ou invlidas)
+    unsigned long long wakes[WAKE_COUNT] = {};
+    unsigned long long frames = 0;
+    unsigned long long activeSum = 0;
+    unsigned long long dormantSum = 0;
+    unsigned int active = 0;           // ltima frame
+    unsigned int dormant = 0;
+};
+static DormancyStats g_dormancy;
+static CVehicle* g_dormancyPlayerVeh = nullptr;  // o pad s conta no carro do jogador
+
+// o pouco que se l de um veculo adormecido para saber se tem de acordar
+struct DormantProbe {
+    bool valid = false;
+    int gear = 0;
+    bool throttle = false;
+    float speed = 0.0f;   // ReadVehicleSpeed
+    float move = 0.0f;    // |m_vecMoveSpeed| (empurrado, rebocado)
+};
+static const float DORMANT_MOVE_EPS = 0.005f;
+
+static DormantProbe SampleDormantProbe(const VehicleAudioInstance& inst, CVehicle* veh, CVehicle* playerVeh) {
+    DormantProbe p;
+    p.valid = IsVehicleValidForAudio(veh);
+    if (!p.valid) return p;
+    p.gear = (int)veh->m_nCurrentGear;
+    p.throttle = veh->m_fGasPedal > GASPEDAL_ACCEL_THRESHOLD;
+    if (veh == playerVeh) {
+        CPad* pad = CPad::GetPad(0);
+        if (pad && pad->GetAccelerate() > (short)PAD_ACCEL_THRESHOLD_SHORT) p.throttle = true;
+    }
+    // s campos do prprio veculo: o m_fCurrentSpeed do handling  partilhado por modelo
+    try { p.speed = ReadVehicleSpeed(veh); }
+    catch (...) { p.speed = 0.0f; }
+    p.move = veh->m_vecMoveSpeed.Magnitude();
+    return p;
+}
+
+static bool DormantShouldWake(const VehicleAudioInstance& inst, const DormantProbe& p) {
+    if (p.valid != inst.dormantValid) return true;
+    if (!p.valid) return false;
+    return p.gear != inst.dormantGear || p.throttle || p.speed > IDLE_SPEED_THRESHOLD || p.move > DORMANT_MOVE_EPS;
+}
+
+static void SleepInstance(TimerWheel& wheel, VehicleAudioInstance& inst, bool valid, int gear, bool release) {
+    CancelInstanceTimers(wheel, inst);
+    StopChannelSafe(inst.windChannel);  // abaixo de WindStopThreshold: no se ouve
+    inst.currentWindVolume = inst.targetWindVolume = 0.0f;
+    if (release) {
+        StopInstanceChannels(inst);
+        inst.loopMode = LM_NONE;
+        ++g_dormancy.released;
+    }
+    inst.dormant = true;
+    inst.dormantReleased = release;
+    inst.dormantValid = valid;
+    inst.dormantGear = gear;
+    inst.sleepPending = false;
+    ++g_dormancy.sleeps;
+}
+
+// volta  lista de update; o filtro de velocidade recomea e um loop libertado  reiniciado
+// pelo clculo da prpria frame
+static void WakeInstance(VehicleAudioInstance& inst, WakeReason why) {
+    if (!inst.dormant) return;
+    inst.dormant = false;
+    inst.dormantReleased = false;
+    inst.signalsPrimed = false;
+    ++g_dormancy.wakes[why];
+}
+
+// depois do UpdateInstances: adormece quem ficou quieto (IT_SETTLE venceu) e quem ficou
+// invlido para udio (canais j parados pelo stopAll)
+static void SettleInstances(TimerWheel& wheel, std::vector<VehicleAudioInstance*>& list, const std::vector<InstanceInputs>& inputs, const FMOD_VECTOR& listener) {
+    if (DORMANT_AFTER_MS <= 0.0f) return;
+    for (size_t i = 0; i < list.size(); ++i) {
+        VehicleAudioInstance& inst = *list[i];
+        const InstanceInputs& in = inputs[i];
+        if (in.stopAll) {
+            SleepInstance(wheel, inst, false, 0, true);
+            continue;
         }
+        if (!inst.sleepPending || !in.active) continue;
+        float dx = in.emitter.pos.x - listener.x, dy = in.emitter.pos.y - listener.y, dz = in.emitter.pos.z - listener.z;
+        bool far = dx * dx + dy * dy + dz * dz > DORMANT_RELEASE_DIST * DORMANT_RELEASE_DIST;
+        SleepInstance(wheel, inst, true, in.gear, far);
+    }
+}
 
-        // transient: pequeno drop grave para dar "thump" na troca (negativo = engrossa)
-        int gIdx = std::clamp(gearNow <= 0 ? 1 : gearNow, 1, 5);
-        float gearFactorForDrop = float(gIdx - 1) / 4.0f; // 0..1
+static void LogDormancyStats(const char* when) {
+    const DormancyStats& s = g_dormancy;
+    WriteLog("Dormancy (%s): active=%u dormant=%u now, avg %.1f active / %.1f dormant over %llu frames, sleeps=%llu (released %llu) wakes %s=%llu %s=%llu %s=%llu",
+        when, s.active, s.dormant, s.frames ? double(s.activeSum) / s.frames : 0.0, s.frames ? double(s.dormantSum) / s.frames : 0.0,
+        s.frames, s.sleeps, s.released, s_wakeNames[WAKE_INPUT], s.wakes[WAKE_INPUT], s_wakeNames[WAKE_PROXIMITY], s.wakes[WAKE_PROXIMITY],
+        s_wakeNames[WAKE_LIFECYCLE], s.wakes[WAKE_LIFECYCLE]);
+}
 
-        float drop = BASE_SHIFT_DROP * (1.0f + gearFactorForDrop * EXTRA_DROP_PER_GEAR);
-        inst.shiftPitchDrop = drop;
-        inst.shiftStartMs = CTimer::m_snTimeInMilliseconds;
+// ---------------- hot reload ----------------
+// HotReload=1 (modo de desenvolvimento): um thread vigia vsfx\\<modelo>\\*.wav dos bancos
+// j carregados a cada HotReloadPollMs. Ficheiros alterados/novos/removidos so
+// recarregados nesse thread e trocados no OnProcess, antes do clculo da frame;
+// loops que tocavam o som antigo recomeam com o mesmo pitch/volume e na mesma
+// posio do loop.
+// Um ficheiro s  recarregado depois de ficar igual em duas leituras seguidas (o
+// editor pode ainda estar a escrever) e se o contedo mudou de facto (hash da fonte).
+struct FileStamp {
+    fs::file_time_type writeTime{};
+    uintmax_t size = 0;
+    bool exists = false;
+    bool operator==(const FileStamp& o) const { return exists == o.exists && size == o.size && writeTime == o.writeTime; }
+    bool operator!=(const FileStamp& o) const { return !(*this == o); }
+};
 
-        // **IMPORTANTE**: reiniciar o pitch imediatamente para a base da marcha
-        //  isso faz a sensao "comear do 0" por marcha.
-        inst.currentPitch = START_PITCH_PER_GEAR[gIdx] + 0.15f * (inst.currentPitch - START_PITCH_PER_GEAR[gIdx]);
-        inst.desiredEnginePitch = inst.currentPitch; // garante consistncia com smoothing
-        inst.lastGear = gearNow;
+static FileStamp StatFile(const std::string& path) {
+    FileStamp st;
+    std::error_code ec;
+    st.writeTime = fs::last_write_time(path, ec);
+    if (ec) return FileStamp();
+    st.size = fs::file_size(path, ec);
+    st.exists = !ec;
+    return st;
+}
 
-        WriteLog("Gear change: model=%d old=%d new=%d drop=%.3f startPitch=%.2f",
-            veh->m_nModelIndex, oldGear, gearNow, drop, inst.currentPitch);
-    }
+struct SoundSwap {
+    int modelId = 0;
+    int slot = 0;
+    FMOD::Sound* sound = nullptr;   // nullptr = ficheiro removido
+    SoundMetrics metrics;
+    float gain = 1.0f;
+    fs::file_time_type writeTime{};
+    bool forgetBank = false;        // pasta criada para um modelo sem banco: carrega no prximo uso
+};
 
+class HotReloadWatcher {
+public:
+    bool Running() const { return thread_.joinable(); }
+
+    void Start(unsigned int pollMs) {
+        if (Running()) return;
+        pollMs_ = std::max(50u, pollMs);
+        stop_ = false;
+        thread_ = std::thread([this] { Run(); });
+        WriteLog("HotReload: watching %s every %u ms", g_basePath.c_str(), pollMs_);
+    }
 
+    // para o thread e liberta trocas que no chegaram a ser aplicadas
+    void Stop() {
+        if (!Running()) return;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            stop_ = true;
+        }
+        wake_.notify_all();
+        thread_.join();
+        for (SoundSwap& sw : ready_) if (sw.sound) sw.sound->release();
+        ready_.clear();
+        observed_.clear();
+        loaded_.clear();
+        WriteLog("HotReload: stopped");
+    }
 
+    void TakeReady(std::vector<SoundSwap>& out) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        out.swap(ready_);
+    }
 
-    // --- backfire heuristic (por instncia) ---
-// usa inst.lastSpeed (persistente por veculo) ao invs de uma varivel global
-    float prevSpeed = inst.lastSpeed;
-    float delta = speed - prevSpeed;
+private:
+    struct BankSnapshot {
+        int modelId = 0;
+        bool loaded = false;
+        unsigned int soundMask = 0;
+        unsigned long long sourceHash[SND_COUNT] = {};
+    };
+
+    void Run() {
+        std::unique_lock<std::mutex> lk(mutex_);
+        while (!stop_) {
+            lk.unlock();
+            Poll();
+            lk.lock();
+            wake_.wait_for(lk, std::chrono::milliseconds(pollMs_), [this] { return stop_.load(); });
+        }
+    }
 
-    // parmetros ajustveis
-    constexpr float BACKFIRE_DELTA_THRESHOLD = -3.0f; // queda brusca em unidades de speed
-    constexpr float BACKFIRE_RATIO_THRESHOLD = 0.35f; // requer velocidade relativa (proxy RPM)
-    constexpr unsigned int RECENT_RELEASE_WINDOW_MS = 800u; // janela aps soltar acelerador
-    constexpr int BACKFIRE_CHANCE_HEAVY = 70; // % chance em queda brusca
-    constexpr int BACKFIRE_CHANCE_RELEASE = 30; // % chance ao soltar acelerador
-    constexpr int BACKFIRE_CHANCE_WHEELSPIN = 80; // % chance em wheelspin
-    constexpr unsigned int COOLDOWN_WHEELSPIN_MS = COOLDOWN_BACKFIRE_MS / 2; // menor cooldown em burnout
+    void Poll() {
+        std::vector<BankSnapshot> banks;
+        {
+            EpochReclaimer::Guard guard(g_bankEpochs);
+            g_modelBanks.ForEach([&banks](BankRegistry::Slot& s) {
+                int state = s.state.load(std::memory_order_acquire);
+                if (state != BANK_READY && state != BANK_MISSING) return;
+                BankSnapshot b;
+                b.modelId = s.key.load(std::memory_order_relaxed);
+                WavBank* bank = s.bank.load(std::memory_order_acquire);
+                b.loaded = bank != nullptr;
+                if (b.loaded) {
+                    b.soundMask = bank->soundMask;
+                    for (int i = 0; i < SND_COUNT; ++i) b.sourceHash[i] = bank->metrics[i].sourceHash;
+                }
+                banks.push_back(b);
+            });
+        }
+        FMOD::System* core = GetCoreSystem();
+        if (!core) return;
+
+        // um ini s para a ronda inteira (o jogo pode recarreg-lo a meio)
+        ConfigScope config(CurrentConfig());
+        for (const BankSnapshot& b : banks) {
+            if (stop_) return;
+            std::string folder = g_basePath + "\\" + std::to_string(b.modelId);
+            if (!b.loaded) {
+                std::error_code ec;
+                if (fs::is_directory(folder, ec)) Publish(SoundSwapForget(b.modelId));
+                continue;
+            }
+            for (int slot = 0; slot < SND_COUNT; ++slot) PollSlot(core, b, folder, slot);
+        }
+    }
 
-    // calcula ratio como proxy de RPM (j calculado depois no pitch logic  reutilizamos)
-    float ratio = (gearMax > 0.0001f) ? std::clamp(speed / gearMax, 0.0f, 1.0f) : 0.0f;
+    static SoundSwap SoundSwapForget(int modelId) {
+        SoundSwap sw;
+        sw.modelId = modelId;
+        sw.forgetBank = true;
+        return sw;
+    }
 
-    bool wheelspin = (veh->m_fWheelSpinForAudio > 0.6f);
-    bool heavyDrop = (delta < BACKFIRE_DELTA_THRESHOLD && ratio > BACKFIRE_RATIO_THRESHOLD);
-    bool recentRelease = (inst.lastAccelReleaseMs != 0 && (now - inst.lastAccelReleaseMs) < RECENT_RELEASE_WINDOW_MS && ratio > 0.20f);
+    void PollSlot(FMOD::System* core, const BankSnapshot& b, const std::string& folder, int slot) {
+        std::string path = folder + "\\" + s_names[slot];
+        FileStamp st = StatFile(path);
+
+        // ainda a mudar desde a ltima leitura: espera que estabilize
+        auto obs = observed_.find(path);
+        if (obs == observed_.end()) observed_[path] = st;
+        else if (obs->second != st) { obs->second = st; return; }
+
+        auto ld = loaded_.find(path);
+        if (ld != loaded_.end() && ld->second == st) return;
+        loaded_[path] = st;
+
+        bool present = (b.soundMask & (1u << slot)) != 0;
+        std::vector<char> source;
+        if (st.exists && !ReadFileBytes(path, source)) return;
+        unsigned long long hash = HashBytes(source.data(), source.size());
+        if (st.exists == present && (!st.exists || hash == b.sourceHash[slot])) return;  // contedo igual ao carregado
+
+        auto t0 = std::chrono::steady_clock::now();
+        SoundSwap sw;
+        sw.modelId = b.modelId;
+        sw.slot = slot;
+        sw.writeTime = st.writeTime;
+        if (st.exists) {
+            FmodMemoryTag memTag(b.modelId);
+            std::map<std::string, SoundMetrics> meta;
+            bool metaDirty = false;
+            LoadBankMeta(folder, meta);
+            sw.sound = LoadBankSlot(core, folder, b.modelId, slot, source, hash, meta, metaDirty, sw.metrics, sw.gain);
+            if (metaDirty) SaveBankMeta(folder, meta);
+            if (!sw.sound) { WriteLog("HotReload: %s failed to load, keeping the old sound", path.c_str()); return; }
+        }
+        WriteLog("HotReload: %s %s, reloaded in %.1f ms", path.c_str(), !st.exists ? "removed" : (present ? "changed" : "added"),
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+        Publish(sw);
+    }
 
-    if ((heavyDrop || recentRelease || wheelspin) && inst.bank) {
-        if (inst.bank->sounds.count("backfire")) {
-            // pseudo-random roll (determinstico por frame)
-            unsigned int seed = (unsigned int)(now ^ (uintptr_t)veh);
-            int roll = (int)(seed % 100);
+    void Publish(const SoundSwap& sw) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        ready_.push_back(sw);
+    }
 
-            int chance = 0;
-            unsigned int cooldown = COOLDOWN_BACKFIRE_MS;
-            if (wheelspin) { chance = BACKFIRE_CHANCE_WHEELSPIN; cooldown = COOLDOWN_WHEELSPIN_MS; }
-            else if (heavyDrop) chance = BACKFIRE_CHANCE_HEAVY;
-            else if (recentRelease) chance = BACKFIRE_CHANCE_RELEASE;
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::atomic<bool> stop_{ false };
+    unsigned int pollMs_ = 500;
+    std::vector<SoundSwap> ready_;
+    std::map<std::string, FileStamp> observed_;  // ltima leitura de cada ficheiro
+    std::map<std::string, FileStamp> loaded_;    // verso j comparada/carregada
+};
 
-            WriteLog("Backfire check model=%d prev=%.2f cur=%.2f delta=%.2f ratio=%.2f wheelspin=%.2f recentRel=%d roll=%d chance=%d",
-                veh->m_nModelIndex, prevSpeed, speed, delta, ratio, veh->m_fWheelSpinForAudio, recentRelease ? 1 : 0, roll, chance);
+static HotReloadWatcher g_hotReload;
+
+// troca um canal que toca 'oldSound' por 'newSound' com o mesmo pitch e a mesma posio
+// no loop (mdulo o comprimento do som novo); devolve true se mexeu
+static bool RestartChannelWith(FMOD::Channel*& ch, FMOD::Sound* oldSound, FMOD::Sound* newSound, float volume) {
+    if (!ch || !oldSound) return false;
+    FMOD::Sound* current = nullptr;
+    if (ch->getCurrentSound(&current) != FMOD_OK || current != oldSound) return false;
+    FMOD_VECTOR pos = { 0.0f, 0.0f, 0.0f }, vel = { 0.0f, 0.0f, 0.0f };
+    float pitch = 1.0f;
+    unsigned int positionMs = 0, lengthMs = 0;
+    try { ch->get3DAttributes(&pos, &vel); ch->getPitch(&pitch); ch->getPosition(&positionMs, FMOD_TIMEUNIT_MS); }
+    catch (...) {}
+    StopChannelSafe(ch);
+    if (!newSound) return true;
+    try { newSound->getLength(&lengthMs, FMOD_TIMEUNIT_MS); }
+    catch (...) {}
+    ch = PlayLoop(pos, vel, newSound, volume, pitch, lengthMs ? positionMs % lengthMs : 0);
+    return true;
+}
 
-            if (roll < chance) {
-                // usa o mesmo helper (tem cooldown interno via inst.lastBackfireMs)
-                PlayOverlayOnceIfReady(inst, "backfire", inst.lastBackfireMs, cooldown);
+// ponto seguro (thread do jogo, fora do clculo): aplica os sons recarregados.
+// O banco publicado no  alterado no lugar (o watcher pode estar a l-lo): cada troca
+// publica uma cpia e a antiga vai para o g_bankEpochs.
+static void ApplyHotReloadSwaps() {
+    static std::vector<SoundSwap> swaps;
+    swaps.clear();
+    g_hotReload.TakeReady(swaps);
+    if (swaps.empty()) return;
+    g_vsfxModelCache.clear();
+
+    for (SoundSwap& sw : swaps) {
+        BankRegistry::Slot* entry = g_modelBanks.Find(sw.modelId);
+        if (sw.forgetBank) {
+            int missing = BANK_MISSING;
+            if (entry && entry->state.compare_exchange_strong(missing, BANK_ABSENT, std::memory_order_acq_rel))
+                WriteLog("HotReload: folder for model=%d appeared, bank loads on next use", sw.modelId);
+            continue;
+        }
+        WavBank* oldBank = (entry && entry->state.load(std::memory_order_acquire) == BANK_READY) ? entry->bank.load(std::memory_order_acquire) : nullptr;
+        if (!oldBank) {
+            if (sw.sound) sw.sound->release();
+            continue;
+        }
+        WavBank* bank = new WavBank(*oldBank);
+        FMOD::Sound* oldSound = bank->slots[sw.slot];
+
+        int restarted = 0;
+        for (auto& kv : g_vehicleInstances) {
+            VehicleAudioInstance& inst = kv.second;
+            if (inst.bank != oldBank) continue;
+            inst.bank = bank;
+            WakeInstance(inst, WAKE_LIFECYCLE);  // o som novo tem de chegar ao canal pelo clculo
+            if (sw.slot == SND_WIND) {
+                if (RestartChannelWith(inst.windChannel, oldSound, sw.sound, inst.currentWindVolume * sw.gain)) ++restarted;
+            }
+            else if (SlotLoops(sw.slot)) {
+                if (RestartChannelWith(inst.loopChannel, oldSound, sw.sound, inst.currentVolume * sw.gain)) {
+                    ++restarted;
+                    if (!inst.loopChannel) inst.loopMode = LM_NONE;  // removido / em pausa: o clculo decide de novo
+                }
             }
+            else {
+                // one-shots a meio: param aqui, o prximo evento j usa o som novo
+                FMOD::Sound* current = nullptr;
+                if (inst.shiftChannel && inst.shiftChannel->getCurrentSound(&current) == FMOD_OK && current == oldSound) StopChannelSafe(inst.shiftChannel);
+                if (inst.attackChannel && inst.attackChannel->getCurrentSound(&current) == FMOD_OK && current == oldSound) StopChannelSafe(inst.attackChannel);
+            }
+        }
+
+        bank->slots[sw.slot] = sw.sound;
+        if (sw.sound) {
+            bank->sounds[SlotKey(sw.slot)] = sw.sound;
+            bank->soundMask |= 1u << sw.slot;
         }
         else {
-            WriteLog("Backfire missing for model=%d (folder=%s\\%d)", veh->m_nModelIndex, g_basePath.c_str(), veh->m_nModelIndex);
+            bank->sounds.erase(SlotKey(sw.slot));
+            bank->soundMask &= ~(1u << sw.slot);
         }
+        bank->metrics[sw.slot] = sw.metrics;
+        bank->gain[sw.slot] = sw.gain;
+        entry->bank.store(bank, std::memory_order_release);
+        g_bankEpochs.Retire(oldBank, DeleteBankStruct);
+        if (oldSound) oldSound->release();  // canais j trocados; s o thread do jogo toca sons
+
+        if (!sw.sound) {
+            WriteLog("HotReload: removed model=%d %s stopped=%d channels", sw.modelId, s_names[sw.slot], restarted);
+            continue;
+        }
+        double sinceSaveMs = std::chrono::duration<double, std::milli>(fs::file_time_type::clock::now() - sw.writeTime).count();
+        WriteLog("HotReload: swapped model=%d %s restarted=%d channels, %.0f ms after save",
+            sw.modelId, s_names[sw.slot], restarted, sinceSaveMs);
     }
+}
 
-    // guardar speed por instncia para prxima frame
-    inst.lastSpeed = speed;
-
+// liga/desliga o watcher conforme o ini (que tambm pode ser recarregado em jogo)
+static void UpdateHotReload() {
+    bool wanted = GetConfig("HotReload", 0.0f) != 0.0f;
+    if (wanted && !g_hotReload.Running()) g_hotReload.Start((unsigned int)GetConfig("HotReloadPollMs", 500.0f));
+    else if (!wanted && g_hotReload.Running()) g_hotReload.Stop();
+    ApplyHotReloadSwaps();
+    if (g_bankEpochs.Pending()) g_bankEpochs.Collect();
+}
 
-    // decide desired loop:
-    // - se estamos acelerando (pad ou pedal) -> gear loop
-    // - se estamos em movimento (velocidade > threshold) -> gear loop
-    // - se parado -> idle
-    bool padRecentlyReleased = (inst.lastAccelReleaseMs != 0 && (now - inst.lastAccelReleaseMs) < 1500u);
-    bool isAccelerating = vehGasPressed || padPressed;
-    bool wantGearLoop = (speed > IDLE_SPEED_THRESHOLD) || isAccelerating || (padRecentlyReleased && speed > 0.5f);
+// ---------------- vehicle spatial grid ----------------
+// Hash espacial uniforme (clulas de GRID_CELL_SIZE m em x/y) com a ltima posio
+// conhecida de cada veculo. Entra no vehicleCtorEvent, sai no vehicleDtorEvent e muda de
+// clula a partir do hook de ProcessControl; um varrimento rotativo do pool corrige os
+// que a fsica no processa (estacionados, sem hooks). As consultas percorrem anis de
+// clulas  volta do centro, por isso custam ~ o n de veculos prximos e no o pool.
+static const float GRID_CELL_SIZE = 50.0f;
+static const int GRID_BUCKETS = 4096;            // potncia de 2
+static const float AUDIBLE_RADIUS = 300.0f;      // = max distance do set3DMinMaxDistance
+static const unsigned int GRID_RESYNC_FRAMES = 30;  // pool inteiro revisto a cada N frames
+
+struct GridHit {
+    float dist;
+    CVehicle* veh;
+    // empates desfeitos pelo ponteiro: a ordem no depende da ordem dos buckets
+    bool operator<(const GridHit& o) const { return dist < o.dist || (dist == o.dist && std::less<CVehicle*>()(veh, o.veh)); }
+};
 
-    // drop inicial
-    if (gearNow == 1 && inst.lastGear == 1 && isAccelerating && inst.shiftPitchDrop == 0.0f) {
-        inst.shiftPitchDrop = BASE_START_DROP;
-        inst.shiftStartMs = CTimer::m_snTimeInMilliseconds;
-        WriteLog("Initial first gear drop applied model=%d", veh->m_nModelIndex);
+class VehicleSpatialGrid {
+public:
+    VehicleSpatialGrid() : buckets_(GRID_BUCKETS) {}
+
+    // insere ou move; nunca desreferencia o veculo
+    void Update(CVehicle* veh, const CVector& pos) {
+        int cx = Cell(pos.x), cy = Cell(pos.y);
+        auto it = where_.find(veh);
+        if (it != where_.end()) {
+            Entry& e = buckets_[it->second.bucket][it->second.index];
+            if (e.cx == cx && e.cy == cy) { e.pos = pos; return; }
+            Unlink(it->second);
+            ++moves_;
+        }
+        int b = Bucket(cx, cy);
+        where_[veh] = { b, (int)buckets_[b].size() };
+        buckets_[b].push_back({ veh, cx, cy, pos });
     }
 
-    if (wantGearLoop) {
-        EnsureLoopPlaying(inst, "engine", gearNow);
+    void Remove(CVehicle* veh) {
+        auto it = where_.find(veh);
+        if (it == where_.end()) return;
+        Unlink(it->second);
+        where_.erase(it);
     }
-    else {
-        EnsureLoopPlaying(inst, "idle", gearNow);
+
+    void Clear() {
+        for (auto& b : buckets_) b.clear();
+        where_.clear();
     }
 
-    // pitch/volume smoothing for active loop
-    if (inst.loopChannel && inst.loopMode != LM_NONE) {
-        float ratio = (gearMax > 0.0001f) ? std::clamp(speed / gearMax, 0.0f, 1.0f) : 0.0f;
-        int gIndex = std::clamp(gearNow <= 0 ? 1 : gearNow, 1, 5);
+    // veculos at 'radius' de 'center', por distncia crescente; com maxResults para de
+    // alargar os anis assim que o anel seguinte j no pode ter nada mais perto
+    size_t Query(const CVector& center, float radius, size_t maxResults, std::vector<GridHit>& out) const {
+        out.clear();
+        int ccx = Cell(center.x), ccy = Cell(center.y);
+        int rings = (int)std::ceil(radius / GRID_CELL_SIZE);
+        float r2 = radius * radius;
+        for (int ring = 0; ring <= rings; ++ring) {
+            if (maxResults && out.size() >= maxResults) {
+                // tudo no anel 'ring' est a pelo menos (ring - 1) clulas do centro; estrito
+                // porque um empate l fora ainda pode ganhar pelo ponteiro
+                std::nth_element(out.begin(), out.begin() + (maxResults - 1), out.end());
+                if (out[maxResults - 1].dist < (ring - 1) * GRID_CELL_SIZE) break;
+            }
+            for (int dy = -ring; dy <= ring; ++dy) {
+                bool edgeRow = (dy == -ring || dy == ring);
+                for (int dx = -ring; dx <= ring; dx += edgeRow ? 1 : 2 * ring) {
+                    int cx = ccx + dx, cy = ccy + dy;
+                    for (const Entry& e : buckets_[Bucket(cx, cy)]) {
+                        if (e.cx != cx || e.cy != cy) continue;  // outra clula no mesmo bucket
+                        float ex = e.pos.x - center.x, ey = e.pos.y - center.y, ez = e.pos.z - center.z;
+                        float d2 = ex * ex + ey * ey + ez * ez;
+                        if (d2 <= r2) out.push_back({ std::sqrt(d2), e.veh });
+                    }
+                    if (ring == 0) break;
+                }
+            }
+        }
+        std::sort(out.begin(), out.end());
+        if (maxResults && out.size() > maxResults) out.resize(maxResults);
+        return out.size();
+    }
 
-        // update 3D attributes (prepara para usar tanto no loop quanto no wind)
-        CVector pos = veh->GetPosition();
-        FMOD_VECTOR fv = { pos.x, pos.y, pos.z };
-        FMOD_VECTOR vel = { veh->m_vecMoveSpeed.x, veh->m_vecMoveSpeed.y, veh->m_vecMoveSpeed.z };
+    size_t Size() const { return where_.size(); }
+    unsigned long long Moves() const { return moves_; }
 
-        // Delta natural entre start e target (pequeno nas marchas altas)
-        float baseDelta = TARGET_PITCH - START_PITCH_PER_GEAR[gIndex];
+private:
+    struct Entry { CVehicle* veh; int cx, cy; CVector pos; };
+    struct Loc { int bucket, index; };
 
-        // Factor que cresce com a marcha (0 em gear=1, ~1 em gear=MAX_GEAR_INDEX)
-        static int MAX_GEAR_INDEX = 5; // nmero de marchas usadas no fator
-        float gearFactor = 0.0f;
-        if (MAX_GEAR_INDEX > 1) gearFactor = float(gIndex - 1) / float(MAX_GEAR_INDEX - 1);
+    static int Cell(float v) { return (int)std::floor(v / GRID_CELL_SIZE); }
+    static int Bucket(int cx, int cy) { return (int)(((unsigned int)cx * 73856093u) ^ ((unsigned int)cy * 19349663u)) & (GRID_BUCKETS - 1); }
 
-        // escala proporcional: nas marchas altas aplicamos mais ganho ao delta
-        float gearScale = 1.0f + gearFactor * (PITCH_AMPLIFY_MAX - 1.0f);
+    // swap-remove; corrige o ndice de quem ocupou o lugar
+    void Unlink(const Loc& loc) {
+        std::vector<Entry>& b = buckets_[loc.bucket];
+        if (loc.index != (int)b.size() - 1) {
+            b[loc.index] = b.back();
+            where_[b[loc.index].veh].index = loc.index;
+        }
+        b.pop_back();
+    }
 
-        // gearMultiplier aumenta o sweep do pitch conforme a marcha cresce (tune aqui)
-        float gearMultiplier = 1.0f + gearFactor * 1.1f; // 1.0..2.1 (ajuste se quiser mais)
+    std::vector<std::vector<Entry>> buckets_;
+    std::map<CVehicle*, Loc> where_;
+    unsigned long long moves_ = 0;
+};
 
-        // (mantemos gearScale se quiser um leve aumento nas marchas altas)
-        // alvo para modo acelerando: sweep relativo ao START_PITCH da marcha
-        float accelTarget = START_PITCH_PER_GEAR[gIndex] + ratio * (TARGET_PITCH - START_PITCH_PER_GEAR[gIndex]) * gearScale;
-        float upperLimit = TARGET_PITCH + MAX_OVERSHOOT;
-        accelTarget = std::clamp(accelTarget, START_PITCH_PER_GEAR[gIndex], upperLimit);
+static VehicleSpatialGrid g_vehicleGrid;  // s no thread do jogo
+
+// rev uma fatia do pool por frame (o pool todo se a fsica no alimenta a grelha)
+static void ResyncVehicleGrid(bool fullScan) {
+    CPool<CVehicle>* pool = CPools::ms_pVehiclePool;
+    if (!pool || pool->m_nSize <= 0) return;
+    static int cursor = 0;
+    int count = fullScan ? pool->m_nSize : std::max(1, (pool->m_nSize + (int)GRID_RESYNC_FRAMES - 1) / (int)GRID_RESYNC_FRAMES);
+    for (int n = 0; n < count; ++n) {
+        cursor = (cursor + 1) % pool->m_nSize;
+        if (CVehicle* v = pool->GetAt(cursor)) g_vehicleGrid.Update(v, v->GetPosition());
+    }
+}
 
-        // alvo para modo desacelerando (baixo, mais notrio)
-        float decelTarget = START_PITCH_PER_GEAR[gIndex] + ratio * (TARGET_PITCH - START_PITCH_PER_GEAR[gIndex]) * gearScale * DECEL_FACTOR;
-        decelTarget = std::clamp(decelTarget, START_PITCH_PER_GEAR[gIndex], accelTarget);
-        decelTarget = std::max(decelTarget, MIN_PITCH);
+// ---------------- bank prefetch ----------------
+// A cada PrefetchIntervalFrames, a p, o preditor olha para o carro que o player est
+// a tentar entrar (tarefa enter-car) e para os veculos a menos de PrefetchRadius, e
+// pe os bancos desses modelos a carregar num thread prprio, para j estarem
+// residentes quando o FindPlayerVehicle os devolver.
+//  - no mximo PrefetchQueueDepth pedidos em fila/a carregar;
+//  - bancos de prefetch ainda sem uso no passam de PrefetchMemoryMB;
+//  - sem uso ao fim de PrefetchExpireMs so libertados e contam como desperdcio.
+static const int TASK_COMPLEX_ENTER_CAR_AS_DRIVER = 701;
+static const uintptr_t TASK_ENTER_CAR_TARGET_OFFSET = 0xC;  // CTaskComplexEnterCar::m_pTargetVehicle
+
+class BankPrefetcher {
+public:
+    bool Running() const { return thread_.joinable(); }
 
+    void Start() {
+        if (Running()) return;
+        stop_ = false;
+        thread_ = std::thread([this] { Run(); });
+    }
 
-        // decide modo baseado em input (isAccelerating j calculado antes)
-        if (isAccelerating) {
-            if (inst.engineMode != VehicleAudioInstance::EM_ACCEL) {
-                inst.engineMode = VehicleAudioInstance::EM_ACCEL;
-            }
-            inst.desiredEnginePitch = accelTarget;
+    void Stop() {
+        if (!Running()) return;
+        {
+            std::lock_guard<std::mutex> lk(mutex_);
+            stop_ = true;
+            queue_.clear();
         }
-        else {
-            if (inst.engineMode != VehicleAudioInstance::EM_DECEL) {
-                inst.engineMode = VehicleAudioInstance::EM_DECEL;
-            }
-            inst.desiredEnginePitch = decelTarget;
-        }
-
-        // smoothing: usa taxas diferentes para acelerao/desacelerao
-        float dt = std::max(0.0f, CTimer::ms_fTimeStep);
-        float baseAlpha = std::clamp(dt * PITCH_SMOOTHING, 0.0f, 1.0f);
-        float alpha = baseAlpha;
-        if (inst.engineMode == VehicleAudioInstance::EM_ACCEL) alpha = baseAlpha * ACCEL_SPEED_MULT;
-        else if (inst.engineMode == VehicleAudioInstance::EM_DECEL) alpha = baseAlpha * DECEL_SPEED_MULT;
-
-        // atualiza pitch com blend
-        inst.currentPitch = inst.currentPitch + (inst.desiredEnginePitch - inst.currentPitch) * alpha;
-        // segurana: no permitir pitch absurdo
-        inst.currentPitch = std::clamp(inst.currentPitch, MIN_PITCH, TARGET_PITCH + MAX_OVERSHOOT);
-
-        // --- shift drop decay (transient) ---
-        float displayPitch = inst.currentPitch;
-        if (inst.shiftPitchDrop != 0.0f) {
-            unsigned int nowMs = CTimer::m_snTimeInMilliseconds;
-            unsigned int elapsed = (nowMs > inst.shiftStartMs) ? (nowMs - inst.shiftStartMs) : 0;
-            float t = std::min(1.0f, float(elapsed) / float(SHIFT_DROP_DURATION_MS));
-
-            // decay suavizado (ease-out): usa (1 - t)^2 para fechamento mais natural
-            float decayFactor = (1.0f - t);
-            decayFactor = decayFactor * decayFactor; // acelera queda no fim
-            displayPitch += inst.shiftPitchDrop * decayFactor;
-
-            if (t >= 1.0f) {
-                inst.shiftPitchDrop = 0.0f;
-                inst.shiftStartMs = 0;
+        wake_.notify_all();
+        thread_.join();
+    }
+
+    // false se a fila est cheia; urgente (enter-car) passa  frente.
+    // Thread do jogo: o pedido leva o ini e o relgio deste frame, o worker no l nenhum dos dois.
+    bool Enqueue(int modelId, bool urgent, size_t depth) {
+        std::lock_guard<std::mutex> lk(mutex_);
+        if (modelId == loadingModel_) return true;
+        if (std::find_if(queue_.begin(), queue_.end(), [modelId](const Request& r) { return r.modelId == modelId; }) != queue_.end()) return true;
+        if (queue_.size() + (loadingModel_ >= 0 ? 1 : 0) >= depth) return false;
+        Request r = { modelId, CurrentConfig(), CTimer::m_snTimeInMilliseconds };
+        if (urgent) queue_.push_front(std::move(r));
+        else queue_.push_back(std::move(r));
+        wake_.notify_one();
+        return true;
+    }
+
+private:
+    struct Request {
+        int modelId;
+        ConfigRef config;
+        unsigned int requestedAtMs;
+    };
+
+    void Run() {
+        std::unique_lock<std::mutex> lk(mutex_);
+        for (;;) {
+            wake_.wait(lk, [this] { return stop_ || !queue_.empty(); });
+            if (stop_) return;
+            Request r = std::move(queue_.front());
+            queue_.pop_front();
+            loadingModel_ = r.modelId;
+            lk.unlock();
+            {
+                ConfigScope config(std::move(r.config));
+                WriteLog("Prefetch: loading model=%d", r.modelId);
+                LoadBankForModel(r.modelId, true, r.requestedAtMs);
             }
+            lk.lock();
+            loadingModel_ = -1;
         }
+    }
 
-        try { inst.loopChannel->setPitch(displayPitch); }
-        catch (...) {}
+    std::thread thread_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::deque<Request> queue_;
+    int loadingModel_ = -1;
+    bool stop_ = false;
+};
 
+static BankPrefetcher g_bankPrefetcher;
 
-        // volume (mantm lgica anterior)
-        float desiredVol = 0.45f + ratio * 0.55f;
-        inst.currentVolume = inst.currentVolume + (desiredVol - inst.currentVolume) * baseAlpha;
-        try { inst.loopChannel->setVolume(inst.currentVolume); }
-        catch (...) {}
+static CVehicle* EnterCarTarget(CPed* ped) {
+    if (!ped || !ped->m_pIntelligence) return nullptr;
+    CTask* task = ped->m_pIntelligence->m_TaskMgr.FindActiveTaskByType(TASK_COMPLEX_ENTER_CAR_AS_DRIVER);
+    if (!task) return nullptr;
+    return *reinterpret_cast<CVehicle**>(reinterpret_cast<uintptr_t>(task) + TASK_ENTER_CAR_TARGET_OFFSET);
+}
+
+// liberta bancos de prefetch que nunca chegaram a ser usados; devolve os bytes que ficam.
+// Thread do jogo:  o nico que reclama prefetches (LoadBankForModel sem prefetch).
+static unsigned long long ExpirePrefetchedBanks(unsigned int expireMs) {
+    unsigned int now = CTimer::m_snTimeInMilliseconds;
+    unsigned long long bytes = 0;
+    g_modelBanks.ForEach([&](BankRegistry::Slot& s) {
+        unsigned int at = s.prefetchedAtMs.load(std::memory_order_acquire);
+        if (!at || s.state.load(std::memory_order_acquire) != BANK_READY) return;
+        WavBank* bank = s.bank.load(std::memory_order_acquire);
+        if ((now - at) < expireMs) {
+            bytes += BankBytes(bank);
+            return;
+        }
+        if (!s.prefetchedAtMs.compare_exchange_strong(at, 0, std::memory_order_acq_rel)) return;
+        int modelId = s.key.load(std::memory_order_relaxed);
+        WriteLog("Prefetch: model=%d unused for %u ms, releasing (%llu KB)", modelId, now - at, BankBytes(bank) >> 10);
+        s.bank.store(nullptr, std::memory_order_release);
+        s.waitedOn.store(false, std::memory_order_relaxed);
+        s.state.store(BANK_ABSENT, std::memory_order_release);
+        for (auto& p : bank->sounds) if (p.second) p.second->release();
+        g_bankEpochs.Retire(bank, DeleteBankStruct);
+        ++g_prefetchStats.wasted;
+    });
+    g_bankEpochs.Collect();
+    return bytes;
+}
 
+// false se a fila encheu (para de pedir nesta ronda)
+static bool RequestPrefetch(int modelId, bool urgent, size_t depth) {
+    BankRegistry::Slot* s = g_modelBanks.Find(modelId);
+    if (s && s->state.load(std::memory_order_acquire) != BANK_ABSENT) return true;
+    return g_bankPrefetcher.Enqueue(modelId, urgent, depth);
+}
 
-        // --- WIND loop control (novo: fade-in temporal + cap por-frame) ---
-        if (inst.bank && inst.bank->sounds.count("wind")) {
-            // calcula target a partir de velocidade/ratio e if accelerating
-            float speedFactor = std::clamp(speed / WIND_SPEED_SCALE, 0.0f, 1.0f);
-            float accelBoost = isAccelerating ? 1.0f : 0.6f;
-            inst.targetWindVolume = WIND_MAX_VOL * speedFactor * accelBoost;
-
-            // garante canal ativo (comea com volume 0) e regista incio para fade-in
-            if (!inst.windChannel) {
-                FMOD::Sound* ws = inst.bank->sounds["wind"];
-                if (ws) {
-                    inst.windChannel = PlayLoop(veh, ws, 0.0f, 1.0f);
-                    if (inst.windChannel) {
-                        try { inst.windChannel->setVolume(0.0f); }
-                        catch (...) {}
-                        inst.windStartMs = CTimer::m_snTimeInMilliseconds;
-                    }
-                }
-            }
+static void PredictPrefetch() {
+    if (GetConfig("Prefetch", 1.0f) == 0.0f) {
+        g_bankPrefetcher.Stop();
+        return;
+    }
+    static unsigned int frame = 0;
+    unsigned int interval = (unsigned int)std::max(1.0f, GetConfig("PrefetchIntervalFrames", 10.0f));
+    if ((++frame % interval) != 0) return;
+
+    unsigned long long residentBytes = ExpirePrefetchedBanks((unsigned int)GetConfig("PrefetchExpireMs", 60000.0f));
+    unsigned long long capBytes = (unsigned long long)(GetConfig("PrefetchMemoryMB", 64.0f) * 1024.0f * 1024.0f);
+    if (residentBytes >= capBytes) return;
+
+    CPed* ped = FindPlayerPed();
+    if (!ped || FindPlayerVehicle(-1, false)) return;  // j a conduzir: o banco j foi pedido
+    g_bankPrefetcher.Start();
+    size_t depth = (size_t)std::max(1.0f, GetConfig("PrefetchQueueDepth", 4.0f));
+
+    CVehicle* target = EnterCarTarget(ped);
+    if (target && IsVehiclePointerValid(target) && !RequestPrefetch(target->m_nModelIndex, true, depth)) return;
+
+    // veculos prximos, do mais perto para o mais longe
+    static std::vector<GridHit> nearby;
+    g_vehicleGrid.Query(ped->GetPosition(), GetConfig("PrefetchRadius", 15.0f), 0, nearby);
+    for (const GridHit& n : nearby) {
+        if (n.veh == target || !IsVehiclePointerValid(n.veh)) continue;
+        if (!RequestPrefetch(n.veh->m_nModelIndex, false, depth)) break;
+    }
+}
 
-            // se o canal j existia mas target subiu de 0 aps despausar, garantimos fade-in tambm:
-            if (inst.windChannel && inst.windStartMs == 0 && inst.currentWindVolume <= 0.0001f) {
-                inst.windStartMs = CTimer::m_snTimeInMilliseconds;
-            }
+static void LogPrefetchStats(const char* when) {
+    const PrefetchStats& s = g_prefetchStats;
+    unsigned long long bytes = 0;
+    int unused = 0;
+    {
+        EpochReclaimer::Guard guard(g_bankEpochs);
+        g_modelBanks.ForEach([&](BankRegistry::Slot& slot) {
+            if (!slot.prefetchedAtMs.load(std::memory_order_acquire)) return;
+            if (WavBank* bank = slot.bank.load(std::memory_order_acquire)) { bytes += BankBytes(bank); ++unused; }
+        });
+    }
+    unsigned int requests = s.requests, hits = s.hits, late = s.late;
+    WriteLog("Prefetch (%s): requests=%u hits=%u late=%u misses=%u hitRate=%.0f%% prefetched=%u wasted=%u unused=%d (%llu KB)",
+        when, requests, hits, late, s.misses.load(), requests ? 100.0 * (hits + late) / requests : 0.0,
+        s.issued.load(), s.wasted.load(), unused, bytes >> 10);
+}
 
-            // cap por-frame
-            float dt2 = std::max(0.0f, CTimer::ms_fTimeStep);
-            float maxDelta = MAX_WIND_RATE_PER_SEC * dt2; // ex: 0.25 * 0.016 = 0.004 por frame (~60fps)
+// ---------------- trace record/replay ----------------
+// RecordTrace=1 grava as entradas de cada frame (as mesmas que o ComputeInstance consome)
+// num arquivo binrio; tools/TraceReplay reproduz o trace fora do jogo com um System
+// FMOD no-realtime e grava o resultado em WAV (golden audio / perf).
+//
+// Formato (little-endian): cabealho "VSFT" + verso, depois registos com tag de 1 byte:
+//   TRACE_MODEL: modelo, n de marchas, velocidade mx. por marcha
+//   TRACE_FRAME: tempo, timestep, pausa, listener, n de instncias + TraceInstance[]
+static const char TRACE_MAGIC[4] = { 'V', 'S', 'F', 'T' };
+static const unsigned int TRACE_VERSION = 1;
+enum TraceTag : unsigned char { TRACE_MODEL = 1, TRACE_FRAME = 2 };
+
+enum TraceFlags : unsigned char {
+    TF_ACTIVE = 1 << 0,
+    TF_STOP_ALL = 1 << 1,
+    TF_PAD = 1 << 2,
+    TF_GAS = 1 << 3,
+};
 
-            // compute fade progress (0..1) baseado no windStartMs
-            float fadeFactor = 1.0f;
-            if (inst.windStartMs != 0) {
-                unsigned int nowMs = CTimer::m_snTimeInMilliseconds;
-                unsigned int elapsed = (nowMs > inst.windStartMs) ? (nowMs - inst.windStartMs) : 0;
-                fadeFactor = std::clamp(float(elapsed) / WIND_FADE_MS, 0.0f, 1.0f);
-            }
+#pragma pack(push, 1)
+struct TraceModelRecord {
+    int modelIndex;
+    int gearCount;
+    float gearMaxVelocity[MAX_TRANSMISSION_GEARS + 1];
+};
 
-            // desired volume considerando fade-in
-            float desiredWithFade = inst.targetWindVolume * fadeFactor;
+struct TraceFrameHeader {
+    unsigned int nowMs;
+    float timeStep;
+    unsigned char paused;
+    FMOD_VECTOR listenerPos, listenerAt, listenerUp;
+    unsigned short count;
+};
 
-            // diferena e aplicao do cap por-frame (no ultrapassar maxDelta)
-            float diff = desiredWithFade - inst.currentWindVolume;
-            if (diff > maxDelta) diff = maxDelta;
-            else if (diff < -maxDelta) diff = -maxDelta;
-            inst.currentWindVolume += diff;
+struct TraceInstance {
+    unsigned int vehKey;
+    short modelIndex;
+    unsigned char flags;
+    signed char gear;
+    float speed, gearMax, wheelSpin;
+    FMOD_VECTOR pos, vel;
+};
+#pragma pack(pop)
 
-            // debug para log
-            WriteLog("WIND: model=%d speed=%.2f speedF=%.3f target=%.3f fade=%.3f want=%.3f cur=%.3f accel=%d ch=%p",
-                veh->m_nModelIndex, speed, speedFactor, inst.targetWindVolume, fadeFactor, desiredWithFade, inst.currentWindVolume,
-                isAccelerating ? 1 : 0, (void*)inst.windChannel);
+struct ListenerState {
+    FMOD_VECTOR pos = { 0.0f, 0.0f, 0.0f };
+    FMOD_VECTOR at = { 0.0f, 1.0f, 0.0f };
+    FMOD_VECTOR up = { 0.0f, 0.0f, 1.0f };
+};
+static ListenerState g_listener;
 
-            // aplica volume e 3D attrs (se aplicvel)
-            if (inst.windChannel) {
-                try { inst.windChannel->setVolume(inst.currentWindVolume); }
-                catch (...) {}
-                CVector pos2 = veh->GetPosition();
-                FMOD_VECTOR fv2 = { pos2.x, pos2.y, pos2.z };
-                FMOD_VECTOR vel2 = { veh->m_vecMoveSpeed.x, veh->m_vecMoveSpeed.y, veh->m_vecMoveSpeed.z };
-                try { inst.windChannel->set3DAttributes(&fv2, &vel2); }
-                catch (...) {}
-            }
+class TraceRecorder {
+public:
+    bool Open(const std::string& path) {
+        m_file.open(path, std::ios::binary | std::ios::trunc);
+        if (!m_file.is_open()) { WriteLog("TraceRecorder: cannot open %s", path.c_str()); return false; }
+        m_file.write(TRACE_MAGIC, 4);
+        m_file.write((const char*)&TRACE_VERSION, sizeof(TRACE_VERSION));
+        m_frames = 0;
+        WriteLog("TraceRecorder: recording to %s", path.c_str());
+        return true;
+    }
 
-            // parar o canal se muito baixo e veculo praticamente parado
-            if (inst.windChannel && inst.currentWindVolume < WIND_STOP_THRESHOLD && !isAccelerating && speed < 0.5f) {
-                StopChannelSafe(inst.windChannel);
-                inst.currentWindVolume = 0.0f;
-                inst.targetWindVolume = 0.0f;
-                inst.windStartMs = 0;
-            }
+    bool IsOpen() const { return m_file.is_open(); }
+
+    void WriteFrame(const std::vector<VehicleAudioInstance*>& list, const std::vector<InstanceInputs>& inputs, const ListenerState& listener) {
+        if (!IsOpen()) return;
+        // perfil de cada modelo vai antes da primeira frame que o usa (e de novo se mudar)
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            if (!inputs[i].active || !list[i]->bank) continue;
+            const TransmissionProfile& prof = list[i]->bank->transmission;
+            unsigned int& seen = m_modelFingerprints[inputs[i].modelIndex];
+            unsigned int fp = prof.fingerprint | 1u;
+            if (seen == fp) continue;
+            seen = fp;
+            TraceModelRecord m = {};
+            m.modelIndex = inputs[i].modelIndex;
+            m.gearCount = prof.gearCount;
+            std::copy(prof.gearMaxVelocity, prof.gearMaxVelocity + MAX_TRANSMISSION_GEARS + 1, m.gearMaxVelocity);
+            Put(TRACE_MODEL, &m, sizeof(m));
         }
 
+        TraceFrameHeader h = {};
+        h.nowMs = CTimer::m_snTimeInMilliseconds;
+        h.timeStep = CTimer::ms_fTimeStep;
+        h.paused = IsGamePaused() ? 1 : 0;
+        h.listenerPos = listener.pos;
+        h.listenerAt = listener.at;
+        h.listenerUp = listener.up;
+        h.count = (unsigned short)std::min<size_t>(inputs.size(), 0xFFFF);
+        Put(TRACE_FRAME, &h, sizeof(h));
+        for (size_t i = 0; i < h.count; ++i) {
+            const InstanceInputs& in = inputs[i];
+            TraceInstance t = {};
+            t.vehKey = (unsigned int)in.vehKey;
+            t.modelIndex = (short)in.modelIndex;
+            t.flags = (in.active ? TF_ACTIVE : 0) | (in.stopAll ? TF_STOP_ALL : 0) | (in.padPressed ? TF_PAD : 0) | (in.gasPressed ? TF_GAS : 0);
+            t.gear = (signed char)in.gear;
+            t.speed = in.speed;
+            t.gearMax = in.gearMax;
+            t.wheelSpin = in.wheelSpin;
+            t.pos = in.emitter.pos;
+            t.vel = in.emitter.vel;
+            m_buffer.insert(m_buffer.end(), (const char*)&t, (const char*)&t + sizeof(t));
+        }
+        ++m_frames;
+        if (m_buffer.size() >= TRACE_FLUSH_BYTES) Flush();
+    }
 
+    void Close() {
+        if (!IsOpen()) return;
+        Flush();
+        m_file.close();
+        m_modelFingerprints.clear();
+        WriteLog("TraceRecorder: closed after %u frames", m_frames);
+    }
 
+private:
+    static const size_t TRACE_FLUSH_BYTES = 64 * 1024;
 
-        try { inst.loopChannel->set3DAttributes(&fv, &vel); }
-        catch (...) {}
+    void Put(TraceTag tag, const void* data, size_t size) {
+        m_buffer.push_back((char)tag);
+        m_buffer.insert(m_buffer.end(), (const char*)data, (const char*)data + size);
+    }
 
-        // restart if channel died (no tentar iniciar novo se jogo est pausado)
-        bool isPlaying = true;
-        if (inst.loopChannel && inst.loopChannel->isPlaying(&isPlaying) == FMOD_OK && !isPlaying) {
-            WriteLog("Loop died; restarting loop for model=%d mode=%d", veh->m_nModelIndex, (int)inst.loopMode);
-            std::string key = (inst.loopMode == LM_IDLE) ? "idle" : "engine";
-            StopChannelSafe(inst.loopChannel);
-            if (!IsGamePaused()) {
-                FMOD::Sound* s = (inst.bank && inst.bank->sounds.count(key)) ? inst.bank->sounds[key] : nullptr;
-                if (s) inst.loopChannel = PlayLoop(veh, s, inst.currentVolume, inst.currentPitch);
-            }
-        }
+    void Flush() {
+        if (!m_buffer.empty()) m_file.write(m_buffer.data(), (std::streamsize)m_buffer.size());
+        m_buffer.clear();
     }
-}
+
+    std::ofstream m_file;
+    std::vector<char> m_buffer;
+    std::map<int, unsigned int> m_modelFingerprints;
+    unsigned int m_frames = 0;
+};
+
+static TraceRecorder g_traceRecorder;
+
 // ---------------- Funes de pausa simplificada ----------------
 static void SetPausedVolume(bool paused) {
-    std::lock_guard<std::mutex> lk(g_mutex);
-
     for (auto& kv : g_vehicleInstances) {
         VehicleAudioInstance& inst = kv.second;
 
@@ -924,7 +4579,7 @@ static void SetPausedVolume(bool paused) {
                     inst.loopChannel->setVolume(0.0f);
                 }
                 else {
-                    float restore = (inst.storedLoopVolume > 0.0f) ? inst.storedLoopVolume : inst.currentVolume;
+                    float restore = (inst.storedLoopVolume > 0.0f) ? inst.storedLoopVolume : inst.currentVolume * BankGain(inst.bank, LoopSlot(inst.loopMode));
                     inst.loopChannel->setVolume(restore);
                 }
             }
@@ -942,7 +4597,7 @@ static void SetPausedVolume(bool paused) {
                     float restore = (inst.storedWindVolume > 0.0f) ? inst.storedWindVolume : inst.currentWindVolume;
                     inst.targetWindVolume = restore;
                     inst.currentWindVolume = 0.0f;                      // parte de zero
-                    inst.windStartMs = CTimer::m_snTimeInMilliseconds;  // fora fade-in
+                    StartWindFade(g_instanceTimers, inst, CTimer::m_snTimeInMilliseconds);  // fora fade-in
                     try { inst.windChannel->setVolume(0.0f); }
                     catch (...) {}
                 }
@@ -982,11 +4637,365 @@ static void SetPausedVolume(bool paused) {
 }
 
 
+// ---------------- vehicle process hooks ----------------
+// CAutomobile/CBike::ProcessControl correm depois do processScriptsEvent na mesma frame,
+// por isso o OnProcess v sempre a fsica da frame anterior. O hook guarda a marcha logo
+// aps a fsica (medio de latncia nos dois modos) e, com UpdateMode=physics, faz
+// gather/clculo/submit dessa instncia ali mesmo; o core->update() passa para o
+// drawingEvent, o mais tarde possvel antes do present.
+static const uintptr_t ADDR_AUTOMOBILE_PROCESS_CONTROL = 0x6B1880;
+static const uintptr_t ADDR_BIKE_PROCESS_CONTROL = 0x6B9250;
+static const unsigned int GEAR_LATENCY_MAX_FRAMES = 30;  // sem shiftup at aqui: descarta a medio
+
+typedef void(__fastcall* VehicleProcessControlFn)(CVehicle*, void*);
+static VehicleProcessControlFn g_origAutomobileProcessControl = nullptr;
+static VehicleProcessControlFn g_origBikeProcessControl = nullptr;
+static bool g_vehicleProcessHooks = false;
+
+static std::vector<VehicleAudioInstance*> g_physicsTraceInstances;  // frame do trace no modo physics
+static std::vector<InstanceInputs> g_physicsTraceInputs;
+
+static bool PhysicsUpdateActive() { return UPDATE_IN_PHYSICS && g_vehicleProcessHooks; }
+
+static void UpdateListener(FMOD::System* core) {
+    // set listener from camera (no fatal)
+    try {
+        CVector camPos = TheCamera.GetPosition();
+        CMatrix* camM = TheCamera.GetMatrix();
+        FMOD_VECTOR lp = { camPos.x, camPos.y, camPos.z };
+        FMOD_VECTOR lv = { 0.0f, 0.0f, 0.0f };
+        FMOD_VECTOR lf = { camM->at.x, camM->at.y, camM->at.z };
+        FMOD_VECTOR lu = { camM->up.x, camM->up.y, camM->up.z };
+        core->set3DListenerAttributes(0, &lp, &lv, &lf, &lu);
+        g_listener.pos = lp;
+        g_listener.at = lf;
+        g_listener.up = lu;
+    }
+    catch (...) {}
+}
+
+static void AfterVehiclePhysics(CVehicle* veh) {
+    g_vehicleGrid.Update(veh, veh->GetPosition());
+    if (!g_fmodReady.load(std::memory_order_acquire)) return;
+    auto it = g_vehicleInstances.find(veh);
+    if (it == g_vehicleInstances.end()) return;
+    VehicleAudioInstance& inst = it->second;
+
+    int gear = (int)veh->m_nCurrentGear;
+    if (inst.physicsGear >= 0 && gear > inst.physicsGear) {
+        inst.gearChangePending = true;
+        inst.gearChangeFrame = CTimer::m_FrameCounter;
+        inst.gearChangeTime = std::chrono::steady_clock::now();
+    }
+    else if (inst.gearChangePending && (CTimer::m_FrameCounter - inst.gearChangeFrame) > GEAR_LATENCY_MAX_FRAMES) {
+        inst.gearChangePending = false;
+    }
+    inst.physicsGear = gear;
+
+    if (!PhysicsUpdateActive() || g_gamePaused || !IsVehiclePointerValid(veh)) return;
+    if (inst.dormant) {
+        inst.physicsFrame = CTimer::m_FrameCounter;  // sondado aqui: o OnProcess no repete
+        if (!DormantShouldWake(inst, SampleDormantProbe(inst, veh, g_dormancyPlayerVeh))) return;
+        WakeInstance(inst, WAKE_INPUT);
+    }
+    static std::vector<VehicleAudioInstance*> one;
+    one.assign(1, &inst);
+    UpdateInstances(one);
+    SettleInstances(g_instanceTimers, one, g_frameInputs, g_listener.pos);
+    inst.physicsFrame = CTimer::m_FrameCounter;
+    g_physicsTraceInstances.push_back(&inst);
+    g_physicsTraceInputs.push_back(g_frameInputs[0]);
+}
+
+static void __fastcall HookAutomobileProcessControl(CVehicle* self, void* edx) {
+    g_origAutomobileProcessControl(self, edx);
+    AfterVehiclePhysics(self);
+}
+
+static void __fastcall HookBikeProcessControl(CVehicle* self, void* edx) {
+    g_origBikeProcessControl(self, edx);
+    AfterVehiclePhysics(self);
+}
+
+static void InstallVehicleProcessHooks() {
+    static const GameHook hooks[] = {
+        { ADDR_AUTOMOBILE_PROCESS_CONTROL, (void*)&HookAutomobileProcessControl, (void**)&g_origAutomobileProcessControl, "CAutomobile::ProcessControl" },
+        { ADDR_BIKE_PROCESS_CONTROL, (void*)&HookBikeProcessControl, (void**)&g_origBikeProcessControl, "CBike::ProcessControl" },
+    };
+    g_vehicleProcessHooks = InstallHookGroup(hooks, 2, "InstallVehicleProcessHooks");
+    if (!g_vehicleProcessHooks && UPDATE_IN_PHYSICS) WriteLog("InstallVehicleProcessHooks: UpdateMode=physics unavailable, updating from processScriptsEvent");
+    WriteLog("InstallVehicleProcessHooks: %s, update mode=%s", g_vehicleProcessHooks ? "installed" : "failed", PhysicsUpdateActive() ? "physics" : "scripts");
+}
+
+// ---------------- occlusion ----------------
+// Um raio cmara -> veculo por consulta, com oramento fixo por frame (OcclusionRaysPerFrame).
+// Cada instncia acumula crdito proporcional  audibilidade (volume e distncia); quando
+// o resultado em cache passa do OcclusionTTLMs fica elegvel e as de maior crdito so
+// servidas primeiro: round-robin ponderado, carros distantes esperam mais mas nunca
+// ficam sem raio. O alvo (0/1)  suavizado com OcclusionSmoothMs e aplicado com
+// set3DOcclusion (volume + low-pass do FMOD) a todos os canais da instncia.
+static const float OCCLUSION_REF_DIST = 10.0f;    // m; a audibilidade cai para metade a esta distncia
+static const float OCCLUSION_MIN_WEIGHT = 0.02f;  // carros quase inaudveis continuam na rotao
+static const float OCCLUSION_MAX_DIST = 300.0f;   // = max distance 3D dos canais; alm disso no se lana raio
+static const float OCCLUSION_EMITTER_HEIGHT = 1.0f;  // raio para o tejadilho, no para o cho
+
+// consulta ao mundo; o jogo usa CWorld, o benchmark uma geometria sinttica
+class OcclusionWorld {
+public:
+    virtual ~OcclusionWorld() {}
+    virtual bool Occluded(const FMOD_VECTOR& from, const FMOD_VECTOR& to) = 0;
+};
+
+class GameOcclusionWorld : public OcclusionWorld {
+public:
+    bool Occluded(const FMOD_VECTOR& from, const FMOD_VECTOR& to) override {
+        CVector a(from.x, from.y, from.z), b(to.x, to.y, to.z);
+        // s edifcios: veculos/peds/objetos mudam demasiado para valer um raio
+        return !CWorld::GetIsLineOfSightClear(a, b, true, false, false, false, false, false, false);
+    }
+};
+
+struct OcclusionParams {
+    int raysPerFrame = 4;
+    unsigned int ttlMs = 250;
+    float smoothMs = 120.0f;
+    float direct = 0.7f;   // set3DOcclusion com ocluso total
+    float reverb = 0.35f;
+};
+
+static OcclusionParams LoadOcclusionParams() {
+    OcclusionParams p;
+    p.raysPerFrame = (int)GetConfig("OcclusionRaysPerFrame", 4.0f);
+    p.ttlMs = (unsigned int)std::max(0.0f, GetConfig("OcclusionTTLMs", 250.0f));
+    p.smoothMs = std::max(0.0f, GetConfig("OcclusionSmoothMs", 120.0f));
+    p.direct = std::clamp(GetConfig("OcclusionDirect", 0.7f), 0.0f, 1.0f);
+    p.reverb = std::clamp(GetConfig("OcclusionReverb", 0.35f), 0.0f, 1.0f);
+    return p;
+}
+
+struct OcclusionTarget {
+    OcclusionState* state;
+    FMOD_VECTOR pos;
+    float audibility;
+};
+
+struct OcclusionStats {
+    unsigned long long frames = 0;
+    unsigned long long rays = 0;
+    unsigned long long refreshAgeMs = 0;  // soma da idade da cache quando foi refrescada
+    unsigned long long refreshes = 0;     // refrescos de resultados j vlidos
+    unsigned int maxBacklog = 0;          // elegveis que ficaram para a frame seguinte
+    unsigned int occluded = 0;            // na ltima frame
+};
+
+static OcclusionStats g_occlusionStats;
+static GameOcclusionWorld g_gameOcclusionWorld;
+
+static float OcclusionAudibility(float volume, float distance) {
+    return volume / (1.0f + distance / OCCLUSION_REF_DIST);
+}
+
+// lana at p.raysPerFrame raios e suaviza todos os alvos; devolve os raios lanados
+static int ScheduleOcclusion(OcclusionWorld& world, const FMOD_VECTOR& listener, std::vector<OcclusionTarget>& targets,
+    const OcclusionParams& p, unsigned int nowMs, float dtSec, OcclusionStats& stats) {
+    static std::vector<OcclusionTarget*> due;
+    due.clear();
+    for (OcclusionTarget& t : targets) {
+        OcclusionState& s = *t.state;
+        s.credit += std::max(t.audibility, OCCLUSION_MIN_WEIGHT);
+        if (!s.valid || (nowMs - s.checkedMs) >= p.ttlMs) due.push_back(&t);
+    }
+    int rays = std::min((int)due.size(), std::max(0, p.raysPerFrame));
+    std::partial_sort(due.begin(), due.begin() + rays, due.end(),
+        [](const OcclusionTarget* a, const OcclusionTarget* b) { return a->state->credit > b->state->credit; });
+    for (int i = 0; i < rays; ++i) {
+        OcclusionState& s = *due[i]->state;
+        s.target = world.Occluded(listener, due[i]->pos) ? 1.0f : 0.0f;
+        if (s.valid) { stats.refreshAgeMs += nowMs - s.checkedMs; ++stats.refreshes; }
+        else s.current = s.target;  // primeiro resultado: sem fade a partir de "livre"
+        s.valid = true;
+        s.checkedMs = nowMs;
+        s.credit = 0.0f;
+    }
+
+    float k = (p.smoothMs > 0.0f) ? 1.0f - std::exp(-(dtSec * 1000.0f) / p.smoothMs) : 1.0f;
+    stats.occluded = 0;
+    for (OcclusionTarget& t : targets) {
+        OcclusionState& s = *t.state;
+        s.current += (s.target - s.current) * k;
+        if (s.target > 0.5f) ++stats.occluded;
+    }
+    ++stats.frames;
+    stats.rays += rays;
+    stats.maxBacklog = std::max(stats.maxBacklog, (unsigned int)(due.size() - rays));
+    return rays;
+}
+
+// s chama o FMOD quando o valor mexe ou apareceu um canal novo
+static void ApplyOcclusion(VehicleAudioInstance& inst, const OcclusionParams& p) {
+    OcclusionState& s = inst.occlusion;
+    FMOD::Channel* chans[4] = { inst.loopChannel, inst.windChannel, inst.attackChannel, inst.shiftChannel };
+    bool changed = std::fabs(s.current - s.applied) >= 0.005f;
+    if (changed) s.applied = s.current;
+    float direct = s.applied * p.direct, reverb = s.applied * p.reverb;
+    for (int i = 0; i < 4; ++i) {
+        if (!chans[i] || (!changed && chans[i] == s.appliedTo[i])) continue;
+        try { chans[i]->set3DOcclusion(direct, reverb); }
+        catch (...) {}
+        s.appliedTo[i] = chans[i];
+    }
+}
+
+static void LogOcclusionStats(const char* when) {
+    const OcclusionStats& s = g_occlusionStats;
+    WriteLog("Occlusion (%s): %.2f rays/frame over %llu frames, avg cache age at refresh %.0f ms, max backlog %u, occluded now %u",
+        when, s.frames ? double(s.rays) / s.frames : 0.0, s.frames, s.refreshes ? double(s.refreshAgeMs) / s.refreshes : 0.0,
+        s.maxBacklog, s.occluded);
+}
+
+static void UpdateOcclusion() {
+    OcclusionParams p = LoadOcclusionParams();
+    bool enabled = p.raysPerFrame > 0;
+    static std::vector<OcclusionTarget> targets;
+    static std::vector<VehicleAudioInstance*> owners;
+    targets.clear();
+    owners.clear();
+    FMOD_VECTOR listener = g_listener.pos;
+    for (auto& kv : g_vehicleInstances) {
+        VehicleAudioInstance& inst = kv.second;
+        if (!inst.bank || inst.dormantReleased || !IsVehiclePointerValid(kv.first)) continue;
+        if (!enabled) {
+            // desligado pelo ini: volta a "livre" e deixa o ApplyOcclusion limpar os canais
+            inst.occlusion.target = inst.occlusion.current = 0.0f;
+            inst.occlusion.valid = false;
+            ApplyOcclusion(inst, p);
+            continue;
+        }
+        CVector v = kv.first->GetPosition();
+        FMOD_VECTOR pos = { v.x, v.y, v.z + OCCLUSION_EMITTER_HEIGHT };
+        float dx = pos.x - listener.x, dy = pos.y - listener.y, dz = pos.z - listener.z;
+        float d = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if (d > OCCLUSION_MAX_DIST) continue;
+        targets.push_back({ &inst.occlusion, pos, OcclusionAudibility(inst.currentVolume, d) });
+        owners.push_back(&inst);
+    }
+    if (!enabled || g_gamePaused) return;
+    ScheduleOcclusion(g_gameOcclusionWorld, listener, targets, p, CTimer::m_snTimeInMilliseconds,
+        CTimer::ms_fTimeStep / GAME_TIMESTEP_HZ, g_occlusionStats);
+    for (VehicleAudioInstance* inst : owners) ApplyOcclusion(*inst, p);
+}
+
+// AudibleVehicles=N (0 = s o carro do jogador): at N instncias extra para os carros vsfx
+// mais prximos do ouvinte, escolhidos pela grelha. Uma instncia ambiente fica at o
+// carro sair do raio audvel (com margem), para no trocar de som entre carros vizinhos.
+static const float AMBIENT_DROP_FACTOR = 1.1f;
+
+static void SelectAudibleVehicles(CVehicle* playerVeh) {
+    int wanted = std::max(0, (int)GetConfig("AudibleVehicles", 0.0f));
+    CVector center(g_listener.pos.x, g_listener.pos.y, g_listener.pos.z);
+    float dropDist = AUDIBLE_RADIUS * AMBIENT_DROP_FACTOR;
+
+    int kept = 0;
+    for (auto it = g_vehicleInstances.begin(); it != g_vehicleInstances.end();) {
+        VehicleAudioInstance& inst = it->second;
+        if (it->first == playerVeh) inst.ambient = false;  // o jogador entrou num carro ambiente
+        if (!inst.ambient) { ++it; continue; }
+        if (kept < wanted && IsVehiclePointerValid(it->first) && (it->first->GetPosition() - center).Magnitude() <= dropDist) {
+            ++kept;
+            ++it;
+            continue;
+        }
+        StopInstanceChannels(inst);
+        CancelInstanceTimers(g_instanceTimers, inst);
+        ReleaseGameEngine(it->first);
+        it = g_vehicleInstances.erase(it);
+    }
+    if (kept >= wanted) return;
+
+    static std::vector<GridHit> hits;
+    g_vehicleGrid.Query(center, AUDIBLE_RADIUS, 0, hits);
+    for (const GridHit& h : hits) {
+        if (kept >= wanted) break;
+        if (h.veh == playerVeh || g_vehicleInstances.count(h.veh) || !IsVehiclePointerValid(h.veh)) continue;
+        if (!IsVsfxModel(h.veh->m_nModelIndex)) continue;
+        VehicleAudioInstance inst;
+        inst.vehicle = h.veh;
+        inst.currentVolume = 0.45f;
+        inst.ambient = true;
+        g_vehicleInstances[h.veh] = inst;
+        ++kept;
+        WriteLog("Created ambient audio instance modelId=%d at %.0f m", h.veh->m_nModelIndex, h.dist);
+    }
+}
+
+// wakes que no vm do prprio veculo: reload do ini (ou DormantAfterMs=0), jogador entra
+// num carro adormecido e, a cada DORMANT_SCAN_MS, a distncia ao ouvinte (liberta o loop de
+// quem ficou longe, acorda quem foi libertado e ficou perto outra vez)
+static const unsigned int DORMANT_SCAN_MS = 250;
+static const float DORMANT_WAKE_FACTOR = 0.9f;  // histerese da distncia
+
+static void UpdateDormancy(CVehicle* playerVeh) {
+    static unsigned int generation = 0;
+    static unsigned int lastScanMs = 0;
+    unsigned int now = CTimer::m_snTimeInMilliseconds;
+
+    if (playerVeh != g_dormancyPlayerVeh) {
+        auto it = playerVeh ? g_vehicleInstances.find(playerVeh) : g_vehicleInstances.end();
+        if (it != g_vehicleInstances.end()) WakeInstance(it->second, WAKE_LIFECYCLE);
+        g_dormancyPlayerVeh = playerVeh;
+    }
+    bool wakeAll = generation != g_configGeneration || DORMANT_AFTER_MS <= 0.0f;
+    generation = g_configGeneration;
+    if (!wakeAll && now - lastScanMs < DORMANT_SCAN_MS) return;
+    lastScanMs = now;
+
+    float wakeDist2 = DORMANT_RELEASE_DIST * DORMANT_WAKE_FACTOR * DORMANT_RELEASE_DIST * DORMANT_WAKE_FACTOR;
+    float releaseDist2 = DORMANT_RELEASE_DIST * DORMANT_RELEASE_DIST;
+    for (auto& kv : g_vehicleInstances) {
+        VehicleAudioInstance& inst = kv.second;
+        if (!inst.dormant) continue;
+        if (wakeAll) {
+            WakeInstance(inst, WAKE_LIFECYCLE);
+            continue;
+        }
+        if (!inst.dormantValid || !IsVehiclePointerValid(kv.first)) continue;
+        CVector v = kv.first->GetPosition();
+        float dx = v.x - g_listener.pos.x, dy = v.y - g_listener.pos.y, dz = v.z - g_listener.pos.z;
+        float d2 = dx * dx + dy * dy + dz * dz;
+        if (inst.dormantReleased && d2 < wakeDist2) WakeInstance(inst, WAKE_PROXIMITY);
+        else if (!inst.dormantReleased && d2 > releaseDist2) {
+            StopInstanceChannels(inst);
+            inst.loopMode = LM_NONE;
+            inst.dormantReleased = true;
+            ++g_dormancy.released;
+        }
+    }
+}
+
 // ---------------- main per-frame ----------------
 static void OnProcess() {
+    // o FMOD arranca noutro thread; at estar pronto o plugin no faz nada
+    if (!g_fmodReady.load(std::memory_order_acquire)) return;
     FMOD::System* core = GetCoreSystem();
     if (!core) return;
 
+    ReloadConfigIfChanged();
+    UpdateTelemetry();
+    UpdateHotReload();
+    ResyncVehicleGrid(!g_vehicleProcessHooks);
+    PredictPrefetch();
+
+    static unsigned int lastMemoryLogMs = 0;
+    unsigned int memoryLogMs = (unsigned int)GetConfig("FMODMemoryLogMs", 60000.0f);
+    if (memoryLogMs > 0 && (CTimer::m_snTimeInMilliseconds - lastMemoryLogMs) >= memoryLogMs) {
+        lastMemoryLogMs = CTimer::m_snTimeInMilliseconds;
+        LogFMODMemory("periodic");
+        LogPrefetchStats("periodic");
+        LogGameEngineAudio("periodic");
+        LogOcclusionStats("periodic");
+        LogDormancyStats("periodic");
+    }
+
     // handle global pause/unpause transitions
     bool pausedNow = IsGamePaused();
     if (pausedNow && !g_gamePaused) {
@@ -1000,20 +5009,14 @@ static void OnProcess() {
         g_gamePaused = false;
     }
 
-    // set listener from camera (no fatal)
-    try {
-        CVector camPos = TheCamera.GetPosition();
-        CMatrix* camM = TheCamera.GetMatrix();
-        FMOD_VECTOR lp = { camPos.x, camPos.y, camPos.z };
-        FMOD_VECTOR lv = { 0.0f, 0.0f, 0.0f };
-        FMOD_VECTOR lf = { camM->at.x, camM->at.y, camM->at.z };
-        FMOD_VECTOR lu = { camM->up.x, camM->up.y, camM->up.z };
-        core->set3DListenerAttributes(0, &lp, &lv, &lf, &lu);
-    }
-    catch (...) {}
+    bool physicsMode = PhysicsUpdateActive();
+    if (!physicsMode) UpdateListener(core);
+    UpdateDormancy(FindPlayerVehicle(-1, true));
 
     // iterar sobre instncias  removemos APENAS quando ponteiro invlido
     std::vector<CVehicle*> toRemove;
+    g_frameInstances.clear();
+    unsigned int active = 0, dormant = 0;
     for (auto& kv : g_vehicleInstances) {
         CVehicle* v = kv.first;
         VehicleAudioInstance& inst = kv.second;
@@ -1021,28 +5024,56 @@ static void OnProcess() {
         // se ponteiro invlido -> parar canais e marcar para remoo
         if (!IsVehiclePointerValid(v)) {
             WriteLog("OnProcess: vehicle pointer invalid, stopping channels for model=%d", (v ? v->m_nModelIndex : -1));
-            StopChannelSafe(inst.loopChannel);
-            StopChannelSafe(inst.pendingLoopChannel);
-            StopChannelSafe(inst.attackChannel);
-            StopChannelSafe(inst.shiftChannel);
-            StopChannelSafe(inst.windChannel); // parar wind tambm
+            StopInstanceChannels(inst); // parar wind tambm
 
             toRemove.push_back(v);
             continue;
         }
 
+        // adormecida: s a sonda (no modo physics o hook j sondou os veculos processados)
+        if (inst.dormant) {
+            bool probed = physicsMode && (CTimer::m_FrameCounter - inst.physicsFrame) <= 1;
+            if (probed || !DormantShouldWake(inst, SampleDormantProbe(inst, v, g_dormancyPlayerVeh))) {
+                ++dormant;
+                continue;
+            }
+            WakeInstance(inst, WAKE_INPUT);
+        }
+        ++active;
+
+        // modo physics: o hook do ProcessControl trata das instncias cujo veculo foi
+        // processado na frame anterior; aqui s ficam as restantes
+        if (physicsMode && (CTimer::m_FrameCounter - inst.physicsFrame) <= 1) continue;
+
         // caso contrrio, atualiza a instncia normalmente (mesmo que o player esteja fora do carro)
-        UpdateInstance(inst);
+        g_frameInstances.push_back(&inst);
+    }
+    g_dormancy.active = active;
+    g_dormancy.dormant = dormant;
+    g_dormancy.activeSum += active;
+    g_dormancy.dormantSum += dormant;
+    ++g_dormancy.frames;
+
+    EnsureWorkerPool();
+    UpdateInstances(g_frameInstances);
+    SettleInstances(g_instanceTimers, g_frameInstances, g_frameInputs, g_listener.pos);
+    if (physicsMode) {
+        g_physicsTraceInstances.insert(g_physicsTraceInstances.end(), g_frameInstances.begin(), g_frameInstances.end());
+        g_physicsTraceInputs.insert(g_physicsTraceInputs.end(), g_frameInputs.begin(), g_frameInputs.end());
     }
+    else g_traceRecorder.WriteFrame(g_frameInstances, g_frameInputs, g_listener);
 
     // efetua remoes depois do loop
     for (CVehicle* v : toRemove) {
+        ReleaseGameEngine(v);
         auto it = g_vehicleInstances.find(v);
         if (it != g_vehicleInstances.end()) {
+            CancelInstanceTimers(g_instanceTimers, it->second);
             g_vehicleInstances.erase(it);
             WriteLog("OnProcess: removed audio instance for vehicle ptr=%p", (void*)v);
         }
     }
+    UpdateOcclusion();
 
     // garante que existe instncia para o veculo atual do player (se houver)
     CVehicle* playerVeh = FindPlayerVehicle(-1, true);
@@ -1062,9 +5093,7 @@ static void OnProcess() {
             inst.lastGear = INT_MIN;
             inst.wasAccelerating = false;
             inst.lastAccelReleaseMs = 0;
-            inst.lastShiftUpMs = 0;
-            inst.lastShiftDnMs = 0;
-            inst.lastBackfireMs = 0;
+            inst.rngState = 0;
             inst.windChannel = nullptr;
             inst.currentWindVolume = 0.0f;
             inst.targetWindVolume = 0.0f;
@@ -1077,45 +5106,98 @@ static void OnProcess() {
             WriteLog("Created audio instance for player vehicle modelId=%d", playerVeh->m_nModelIndex);
         }
     }
+    SelectAudibleVehicles(playerVeh);
 
-    // atualizar FMOD
+    // atualizar FMOD (no modo physics o update fica para o OnDrawing)
+    if (physicsMode) return;
     try {
         core->update();
     }
     catch (...) {}
 }
 
+// modo physics: ltimo ponto da frame antes do present -> listener da cmara final,
+// trace da frame e core->update()
+static void OnDrawing() {
+    if (!g_fmodReady.load(std::memory_order_acquire)) return;
+    FMOD::System* core = GetCoreSystem();
+    if (!core || !PhysicsUpdateActive()) return;
+    UpdateListener(core);
+    g_traceRecorder.WriteFrame(g_physicsTraceInstances, g_physicsTraceInputs, g_listener);
+    g_physicsTraceInstances.clear();
+    g_physicsTraceInputs.clear();
+    try { core->update(); }
+    catch (...) {}
+}
+
 
 // ---------------- init/shutdown FMOD ----------------
-static void InitFMOD() {
-    if (g_fmodCore) return;
+// init do FMOD e assets opcionais correm num thread prprio para no atrasar o boot;
+// OnProcess s comea depois de g_fmodReady
+static void InitFMODWorker(OutputProfile profile, std::string tracePath) {
+    auto t0 = std::chrono::steady_clock::now();
     FMOD::System* system = nullptr;
-    WriteLog("InitFMOD: starting...");
     FMOD_RESULT r = FMOD::System_Create(&system);
-    if (r != FMOD_OK) { WriteLog("FMOD create failed r=%d", (int)r); return; }
-    r = system->init(512, FMOD_INIT_NORMAL, nullptr);
+    if (r != FMOD_OK || !system) { WriteLog("FMOD create failed r=%d", (int)r); return; }
+    ApplyOutputProfile(system, profile);
+    r = system->init(profile.maxChannels, FMOD_INIT_NORMAL, nullptr);
     WriteLog("FMOD init result r=%d", (int)r);
-    g_fmodCore = system;
+    if (r != FMOD_OK) { system->release(); return; }
 
-    // tenta carregar logo.txd (no  fatal se no existir)
-    LoadFMODLogo();
+    unsigned int length = 0;
+    int count = 0, rate = 0;
+    double latencyMs = OutputLatencyMs(system, &length, &count, &rate);
+    WriteLog("InitFMOD: output %d Hz, DSP buffer %u x %d, resampler=%d, channels=%d/%d -> output latency %.1f ms (+ up to one game frame)",
+        rate, length, count, profile.resampler, profile.softwareChannels, profile.maxChannels, latencyMs);
+    g_fmodCore.store(system, std::memory_order_release);
+
+    if (!tracePath.empty()) g_traceRecorder.Open(tracePath);
 
     // optional test
     std::string test = g_basePath + "\\test.wav";
-    FMOD::Sound* ts = LoadWav(g_fmodCore, test, false);
-    if (ts) { FMOD::Channel* ch = nullptr; g_fmodCore->playSound(ts, nullptr, false, &ch); WriteLog("Played test.wav"); }
+    FMOD::Sound* ts = LoadWav(system, test, false);
+    if (ts) { FMOD::Channel* ch = nullptr; system->playSound(ts, nullptr, false, &ch); WriteLog("Played test.wav"); }
+
+    WriteLog("InitFMOD: ready after %.1f ms", std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count());
+    g_fmodReady.store(true, std::memory_order_release);
+}
+
+static void InitFMOD() {
+    if (GetCoreSystem() || g_fmodInitThread.joinable()) return;
+    WriteLog("InitFMOD: starting...");
+
+    // config e caminhos lidos aqui (PLUGIN_PATH usa buffer esttico)
+    std::string tracePath;
+    if (GetConfig("RecordTrace", 0.0f) != 0.0f) tracePath = PLUGIN_PATH((char*)"VehicleSFX_trace.bin");
+    g_fmodInitThread = std::thread(InitFMODWorker, LoadOutputProfile(), tracePath);
+
+    // tenta carregar logo.txd (no  fatal se no existir); RenderWare fica no thread do jogo
+    LoadFMODLogo();
+}
+
+static void JoinFMODInit() {
+    if (g_fmodInitThread.joinable()) g_fmodInitThread.join();
 }
 
 
 static void ShutdownFMOD() {
-    std::lock_guard<std::mutex> lk(g_mutex);
-    if (g_fmodCore) { g_fmodCore->close(); g_fmodCore->release(); g_fmodCore = nullptr; }
-    for (auto& kv : g_modelBanks) {
-        if (!kv.second) continue;
-        for (auto& p : kv.second->sounds) if (p.second) p.second->release();
-        delete kv.second;
-    }
-    g_modelBanks.clear();
+    g_workerPool.Stop();
+    JoinFMODInit();
+    g_hotReload.Stop();
+    g_bankPrefetcher.Stop();
+    g_fmodReady.store(false, std::memory_order_release);
+    g_traceRecorder.Close();
+    g_telemetry.Close();
+    LogPrefetchStats("shutdown");
+    LogGameEngineAudio("shutdown");
+    LogOcclusionStats("shutdown");
+    LogDormancyStats("shutdown");
+    RemoveGameAudioHooks();
+    g_vehicleProcessHooks = false;
+    ShutdownMinHook();
+    ReleaseModelBanks();
+    if (FMOD::System* system = g_fmodCore.exchange(nullptr, std::memory_order_acq_rel)) { system->close(); system->release(); }
+    LogFMODMemory("shutdown");
     for (auto& kv : g_vehicleInstances) {
         if (kv.second.loopChannel) kv.second.loopChannel->stop();
         if (kv.second.pendingLoopChannel) kv.second.pendingLoopChannel->stop();
@@ -1124,10 +5206,14 @@ static void ShutdownFMOD() {
         if (kv.second.windChannel) kv.second.windChannel->stop();
     }
 
+    g_instanceTimers.Clear();
     g_vehicleInstances.clear();
 }
 
 // ---------------- plugin ----------------
+// VSFX_TOOL: o Main.cpp compilado dentro das ferramentas em tools/ (benchmarks, replay),
+// sem o objeto do plugin e portanto sem nada a correr no DllMain
+#ifndef VSFX_TOOL
 class VehicleSFXPlugin {
 public:
     VehicleSFXPlugin() {
@@ -1135,10 +5221,21 @@ public:
         LoadConfig(PLUGIN_PATH((char*)"VehicleSFX.ini"));
         
         InitParams();
+        InstallFMODMemory();
+        InstallGameAudioHooks();
+        InstallVehicleProcessHooks();
         Events::initGameEvent.after.Add([] { InitFMOD(); });
 
         // Process normal
         Events::processScriptsEvent += [] { OnProcess(); };
+        Events::drawingEvent += [] { OnDrawing(); };
+
+        // a memria da entidade pode ser reaproveitada por outro veculo
+        Events::vehicleCtorEvent += [](CVehicle* veh) { g_vehicleGrid.Update(veh, veh->GetPosition()); };
+        Events::vehicleDtorEvent += [](CVehicle* veh) { ReleaseGameEngine(veh); g_vehicleGrid.Remove(veh); };
+
+        // pra o pool antes do unload da DLL (join dentro do DllMain pode travar)
+        Events::shutdownRwEvent += [] { g_workerPool.Stop(); JoinFMODInit(); g_hotReload.Stop(); g_bankPrefetcher.Stop(); };
 
         // Quando o motor do jogo pede pra pausar todos os sons (ex.: ALT+TAB, menu etc)
         Events::onPauseAllSounds += []() {
@@ -1169,3 +5266,4 @@ public:
     }
 };
 static VehicleSFXPlugin g_vehicleSFXPlugin;
+#endif
@@ -0,0 +1,98 @@
+// Telemetria ao vivo do VehicleSFX em memria partilhada (Telemetry=1 no ini).
+// O plugin escreve, tools\TelemetryReader (ou qualquer outro processo) l.
+// Layout: cabealho + anel de VSFX_TELEMETRY_CAPACITY registos, cada um protegido por um
+// seqlock (seq mpar = a meio da escrita). O escritor nunca espera pelo leitor: um leitor
+// lento perde registos (contados em 'lost'), nunca l um registo rasgado.
+// Qualquer mudana de layout sobe VSFX_TELEMETRY_VERSION.
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+#define VSFX_TELEMETRY_NAME "Local\\VehicleSFX_Telemetry"
+static const uint32_t VSFX_TELEMETRY_MAGIC = 0x58465356u;  // "VSFX"
+static const uint32_t VSFX_TELEMETRY_VERSION = 1;
+static const uint32_t VSFX_TELEMETRY_CAPACITY = 4096;     // potncia de 2
+
+// bits de VsfxTelemetryRecord::events (iguais ao InstanceEvent do plugin)
+enum VsfxTelemetryEvent {
+    VSFX_EV_ACCEL_START = 1 << 0,
+    VSFX_EV_ACCEL_RELEASE = 1 << 1,
+    VSFX_EV_GEAR_CHANGE = 1 << 2,
+    VSFX_EV_BACKFIRE_CHECK = 1 << 3,
+    VSFX_EV_BACKFIRE_MISSING = 1 << 4,
+    VSFX_EV_INITIAL_DROP = 1 << 5,
+};
+
+// um registo por instncia por frame
+struct VsfxTelemetryRecord {
+    uint32_t index;        // n de sequncia global (o leitor confirma que no foi sobrescrito)
+    uint32_t frame;        // CTimer::m_FrameCounter
+    uint32_t timeMs;       // CTimer::m_snTimeInMilliseconds
+    uint32_t vehicle;      // ponteiro do veculo, s como identidade
+    int16_t model;
+    int8_t gear;
+    uint8_t loopMode;      // 0 nenhum, 1 idle, 2 gear
+    uint16_t events;       // VsfxTelemetryEvent
+    uint16_t overlays;     // bit por som one-shot tocado nesta frame (ordem dos slots do banco)
+    float speed;           // filtrada
+    float ratio;           // velocidade / mx. da marcha
+    float desiredPitch;
+    float currentPitch;
+    float volume;
+    float windTarget;
+    float windCurrent;
+    float occlusion;       // 0 livre .. 1 bloqueado (suavizado)
+};
+static_assert(sizeof(VsfxTelemetryRecord) == 56, "VsfxTelemetryRecord layout changed: bump VSFX_TELEMETRY_VERSION");
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "telemetry needs lock-free 32-bit atomics");
+
+struct VsfxTelemetrySlot {
+    std::atomic<uint32_t> seq;
+    uint32_t reserved;
+    VsfxTelemetryRecord rec;
+};
+
+struct VsfxTelemetryHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t recordSize;
+    uint32_t capacity;
+    uint32_t writerPid;            // muda quando o jogo reinicia: o leitor recomea do head
+    std::atomic<uint32_t> head;    // registos publicados desde a abertura (slot = head % capacity)
+    std::atomic<uint32_t> frame;   // frame do ltimo lote publicado
+    uint32_t reserved[9];
+};
+static_assert(sizeof(VsfxTelemetryHeader) == 64, "VsfxTelemetryHeader layout changed: bump VSFX_TELEMETRY_VERSION");
+
+struct VsfxTelemetryBlock {
+    VsfxTelemetryHeader header;
+    VsfxTelemetrySlot slots[VSFX_TELEMETRY_CAPACITY];
+};
+
+inline bool VsfxTelemetryValid(const VsfxTelemetryBlock* b) {
+    return b && b->header.magic == VSFX_TELEMETRY_MAGIC && b->header.version == VSFX_TELEMETRY_VERSION
+        && b->header.recordSize == sizeof(VsfxTelemetryRecord) && b->header.capacity == VSFX_TELEMETRY_CAPACITY;
+}
+
+// copia para 'out' os registos publicados a partir de 'next' (avana 'next'); devolve
+// quantos. 'lost' soma os que o escritor j tinha sobrescrito ou apanhou a meio.
+inline uint32_t VsfxTelemetryRead(const VsfxTelemetryBlock* b, uint32_t& next, VsfxTelemetryRecord* out, uint32_t maxOut, uint64_t& lost) {
+    uint32_t head = b->header.head.load(std::memory_order_acquire);
+    if (head - next > VSFX_TELEMETRY_CAPACITY) {
+        lost += head - next - VSFX_TELEMETRY_CAPACITY;
+        next = head - VSFX_TELEMETRY_CAPACITY;
+    }
+    uint32_t n = 0;
+    while (next != head && n < maxOut) {
+        const VsfxTelemetrySlot& s = b->slots[next & (VSFX_TELEMETRY_CAPACITY - 1)];
+        uint32_t s1 = s.seq.load(std::memory_order_acquire);
+        std::memcpy(&out[n], (const void*)&s.rec, sizeof(VsfxTelemetryRecord));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t s2 = s.seq.load(std::memory_order_relaxed);
+        if ((s1 & 1u) == 0 && s1 == s2 && out[n].index == next) ++n;
+        else ++lost;
+        ++next;
+    }
+    return n;
+}
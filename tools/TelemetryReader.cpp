@@ -0,0 +1,150 @@
+// Leitor da telemetria ao vivo do VehicleSFX (Telemetry=1 no VehicleSFX.ini).
+// Corre noutro processo ao lado do jogo e segue o anel em memria partilhada.
+//
+//   TelemetryReader                      CSV no stdout
+//   TelemetryReader --csv tuning.csv     CSV para arquivo (contagem no console)
+//   TelemetryReader --plot               barras por veculo, refrescadas ~10x/s
+//   TelemetryReader --model 411 ...      s um modelo
+//
+// Build (Developer Command Prompt, x86 ou x64):
+//   cl /O2 /EHsc /std:c++17 /I..\source TelemetryReader.cpp
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include "VehicleSFXTelemetry.h"
+
+static volatile bool g_quit = false;
+
+static BOOL WINAPI OnCtrl(DWORD) {
+    g_quit = true;
+    return TRUE;
+}
+
+static void WriteCsvHeader(FILE* f) {
+    fprintf(f, "index,frame,timeMs,vehicle,model,gear,loopMode,events,overlays,speed,ratio,desiredPitch,currentPitch,volume,windTarget,windCurrent,occlusion\n");
+}
+
+static void WriteCsvRow(FILE* f, const VsfxTelemetryRecord& r) {
+    fprintf(f, "%u,%u,%u,%08x,%d,%d,%u,%u,%u,%.3f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.3f\n",
+        r.index, r.frame, r.timeMs, r.vehicle, (int)r.model, (int)r.gear, (unsigned)r.loopMode, (unsigned)r.events, (unsigned)r.overlays,
+        r.speed, r.ratio, r.desiredPitch, r.currentPitch, r.volume, r.windTarget, r.windCurrent, r.occlusion);
+}
+
+static std::string Bar(float v, float full, int width) {
+    int n = (int)(v / full * width + 0.5f);
+    if (n < 0) n = 0;
+    if (n > width) n = width;
+    return std::string(n, '#') + std::string(width - n, '.');
+}
+
+// um ecr por veculo visto no ltimo segundo: pitch (atual vs alvo), volume, vento, ocluso
+static void DrawPlot(const std::map<uint32_t, VsfxTelemetryRecord>& last, uint32_t nowMs, uint64_t lost) {
+    printf("\x1b[H\x1b[2J");
+    printf("VehicleSFX telemetry  vehicles=%zu lost=%llu   (Ctrl+C to quit)\n\n", last.size(), (unsigned long long)lost);
+    for (const auto& kv : last) {
+        const VsfxTelemetryRecord& r = kv.second;
+        if (nowMs - r.timeMs > 1000) continue;
+        printf("%08x model=%-4d gear=%d loop=%s speed=%6.2f ratio=%.2f%s\n", r.vehicle, (int)r.model, (int)r.gear,
+            r.loopMode == 2 ? "gear" : r.loopMode == 1 ? "idle" : "none", r.speed, r.ratio,
+            (r.events & VSFX_EV_GEAR_CHANGE) ? "  [gear change]" : "");
+        printf("  pitch  %s %.3f (want %.3f)\n", Bar(r.currentPitch, 2.0f, 40).c_str(), r.currentPitch, r.desiredPitch);
+        printf("  volume %s %.3f\n", Bar(r.volume, 1.0f, 40).c_str(), r.volume);
+        printf("  wind   %s %.3f (want %.3f)\n", Bar(r.windCurrent, 1.0f, 40).c_str(), r.windCurrent, r.windTarget);
+        printf("  occl   %s %.2f\n\n", Bar(r.occlusion, 1.0f, 40).c_str(), r.occlusion);
+    }
+    fflush(stdout);
+}
+
+int main(int argc, char** argv) {
+    const char* csvPath = nullptr;
+    bool plot = false;
+    int model = -1;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--csv") && i + 1 < argc) csvPath = argv[++i];
+        else if (!strcmp(argv[i], "--plot")) plot = true;
+        else if (!strcmp(argv[i], "--model") && i + 1 < argc) model = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: %s [--csv file] [--plot] [--model id]\n", argv[0]);
+            return 1;
+        }
+    }
+    SetConsoleCtrlHandler(OnCtrl, TRUE);
+    if (plot) {
+        HANDLE out = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD mode = 0;
+        if (GetConsoleMode(out, &mode)) SetConsoleMode(out, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+
+    FILE* csv = nullptr;
+    if (csvPath) {
+        csv = fopen(csvPath, "w");
+        if (!csv) { fprintf(stderr, "cannot open %s\n", csvPath); return 1; }
+    }
+    else if (!plot) csv = stdout;
+    if (csv) WriteCsvHeader(csv);
+
+    static VsfxTelemetryRecord buf[1024];
+    std::map<uint32_t, VsfxTelemetryRecord> last;
+    HANDLE mapping = nullptr;
+    const VsfxTelemetryBlock* block = nullptr;
+    uint32_t next = 0, pid = 0;
+    uint64_t lost = 0, rows = 0;
+    DWORD lastDraw = 0;
+
+    while (!g_quit) {
+        if (!block) {
+            mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, VSFX_TELEMETRY_NAME);
+            if (mapping) block = static_cast<const VsfxTelemetryBlock*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, sizeof(VsfxTelemetryBlock)));
+            if (!VsfxTelemetryValid(block)) {
+                if (block) UnmapViewOfFile(block);
+                if (mapping) CloseHandle(mapping);
+                block = nullptr;
+                mapping = nullptr;
+                fprintf(stderr, "\rwaiting for VehicleSFX (Telemetry=1)...");
+                Sleep(500);
+                continue;
+            }
+            fprintf(stderr, "\rconnected to VehicleSFX pid=%lu        \n", (unsigned long)block->header.writerPid);
+            pid = block->header.writerPid;
+            next = block->header.head.load(std::memory_order_acquire);  // s o que vier a partir de agora
+        }
+        // o jogo reabriu o anel (ou fechou): recomea do head atual
+        if (block->header.writerPid != pid || block->header.magic != VSFX_TELEMETRY_MAGIC) {
+            UnmapViewOfFile(block);
+            CloseHandle(mapping);
+            block = nullptr;
+            mapping = nullptr;
+            continue;
+        }
+
+        uint32_t n = VsfxTelemetryRead(block, next, buf, 1024, lost);
+        for (uint32_t i = 0; i < n; ++i) {
+            const VsfxTelemetryRecord& r = buf[i];
+            if (model >= 0 && r.model != model) continue;
+            if (csv) WriteCsvRow(csv, r);
+            last[r.vehicle] = r;
+            ++rows;
+        }
+        DWORD now = GetTickCount();
+        if (now - lastDraw >= 100) {
+            lastDraw = now;
+            if (plot && !last.empty()) {
+                uint32_t newest = 0;
+                for (const auto& kv : last) if (kv.second.timeMs > newest) newest = kv.second.timeMs;
+                DrawPlot(last, newest, lost);
+            }
+            else if (csv && csv != stdout) fprintf(stderr, "\rrows=%llu lost=%llu", (unsigned long long)rows, (unsigned long long)lost);
+        }
+        if (n < 1024) Sleep(5);  // ~200 leituras/s chegam com folga para o anel de 4096
+    }
+
+    if (csv && csv != stdout) fclose(csv);
+    if (block) UnmapViewOfFile(block);
+    if (mapping) CloseHandle(mapping);
+    fprintf(stderr, "\nrows=%llu lost=%llu\n", (unsigned long long)rows, (unsigned long long)lost);
+    return 0;
+}
@@ -0,0 +1,207 @@
+// Reproduz um trace do VehicleSFX (RecordTrace=1 no VehicleSFX.ini) fora do jogo,
+// para golden audio e medio de CPU. Compila o Main.cpp do plugin com VSFX_TOOL
+// e cria ele prprio o System FMOD no-realtime; os bancos vm de vsfx\ ao lado
+// do exe, como no plugin.
+//
+//   TraceReplay drive.vsft                        s medio (NOSOUND_NRT, sem sada)
+//   TraceReplay drive.vsft --wav golden.wav       grava o udio (WAVWRITER_NRT)
+//   TraceReplay drive.vsft --ini ..\VehicleSFX.ini ...
+//
+// Build (Developer Command Prompt x86, mesmos SDK/FMOD/MinHook do plugin):
+//   cl /O2 /EHsc /MT /std:c++latest /DVSFX_TOOL /DGTASA /DPLUGIN_SGV_10US /DRW /I..\source
+//      /I%PLUGIN_SDK_DIR%\plugin_sa /I%PLUGIN_SDK_DIR%\plugin_sa\game_sa /I%PLUGIN_SDK_DIR%\plugin_sa\game_sa\rw
+//      /I%PLUGIN_SDK_DIR%\shared /I%PLUGIN_SDK_DIR%\shared\game /I<fmod>\api\core\inc /I<minhook>\include
+//      TraceReplay.cpp /link /LIBPATH:%PLUGIN_SDK_DIR%\output\lib plugin.lib fmod_vc.lib MinHook.x86.lib
+#ifndef VSFX_TOOL
+#define VSFX_TOOL
+#endif
+#include "Main.cpp"
+
+// As entradas gravadas passam pelas mesmas fases Compute/Submit do plugin, sobre o
+// System NRT recebido (tem de ser o publicado como core: o Submit usa GetCoreSystem()).
+// O mixer avana um bloco DSP por update(), ento chamamos update() at o tempo
+// renderizado alcanar o tempo simulado -- corre to rpido quanto o CPU deixar.
+static bool ReplayTrace(FMOD::System* system, const std::string& tracePath, const char* outputName) {
+    std::ifstream f(tracePath, std::ios::binary);
+    char magic[4] = {};
+    unsigned int version = 0;
+    f.read(magic, 4);
+    f.read((char*)&version, sizeof(version));
+    if (!f || std::memcmp(magic, TRACE_MAGIC, 4) != 0 || version != TRACE_VERSION) {
+        WriteLog("ReplayTrace: %s is not a trace (version %u)", tracePath.c_str(), version);
+        return false;
+    }
+    if (!system || GetCoreSystem() != system) { WriteLog("ReplayTrace: system is not the core system, skipped"); return false; }
+
+    unsigned int blockLength = 1024;
+    int sampleRate = 48000;
+    OutputLatencyMs(system, &blockLength, nullptr, &sampleRate);
+    double blockSec = (sampleRate > 0) ? double(blockLength) / double(sampleRate) : 1024.0 / 48000.0;
+
+    std::map<int, TraceModelRecord> models;
+    std::map<unsigned int, VehicleAudioInstance> instances;
+    std::vector<VehicleAudioInstance*> list;
+    std::vector<TraceInstance> records;
+    unsigned long long digest = 1469598103934665603ull;
+    auto mix = [&digest](const void* p, size_t n) {
+        const unsigned char* c = (const unsigned char*)p;
+        for (size_t i = 0; i < n; ++i) { digest ^= c[i]; digest *= 1099511628211ull; }
+    };
+
+    unsigned int frames = 0, firstMs = 0, lastMs = 0;
+    double simSec = 0.0, renderedSec = 0.0;
+    auto t0 = std::chrono::steady_clock::now();
+    int tag;
+    while ((tag = f.get()) != EOF) {
+        if (tag == TRACE_MODEL) {
+            TraceModelRecord m;
+            if (!f.read((char*)&m, sizeof(m))) break;
+            m.gearCount = std::clamp(m.gearCount, 1, MAX_TRANSMISSION_GEARS);
+            models[m.modelIndex] = m;
+            continue;
+        }
+        if (tag != TRACE_FRAME) { WriteLog("ReplayTrace: bad record tag %d after %u frames", tag, frames); break; }
+
+        TraceFrameHeader h;
+        if (!f.read((char*)&h, sizeof(h))) break;
+        records.resize(h.count);
+        if (h.count && !f.read((char*)records.data(), sizeof(TraceInstance) * h.count)) break;
+        if (frames == 0) firstMs = h.nowMs;
+        lastMs = h.nowMs;
+
+        FMOD_VECTOR zero = { 0.0f, 0.0f, 0.0f };
+        try { system->set3DListenerAttributes(0, &h.listenerPos, &zero, &h.listenerAt, &h.listenerUp); }
+        catch (...) {}
+
+        // instncias que sumiram do trace param como no OnProcess
+        for (auto it = instances.begin(); it != instances.end();) {
+            bool present = false;
+            for (const TraceInstance& t : records) if (t.vehKey == it->first) { present = true; break; }
+            if (present) { ++it; continue; }
+            StopInstanceChannels(it->second);
+            CancelInstanceTimers(g_instanceTimers, it->second);
+            it = instances.erase(it);
+        }
+
+        list.clear();
+        g_frameInputs.resize(h.count);
+        for (int i = 0; i < h.count; ++i) {
+            const TraceInstance& t = records[i];
+            VehicleAudioInstance& inst = instances[t.vehKey];
+            if (!inst.bank && (t.flags & TF_ACTIVE)) {
+                inst.currentVolume = 0.45f;
+                inst.bank = LoadBankForModel(t.modelIndex);
+            }
+            // o perfil vem do trace (no h handling sem o jogo)
+            auto mIt = models.find(t.modelIndex);
+            if (inst.bank && mIt != models.end()) {
+                TransmissionProfile& prof = inst.bank->transmission;
+                if (!prof.valid || prof.gearCount != mIt->second.gearCount
+                    || !std::equal(prof.gearMaxVelocity, prof.gearMaxVelocity + MAX_TRANSMISSION_GEARS + 1, mIt->second.gearMaxVelocity)) {
+                    prof = TransmissionProfile();
+                    prof.gearCount = mIt->second.gearCount;
+                    std::copy(mIt->second.gearMaxVelocity, mIt->second.gearMaxVelocity + MAX_TRANSMISSION_GEARS + 1, prof.gearMaxVelocity);
+                    ComputeGearConstants(prof);
+                    BakeResponseTables(prof);
+                    prof.valid = true;
+                }
+            }
+
+            InstanceInputs& in = g_frameInputs[i];
+            in = InstanceInputs();
+            in.stopAll = (t.flags & TF_STOP_ALL) != 0;
+            in.active = (t.flags & TF_ACTIVE) && inst.bank && inst.bank->transmission.valid;
+            in.vehKey = t.vehKey;
+            in.modelIndex = t.modelIndex;
+            in.emitter.modelIndex = t.modelIndex;
+            in.emitter.pos = t.pos;
+            in.emitter.vel = t.vel;
+            in.padPressed = (t.flags & TF_PAD) != 0;
+            in.gasPressed = (t.flags & TF_GAS) != 0;
+            in.gear = t.gear;
+            in.speed = t.speed;
+            in.gearMax = t.gearMax;
+            in.wheelSpin = t.wheelSpin;
+            in.timeStep = h.timeStep;
+            in.nowMs = h.nowMs;
+            in.paused = h.paused != 0;
+            list.push_back(&inst);
+        }
+        ComputeAndSubmit(list, h.nowMs);
+
+        for (int i = 0; i < h.count; ++i) {
+            const InstanceCommands& cmd = g_frameCommands[i];
+            mix(&cmd.overlays, sizeof(cmd.overlays));
+            mix(&cmd.events, sizeof(cmd.events));
+            if (cmd.hasLane) mix(&g_smoothBatch.displayPitch[i], sizeof(float));
+        }
+
+        simSec += std::max(0.0f, h.timeStep) / GAME_TIMESTEP_HZ;
+        while (renderedSec < simSec) {
+            try { system->update(); }
+            catch (...) {}
+            renderedSec += blockSec;
+        }
+        ++frames;
+    }
+    double cpuSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    for (auto& kv : instances) {
+        StopInstanceChannels(kv.second);
+        CancelInstanceTimers(g_instanceTimers, kv.second);
+    }
+    instances.clear();
+    try { system->update(); }
+    catch (...) {}
+
+    WriteLog("ReplayTrace: %s -> %s frames=%u game=%.2fs sim=%.2fs rendered=%.2fs",
+        tracePath.c_str(), outputName, frames, (lastMs - firstMs) / 1000.0, simSec, renderedSec);
+    WriteLog("ReplayTrace: cpu=%.3fs %.2f ms cpu per simulated second (%.1fx realtime) digest=%016llx",
+        cpuSec, (simSec > 0.0) ? cpuSec * 1000.0 / simSec : 0.0, (cpuSec > 0.0) ? simSec / cpuSec : 0.0, digest);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    std::string iniPath = "VehicleSFX.ini";
+    std::string tracePath, wavPath;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--ini") && i + 1 < argc) iniPath = argv[++i];
+        else if (!strcmp(argv[i], "--wav") && i + 1 < argc) wavPath = argv[++i];
+        else if (tracePath.empty()) tracePath = argv[i];
+        else { std::fprintf(stderr, "argumento inesperado: %s\n", argv[i]); return 1; }
+    }
+    if (tracePath.empty()) {
+        std::fprintf(stderr, "uso: TraceReplay <trace> [--wav out.wav] [--ini VehicleSFX.ini]\n");
+        return 1;
+    }
+
+    InitLog();
+    LoadConfig(iniPath);
+    InitParams();
+    InstallFMODMemory();
+
+    FMOD::System* system = nullptr;
+    if (FMOD::System_Create(&system) != FMOD_OK || !system) { WriteLog("ReplayTrace: System_Create failed"); return 1; }
+    FMOD_RESULT r = FMOD_OK;
+    OutputProfile profile = LoadOutputProfile();
+    try {
+        system->setOutput(wavPath.empty() ? FMOD_OUTPUTTYPE_NOSOUND_NRT : FMOD_OUTPUTTYPE_WAVWRITER_NRT);
+        ApplyOutputProfile(system, profile);
+        r = system->init(profile.maxChannels, FMOD_INIT_STREAM_FROM_UPDATE | FMOD_INIT_MIX_FROM_UPDATE, wavPath.empty() ? nullptr : (void*)wavPath.c_str());
+    }
+    catch (...) { r = FMOD_ERR_INTERNAL; }
+    if (r != FMOD_OK) {
+        WriteLog("ReplayTrace: NRT init failed r=%d", (int)r);
+        system->release();
+        return 1;
+    }
+
+    // nico System do processo: o Submit e os bancos vo busc-lo ao core
+    g_fmodCore.store(system, std::memory_order_release);
+    bool ok = ReplayTrace(system, tracePath, wavPath.empty() ? "(no output)" : wavPath.c_str());
+    ReleaseModelBanks();
+    try { system->close(); system->release(); }
+    catch (...) {}
+    g_fmodCore.store(nullptr, std::memory_order_release);
+    return ok ? 0 : 1;
+}
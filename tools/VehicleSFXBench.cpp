@@ -0,0 +1,1582 @@
+// Benchmarks do VehicleSFX, fora do jogo. Compila o Main.cpp do plugin com VSFX_TOOL
+// (sem o objeto do plugin, sem hooks) e s exercita o clculo, o FMOD e os registos
+// com veculos sintticos: nada aqui l memria do jogo. Resultados no console e em
+// VehicleSFX_log.txt na pasta atual.
+//
+//   VehicleSFXBench                              todos, com .\VehicleSFX.ini se existir
+//   VehicleSFXBench --ini ..\VehicleSFX.ini      outro ini (mesmos parmetros do plugin)
+//   VehicleSFXBench registry grid ...            s os nomeados (--list mostra os nomes)
+//   VehicleSFXBench --trace drive.vsft fps       check de FPS sobre um trace gravado (RecordTrace=1)
+//
+// Build (Developer Command Prompt x86, mesmos SDK/FMOD/MinHook do plugin):
+//   cl /O2 /EHsc /MT /std:c++latest /DVSFX_TOOL /DGTASA /DPLUGIN_SGV_10US /DRW /I..\source
+//      /I%PLUGIN_SDK_DIR%\plugin_sa /I%PLUGIN_SDK_DIR%\plugin_sa\game_sa /I%PLUGIN_SDK_DIR%\plugin_sa\game_sa\rw
+//      /I%PLUGIN_SDK_DIR%\shared /I%PLUGIN_SDK_DIR%\shared\game /I<fmod>\api\core\inc /I<minhook>\include
+//      VehicleSFXBench.cpp /link /LIBPATH:%PLUGIN_SDK_DIR%\output\lib plugin.lib fmod_vc.lib MinHook.x86.lib
+#ifndef VSFX_TOOL
+#define VSFX_TOOL
+#endif
+#include "Main.cpp"
+
+// ---------------- benchmarks ----------------
+static double ElapsedUs(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+}
+
+static void BenchResponseTables() {
+    TransmissionProfile prof;
+    prof.gearCount = MAX_TRANSMISSION_GEARS;
+    ComputeGearConstants(prof);
+    BakeResponseTables(prof);
+
+    const int instances = 512;
+    const int frames = 2000;
+    volatile float sink = 0.0f;
+
+    // erro de interpolao da tabela contra a frmula
+    float maxErr = 0.0f;
+    for (int g = 1; g <= MAX_TRANSMISSION_GEARS; ++g) {
+        for (int i = 0; i <= 1000; ++i) {
+            float ratio = float(i) / 1000.0f;
+            float a, d, v;
+            FormulaResponse(prof, g, ratio, a, d, v);
+            maxErr = std::max(maxErr, std::fabs(a - SampleResponse(prof.response[g].pitch[RM_ACCEL], ratio)));
+            maxErr = std::max(maxErr, std::fabs(d - SampleResponse(prof.response[g].pitch[RM_DECEL], ratio)));
+        }
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        float acc = 0.0f;
+        for (int n = 0; n < instances; ++n) {
+            int g = 1 + (n % MAX_TRANSMISSION_GEARS);
+            float ratio = float((n * 37 + f) % 1000) / 1000.0f;
+            float a, d, v;
+            FormulaResponse(prof, g, ratio, a, d, v);
+            acc += ((n & 1) ? a : d) + v;
+        }
+        sink = sink + acc;
+    }
+    double formulaUs = ElapsedUs(t0);
+
+    t0 = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; ++f) {
+        float acc = 0.0f;
+        for (int n = 0; n < instances; ++n) {
+            int g = 1 + (n % MAX_TRANSMISSION_GEARS);
+            float ratio = float((n * 37 + f) % 1000) / 1000.0f;
+            ResponseMode mode = (n & 1) ? RM_ACCEL : RM_DECEL;
+            acc += SampleResponse(prof.response[g].pitch[mode], ratio) + SampleResponse(prof.response[g].volume[mode], ratio);
+        }
+        sink = sink + acc;
+    }
+    double lutUs = ElapsedUs(t0);
+
+    double evals = double(instances) * frames;
+    WriteLog("Bench response: %d instances x %d frames formula=%.2f ns/eval table=%.2f ns/eval maxErr=%.5f",
+        instances, frames, formulaUs * 1000.0 / evals, lutUs * 1000.0 / evals, maxErr);
+}
+
+// preenche um batch com valores sintticos determinsticos
+static void FillSyntheticBatch(SmoothingBatch& b, int count) {
+    b.Resize(count);
+    b.minPitch = 0.5f;
+    b.maxPitch = 2.08f;
+    unsigned int rng = 12345u;
+    auto next = [&rng]() { rng = rng * 1664525u + 1013904223u; return float(rng >> 8) / float(1 << 24); };
+    for (int i = 0; i < count; ++i) {
+        int n = i;
+        b.currentPitch[i] = 0.5f + next();
+        b.desiredPitch[i] = 0.5f + next() * 1.5f;
+        b.pitchAlpha[i] = next() * 0.3f;
+        b.shiftDrop[i] = (n % 3 == 0) ? -0.1f * next() : 0.0f;
+        b.shiftT[i] = next();
+        b.currentVolume[i] = next();
+        b.desiredVolume[i] = 0.45f + next() * 0.55f;
+        b.volumeAlpha[i] = next() * 0.2f;
+        b.currentWind[i] = next() * 0.75f;
+        b.desiredWind[i] = next() * 0.75f;
+        b.windMaxDelta[i] = (n % 4 == 0) ? 0.0f : 0.004f;
+    }
+}
+
+static void BenchSmoothingKernels() {
+    struct { const char* name; SmoothKernelFn fn; bool available; } kernels[] = {
+        { "scalar", SmoothKernelScalar, true },
+        { "SSE2", SmoothKernelSSE2, false },
+        { "AVX2", SmoothKernelAVX2, false },
+    };
+    const char* best = "";
+    SmoothKernelFn bestFn = SelectSmoothKernel(&best);
+    kernels[1].available = (bestFn == SmoothKernelSSE2 || bestFn == SmoothKernelAVX2);
+    kernels[2].available = (bestFn == SmoothKernelAVX2);
+
+    const int sizes[] = { 8, 64, 512 };
+    const int frames = 20000;
+    for (int count : sizes) {
+        SmoothingBatch reference;
+        FillSyntheticBatch(reference, count);
+        for (int f = 0; f < 64; ++f) SmoothKernelScalar(reference, 0, count);
+
+        for (auto& k : kernels) {
+            if (!k.available) continue;
+
+            // confere o resultado contra o escalar aps 64 frames
+            SmoothingBatch b;
+            FillSyntheticBatch(b, count);
+            for (int f = 0; f < 64; ++f) k.fn(b, 0, count);
+            float maxErr = 0.0f;
+            for (int i = 0; i < count; ++i) {
+                maxErr = std::max(maxErr, std::fabs(b.displayPitch[i] - reference.displayPitch[i]));
+                maxErr = std::max(maxErr, std::fabs(b.currentVolume[i] - reference.currentVolume[i]));
+                maxErr = std::max(maxErr, std::fabs(b.currentWind[i] - reference.currentWind[i]));
+            }
+
+            FillSyntheticBatch(b, count);
+            auto t0 = std::chrono::steady_clock::now();
+            for (int f = 0; f < frames; ++f) k.fn(b, 0, count);
+            double us = ElapsedUs(t0);
+
+            WriteLog("Bench smoothing: %s n=%d %.3f us/frame %.2f ns/instance maxErr=%g%s",
+                k.name, count, us / frames, us * 1000.0 / (double(frames) * count), maxErr,
+                (maxErr > 1e-5f) ? " (OUT OF TOLERANCE)" : "");
+        }
+    }
+}
+
+// 256 veculos simulados, clculo por instncia com 1..8 threads; o digest
+// do estado/comandos tem de ser igual em todas as contagens de threads
+// banco com todos os sons e perfil de transmisso padro (sem handling do jogo)
+static void MakeSyntheticBank(WavBank& bank) {
+    bank.soundMask = (1u << SND_COUNT) - 1;
+    bank.transmission.gearCount = MAX_TRANSMISSION_GEARS;
+    ComputeGearConstants(bank.transmission);
+    BakeResponseTables(bank.transmission);
+    bank.transmission.valid = true;
+}
+
+static void BenchParallelUpdate() {
+    const int vehicles = 256;
+    const int frames = 2000;
+    WriteLog("Bench parallel: hardware threads=%u", std::thread::hardware_concurrency());
+    EnsureOverlayRules();
+
+    WavBank bank;
+    MakeSyntheticBank(bank);
+
+    // nunca desreferenciado: o bench no submete ao FMOD, s marca o loop como "a tocar"
+    static int channelTag = 0;
+    FMOD::Channel* fakeChannel = reinterpret_cast<FMOD::Channel*>(&channelTag);
+
+    std::vector<VehicleAudioInstance> instances(vehicles);
+    std::vector<VehicleAudioInstance*> list(vehicles);
+    std::vector<InstanceInputs> inputs(vehicles);
+    std::vector<InstanceCommands> cmds(vehicles);
+    SmoothingBatch batch;
+    batch.Resize(vehicles);
+
+    double baseMs = 0.0;
+    unsigned long long baseDigest = 0;
+    for (int threads = 1; threads <= 8; ++threads) {
+        WorkStealingPool pool;
+        pool.Start(threads - 1);
+        TimerWheel timers;
+        for (int v = 0; v < vehicles; ++v) {
+            instances[v] = VehicleAudioInstance();
+            instances[v].bank = &bank;
+            instances[v].currentVolume = 0.45f;
+            list[v] = &instances[v];
+        }
+
+        unsigned long long digest = 1469598103934665603ull;
+        auto mix = [&digest](const void* p, size_t n) {
+            const unsigned char* c = (const unsigned char*)p;
+            for (size_t i = 0; i < n; ++i) { digest ^= c[i]; digest *= 1099511628211ull; }
+        };
+
+        double computeUs = 0.0;
+        for (int f = 0; f < frames; ++f) {
+            for (int v = 0; v < vehicles; ++v) {
+                InstanceInputs& in = inputs[v];
+                in = InstanceInputs();
+                in.active = true;
+                in.vehKey = 0x10000 + (uintptr_t)v * 0x40;
+                in.modelIndex = 400 + v % 200;
+                in.gasPressed = ((f / 30 + v) % 3) != 0;
+                in.gear = 1 + ((f / 60 + v) % MAX_TRANSMISSION_GEARS);
+                in.speed = std::fmod(f * 0.7f + v * 3.0f, 60.0f);
+                in.wheelSpin = ((f + v) % 97 == 0) ? 0.8f : 0.0f;
+                in.timeStep = 1.0f;
+                in.nowMs = 1000u + (unsigned int)f * 20u;
+            }
+
+            auto t0 = std::chrono::steady_clock::now();
+            timers.Advance(inputs[0].nowMs);
+            ComputeInstances(pool, list, inputs, cmds, batch, 1);
+            SmoothKernelScalar(batch, 0, vehicles);
+            computeUs += ElapsedUs(t0);
+
+            // "submisso" mnima: grava o resultado de volta como o SubmitInstance faria
+            for (int v = 0; v < vehicles; ++v) {
+                VehicleAudioInstance& inst = instances[v];
+                ArmInstanceTimers(timers, inst, cmds[v], inputs[v].nowMs);
+                if (cmds[v].startLoop) { inst.loopMode = cmds[v].loopMode; inst.loopChannel = fakeChannel; }
+                if (cmds[v].startWind) { inst.windChannel = fakeChannel; StartWindFade(timers, inst, inputs[v].nowMs); }
+                if (cmds[v].hasLane) {
+                    inst.currentPitch = batch.currentPitch[v];
+                    inst.currentVolume = batch.currentVolume[v];
+                    inst.currentWindVolume = batch.currentWind[v];
+                    mix(&batch.displayPitch[v], sizeof(float));
+                }
+                mix(&cmds[v].overlays, sizeof(cmds[v].overlays));
+                mix(&cmds[v].events, sizeof(cmds[v].events));
+            }
+        }
+        pool.Stop();
+
+        double msPerFrame = computeUs / 1000.0 / frames;
+        if (threads == 1) { baseMs = msPerFrame; baseDigest = digest; }
+        WriteLog("Bench parallel: threads=%d vehicles=%d %.4f ms/frame speedup=%.2fx deterministic=%s",
+            threads, vehicles, msPerFrame, (msPerFrame > 0.0) ? baseMs / msPerFrame : 0.0,
+            (digest == baseDigest) ? "yes" : "NO");
+    }
+}
+
+// Percurso sinttico (funo contnua do tempo): arranque com wheelspin, subida
+// de marchas, travagem forte e largada do acelerador. S usado sem --trace.
+static void ScriptedDriveAt(float t, InstanceInputs& in) {
+    in.gasPressed = (t < 4.5f) || (t >= 6.5f);
+    in.wheelSpin = (t >= 0.2f && t < 0.9f) ? 0.8f : 0.0f;
+    if (t < 4.5f) in.speed = 12.0f * t;                              // acelera at 54
+    else if (t < 4.8f) in.speed = 54.0f - (t - 4.5f) * 130.0f;       // travagem: -130/s
+    else if (t < 6.5f) in.speed = std::max(0.0f, 15.0f - (t - 4.8f) * 4.0f);
+    else in.speed = 8.2f + (t - 6.5f) * 10.0f;
+    in.gear = (in.speed < 15.0f) ? 1 : (in.speed < 30.0f) ? 2 : 3;
+}
+
+// Entradas de um veculo ao longo do tempo, reamostrveis a qualquer FPS:
+// a velocidade  interpolada entre amostras, o resto (marcha, pedais, wheelspin)
+// fica no valor da ltima amostra, como o jogo o veria entre dois frames.
+struct DriveSample {
+    float t;
+    float speed;
+    float wheelSpin;
+    int gear;
+    bool gasPressed;
+    bool padPressed;
+};
+
+struct DriveTimeline {
+    std::vector<DriveSample> samples;
+    bool hasModel = false;
+    TraceModelRecord model = {};
+    std::string source;
+
+    float Duration() const { return samples.empty() ? 0.0f : samples.back().t; }
+
+    void At(float t, InstanceInputs& in) const {
+        auto it = std::upper_bound(samples.begin(), samples.end(), t, [](float x, const DriveSample& s) { return x < s.t; });
+        const DriveSample& a = (it == samples.begin()) ? *it : *(it - 1);
+        float speed = a.speed;
+        if (it != samples.begin() && it != samples.end() && it->t > a.t)
+            speed += (it->speed - a.speed) * (t - a.t) / (it->t - a.t);
+        in.speed = speed;
+        in.gear = a.gear;
+        in.gasPressed = a.gasPressed;
+        in.padPressed = a.padPressed;
+        in.wheelSpin = a.wheelSpin;
+    }
+};
+
+static void ScriptedTimeline(DriveTimeline& tl) {
+    tl = DriveTimeline();
+    tl.source = "scripted drive";
+    for (int ms = 0; ms <= 8000; ++ms) {
+        InstanceInputs in;
+        ScriptedDriveAt(ms / 1000.0f, in);
+        tl.samples.push_back({ ms / 1000.0f, in.speed, in.wheelSpin, in.gear, in.gasPressed, in.padPressed });
+    }
+}
+
+// L um trace do RecordTrace=1 e fica com o primeiro veculo ativo (normalmente o
+// do jogador); frames em pausa no contam tempo.
+static bool LoadDriveTimeline(const std::string& tracePath, DriveTimeline& tl) {
+    tl = DriveTimeline();
+    tl.source = tracePath;
+    std::ifstream f(tracePath, std::ios::binary);
+    char magic[4] = {};
+    unsigned int version = 0;
+    f.read(magic, 4);
+    f.read((char*)&version, sizeof(version));
+    if (!f || std::memcmp(magic, TRACE_MAGIC, 4) != 0 || version != TRACE_VERSION) {
+        WriteLog("Check fps: %s is not a trace (version %u)", tracePath.c_str(), version);
+        return false;
+    }
+
+    std::map<int, TraceModelRecord> models;
+    std::vector<TraceInstance> records;
+    bool picked = false;
+    unsigned int vehKey = 0;
+    int modelIndex = -1;
+    unsigned int lastMs = 0;
+    float t = 0.0f;
+    int tag;
+    while ((tag = f.get()) != EOF) {
+        if (tag == TRACE_MODEL) {
+            TraceModelRecord m;
+            if (!f.read((char*)&m, sizeof(m))) break;
+            m.gearCount = std::clamp(m.gearCount, 1, MAX_TRANSMISSION_GEARS);
+            models[m.modelIndex] = m;
+            continue;
+        }
+        if (tag != TRACE_FRAME) { WriteLog("Check fps: bad record tag %d in %s", tag, tracePath.c_str()); break; }
+        TraceFrameHeader h;
+        if (!f.read((char*)&h, sizeof(h))) break;
+        records.resize(h.count);
+        if (h.count && !f.read((char*)records.data(), sizeof(TraceInstance) * h.count)) break;
+        if (h.paused) { lastMs = h.nowMs; continue; }
+
+        const TraceInstance* rec = nullptr;
+        for (const TraceInstance& r : records) {
+            if (!(r.flags & TF_ACTIVE)) continue;
+            if (!picked || r.vehKey == vehKey) { rec = &r; break; }
+        }
+        if (!rec) {
+            if (picked) break;  // o veculo saiu do trace: fim do percurso
+            continue;
+        }
+        if (picked) t += (h.nowMs - lastMs) / 1000.0f;
+        picked = true;
+        vehKey = rec->vehKey;
+        modelIndex = rec->modelIndex;
+        lastMs = h.nowMs;
+        if (!tl.samples.empty() && t <= tl.samples.back().t) tl.samples.pop_back();
+        tl.samples.push_back({ t, rec->speed, rec->wheelSpin, rec->gear, (rec->flags & TF_GAS) != 0, (rec->flags & TF_PAD) != 0 });
+    }
+
+    auto mIt = models.find(modelIndex);
+    if (mIt != models.end()) { tl.hasModel = true; tl.model = mIt->second; }
+    if (tl.samples.size() < 2) {
+        WriteLog("Check fps: %s has no active vehicle", tracePath.c_str());
+        return false;
+    }
+    WriteLog("Check fps: %s vehicle %08x model=%d %zu samples over %.2fs", tracePath.c_str(), vehKey, modelIndex, tl.samples.size(), tl.Duration());
+    return true;
+}
+
+struct DriveReplayResult {
+    float firstHeavyDropSec = -1.0f;
+    bool legacyHeavyDrop = false;   // critrio antigo: delta por frame < -3
+    int accelStarts = 0;
+    int accelReleases = 0;
+    float wheelspinSec = 0.0f;
+    std::vector<float> pitchAt;     // displayPitch em cada checkpoint
+    std::vector<float> speedAt;     // filteredSpeed em cada checkpoint
+};
+
+static void ReplayDrive(const WavBank& bank, const DriveTimeline& tl, float fps, float checkpointSec, DriveReplayResult& res) {
+    static int channelTag = 0;
+    FMOD::Channel* fakeChannel = reinterpret_cast<FMOD::Channel*>(&channelTag);
+
+    VehicleAudioInstance inst;
+    inst.bank = const_cast<WavBank*>(&bank);
+    inst.currentVolume = 0.45f;
+    SmoothingBatch batch;
+    batch.Resize(1);
+    InstanceInputs in;
+    InstanceCommands cmd;
+    TimerWheel timers;
+
+    int frames = (int)(tl.Duration() * fps);
+    float nextCheckpoint = checkpointSec;
+    float lastRaw = 0.0f;
+    for (int f = 0; f <= frames; ++f) {
+        float t = f / fps;
+        in = InstanceInputs();
+        in.active = true;
+        in.vehKey = 0x10000;
+        in.timeStep = (f == 0) ? 0.0f : GAME_TIMESTEP_HZ / fps;
+        in.nowMs = 1000u + (unsigned int)std::lround(t * 1000.0f);
+        tl.At(t, in);
+
+        timers.Advance(in.nowMs);
+        ComputeInstance(inst, in, cmd, batch, 0);
+        SmoothKernelScalar(batch, 0, 1);
+        ArmInstanceTimers(timers, inst, cmd, in.nowMs);
+        if (cmd.startLoop) { inst.loopMode = cmd.loopMode; inst.loopChannel = fakeChannel; }
+        if (cmd.startWind) { inst.windChannel = fakeChannel; StartWindFade(timers, inst, in.nowMs); }
+        if (cmd.hasLane) {
+            inst.currentPitch = batch.currentPitch[0];
+            inst.currentVolume = batch.currentVolume[0];
+            inst.currentWindVolume = batch.currentWind[0];
+        }
+
+        const VehicleSignals& sig = cmd.signals;
+        if (res.firstHeavyDropSec < 0.0f && sig.accel < BACKFIRE_DECEL_PER_SEC) res.firstHeavyDropSec = t;
+        if (f > 0 && in.speed - lastRaw < -3.0f) res.legacyHeavyDrop = true;
+        lastRaw = in.speed;
+        if (sig.throttlePressed) ++res.accelStarts;
+        if (sig.throttleReleased) ++res.accelReleases;
+        if (sig.wheelspin) res.wheelspinSec += sig.dtSec;
+        if (t + 0.5f / fps >= nextCheckpoint) {
+            res.pitchAt.push_back(cmd.hasLane ? batch.displayPitch[0] : 0.0f);
+            res.speedAt.push_back(sig.filteredSpeed);
+            nextCheckpoint += checkpointSec;
+        }
+    }
+}
+
+// o mesmo percurso a 30 e a 144 FPS tem de produzir os mesmos sinais/eventos;
+// com tracePath usa as entradas gravadas (RecordTrace=1), seno o percurso sinttico
+static void CheckFrameRateConsistency(const std::string& tracePath) {
+    DriveTimeline tl;
+    if (tracePath.empty() || !LoadDriveTimeline(tracePath, tl)) {
+        if (!tracePath.empty()) WriteLog("Check fps: falling back to the scripted drive");
+        ScriptedTimeline(tl);
+    }
+
+    WavBank bank;
+    MakeSyntheticBank(bank);
+    if (tl.hasModel) {
+        // mesma caixa de marchas do trace, como no ReplayTrace
+        TransmissionProfile& prof = bank.transmission;
+        prof = TransmissionProfile();
+        prof.gearCount = tl.model.gearCount;
+        std::copy(tl.model.gearMaxVelocity, tl.model.gearMaxVelocity + MAX_TRANSMISSION_GEARS + 1, prof.gearMaxVelocity);
+        ComputeGearConstants(prof);
+        BakeResponseTables(prof);
+        prof.valid = true;
+    }
+    EnsureOverlayRules();
+
+    DriveReplayResult lo, hi;
+    ReplayDrive(bank, tl, 30.0f, 0.5f, lo);
+    ReplayDrive(bank, tl, 144.0f, 0.5f, hi);
+
+    float pitchErr = 0.0f, speedErr = 0.0f;
+    size_t n = std::min(lo.pitchAt.size(), hi.pitchAt.size());
+    for (size_t i = 0; i < n; ++i) {
+        pitchErr = std::max(pitchErr, std::fabs(lo.pitchAt[i] - hi.pitchAt[i]));
+        speedErr = std::max(speedErr, std::fabs(lo.speedAt[i] - hi.speedAt[i]));
+    }
+    // um trace real pode no ter travagem forte: basta os dois concordarem
+    bool dropOk = (lo.firstHeavyDropSec < 0.0f) == (hi.firstHeavyDropSec < 0.0f)
+        && (lo.firstHeavyDropSec < 0.0f || std::fabs(lo.firstHeavyDropSec - hi.firstHeavyDropSec) <= 1.0f / 30.0f);
+    bool ok = dropOk && n > 0
+        && lo.accelStarts == hi.accelStarts && lo.accelReleases == hi.accelReleases
+        && std::fabs(lo.wheelspinSec - hi.wheelspinSec) <= 1.0f / 30.0f
+        && pitchErr < 0.02f && speedErr < 0.5f;
+
+    WriteLog("Check fps: input %s (%.2fs)", tl.source.c_str(), tl.Duration());
+    WriteLog("Check fps: heavyDrop 30fps=%.3fs 144fps=%.3fs (legacy per-frame delta: 30fps=%s 144fps=%s)",
+        lo.firstHeavyDropSec, hi.firstHeavyDropSec, lo.legacyHeavyDrop ? "yes" : "no", hi.legacyHeavyDrop ? "yes" : "no");
+    WriteLog("Check fps: accel start/release 30fps=%d/%d 144fps=%d/%d wheelspin 30fps=%.3fs 144fps=%.3fs",
+        lo.accelStarts, lo.accelReleases, hi.accelStarts, hi.accelReleases, lo.wheelspinSec, hi.wheelspinSec);
+    WriteLog("Check fps: %zu checkpoints maxPitchErr=%.4f maxSpeedErr=%.3f -> %s", n, pitchErr, speedErr, ok ? "OK" : "FAILED");
+}
+
+// latncia evento -> sada por perfil: tempo do playSound at o mixer consumir o
+// primeiro sample (medido, sada real) + o que fica em fila no dispositivo (calculado)
+static void BenchOutputLatency() {
+    struct NamedProfile { const char* name; OutputProfile profile; };
+    std::vector<NamedProfile> profiles;
+    profiles.push_back({ "ini", LoadOutputProfile() });
+    profiles.push_back({ "fmod-default", OutputProfile() });
+    OutputProfile low;
+    low.dspBufferLength = 256; low.dspBufferCount = 4;
+    profiles.push_back({ "256x4", low });
+    low.dspBufferCount = 2;
+    profiles.push_back({ "256x2", low });
+    OutputProfile high;
+    high.dspBufferLength = 2048; high.dspBufferCount = 4;
+    profiles.push_back({ "2048x4", high });
+
+    const int trials = 10;
+    for (const NamedProfile& np : profiles) {
+        FMOD::System* system = nullptr;
+        if (FMOD::System_Create(&system) != FMOD_OK || !system) { WriteLog("Bench latency: System_Create failed"); return; }
+        ApplyOutputProfile(system, np.profile);
+        FMOD_RESULT r = system->init(np.profile.maxChannels, FMOD_INIT_NORMAL, nullptr);
+        if (r != FMOD_OK) {
+            WriteLog("Bench latency: %s init failed r=%d (no output device?)", np.name, (int)r);
+            system->release();
+            continue;
+        }
+        unsigned int length = 0;
+        int count = 0, rate = 0;
+        double queuedMs = OutputLatencyMs(system, &length, &count, &rate);
+
+        // 1 s de silncio em loop: s interessa quando a posio comea a andar
+        FMOD_CREATESOUNDEXINFO ex = {};
+        ex.cbSize = sizeof(ex);
+        ex.numchannels = 1;
+        ex.defaultfrequency = (rate > 0) ? rate : 48000;
+        ex.format = FMOD_SOUND_FORMAT_PCM16;
+        ex.length = (unsigned int)ex.defaultfrequency * 2;
+        FMOD::Sound* snd = nullptr;
+        system->createSound(nullptr, static_cast<FMOD_MODE>(FMOD_OPENUSER | FMOD_2D | FMOD_LOOP_NORMAL), &ex, &snd);
+
+        double sumMs = 0.0, maxMs = 0.0;
+        int measured = 0;
+        for (int t = 0; snd && t < trials; ++t) {
+            FMOD::Channel* ch = nullptr;
+            auto t0 = std::chrono::steady_clock::now();
+            if (system->playSound(snd, nullptr, false, &ch) != FMOD_OK || !ch) break;
+            unsigned int pos = 0;
+            double ms = 0.0;
+            while (ms < 500.0) {
+                system->update();
+                if (ch->getPosition(&pos, FMOD_TIMEUNIT_PCM) == FMOD_OK && pos > 0) break;
+                std::this_thread::yield();
+                ms = ElapsedUs(t0) / 1000.0;
+            }
+            ms = ElapsedUs(t0) / 1000.0;
+            ch->stop();
+            if (pos == 0) continue;
+            sumMs += ms;
+            maxMs = std::max(maxMs, ms);
+            ++measured;
+        }
+        if (snd) snd->release();
+        system->close();
+        system->release();
+
+        if (measured == 0) { WriteLog("Bench latency: %s no measurement", np.name); continue; }
+        WriteLog("Bench latency: %-12s %d Hz %u x %d queued=%.1f ms start avg=%.2f max=%.2f ms -> event-to-output avg=%.1f max=%.1f ms",
+            np.name, rate, length, count, queuedMs, sumMs / measured, maxMs, queuedMs + sumMs / measured, queuedMs + maxMs);
+    }
+}
+
+// carga parecida com a do FMOD: muitos blocos pequenos, alguns mdios e
+// poucos grandes (sample data), com libertaes aleatrias pelo meio
+static void BenchFMODAllocator() {
+    const int ops = 200000;
+    const int live = 4096;
+    struct Op { unsigned int size; unsigned int type; int slot; };
+    std::vector<Op> script(ops);
+    unsigned int rng = 0x9E3779B9u;
+    auto next = [&rng]() { rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5; return rng; };
+    for (Op& op : script) {
+        unsigned int pick = next() % 100;
+        if (pick < 70) { op.size = 16 + next() % 1008; op.type = FMOD_MEMORY_NORMAL; }
+        else if (pick < 97) { op.size = 1024 + next() % 3072; op.type = FMOD_MEMORY_NORMAL; }
+        else { op.size = 64 * 1024 + next() % (2 * 1024 * 1024); op.type = FMOD_MEMORY_SAMPLEDATA; }
+        op.slot = (int)(next() % live);
+    }
+
+    // mesma sequncia: cada op liberta o que estiver no slot e aloca um bloco novo
+    auto run = [&](auto alloc, auto release, auto beforeCleanup) {
+        std::vector<void*> slots(live, nullptr);
+        auto t0 = std::chrono::steady_clock::now();
+        for (const Op& op : script) {
+            if (slots[op.slot]) release(slots[op.slot]);
+            slots[op.slot] = alloc(op.size, op.type);
+            if (slots[op.slot]) ((volatile char*)slots[op.slot])[0] = 1;
+        }
+        double us = ElapsedUs(t0);
+        beforeCleanup();
+        for (void* p : slots) if (p) release(p);
+        return us;
+    };
+    auto nothing = [] {};
+
+    double heapUs = run([](unsigned int size, unsigned int) { return std::malloc(size); }, [](void* p) { std::free(p); }, nothing);
+
+    // fragmentao medida com o working set ainda vivo
+    FmodArenaAllocator arena;
+    arena.Init(0);
+    FmodArenaAllocator::Stats mid;
+    double arenaUs = run([&](unsigned int size, unsigned int type) { return arena.Alloc(size, type); },
+        [&](void* p) { arena.Free(p); }, [&] { mid = arena.GetStats(); });
+    long long leaked = arena.GetStats().currentBytes;
+    double frag = (mid.arenaFreeBytes > 0) ? 1.0 - double(mid.arenaLargestFree) / double(mid.arenaFreeBytes) : 0.0;
+
+    WriteLog("Bench allocator: %d ops heap=%.1f ns/op arena=%.1f ns/op", ops, heapUs * 1000.0 / ops, arenaUs * 1000.0 / ops);
+    WriteLog("Bench allocator: arena live=%lld KB peak=%lld KB reserved=%lld KB (%.2fx peak) arena free=%lld KB largest=%lld KB frag=%.2f leaked=%lld B",
+        mid.currentBytes >> 10, mid.peakBytes >> 10, mid.reservedBytes >> 10, (mid.peakBytes > 0) ? double(mid.reservedBytes) / double(mid.peakBytes) : 0.0,
+        mid.arenaFreeBytes >> 10, mid.arenaLargestFree >> 10, frag, leaked);
+
+    // com pool fixo o cap tem de segurar: falhas em vez de crescer
+    FmodArenaAllocator capped;
+    capped.Init(32 * 1024 * 1024);
+    run([&](unsigned int size, unsigned int type) { return capped.Alloc(size, type); }, [&](void* p) { capped.Free(p); }, nothing);
+    FmodArenaAllocator::Stats cs = capped.GetStats();
+    WriteLog("Bench allocator: 32 MB pool reserved=%lld KB peak live=%lld KB fails=%llu",
+        cs.reservedBytes >> 10, cs.peakBytes >> 10, cs.failCount);
+
+    // realloc que encolhe um bloco grande no lugar: a cauda volta  arena j, e o
+    // free devolve o bloco inteiro; o double free  contado e o bloco fica intacto
+    FmodArenaAllocator shrink;
+    shrink.Init(0);
+    void* big = shrink.Alloc(1024 * 1024, FMOD_MEMORY_SAMPLEDATA);
+    void* kept = shrink.Realloc(big, 64 * 1024, FMOD_MEMORY_SAMPLEDATA);
+    FmodArenaAllocator::Stats afterShrink = shrink.GetStats();
+    shrink.Free(kept);
+    shrink.Free(kept);
+    FmodArenaAllocator::Stats afterFree = shrink.GetStats();
+    bool ok = big && kept == big && afterShrink.arenaFreeBytes + 64 * 1024 + 64 == afterShrink.reservedBytes
+        && afterFree.arenaFreeBytes == afterFree.reservedBytes && afterFree.badFrees == 1;
+    WriteLog("Bench allocator: shrink 1 MB -> 64 KB in place free after shrink=%lld KB, after free=%lld/%lld KB badFrees=%llu -> %s",
+        afterShrink.arenaFreeBytes >> 10, afterFree.arenaFreeBytes >> 10, afterFree.reservedBytes >> 10, afterFree.badFrees, ok ? "OK" : "FAILED");
+}
+
+// custo do mixer por voz: 64 loops 3D tocando uma fonte 44.1 kHz estreo crua
+// contra a mesma fonte pr-convertida (mono, taxa do mixer); mix em NOSOUND_NRT
+static void BenchPreprocessedVoices() {
+    const int voices = 64;
+    const int blocks = 400;
+
+    PcmData src;
+    src.rate = 44100;
+    src.channels = 2;
+    src.samples.resize(44100 * 2);
+    unsigned int rng = 12345u;
+    for (size_t f = 0; f < src.Frames(); ++f) {
+        rng = rng * 1664525u + 1013904223u;
+        float saw = float(f % 147) / 73.5f - 1.0f;             // ~300 Hz
+        float noise = float(rng >> 8) / 8388608.0f - 1.0f;
+        src.samples[f * 2] = 0.5f * saw + 0.1f * noise;
+        src.samples[f * 2 + 1] = 0.5f * saw - 0.1f * noise;
+    }
+    std::vector<char> raw = EncodeWav(src, false);
+
+    FMOD::System* system = nullptr;
+    if (FMOD::System_Create(&system) != FMOD_OK || !system) { WriteLog("Bench voices: System_Create failed"); return; }
+    system->setOutput(FMOD_OUTPUTTYPE_NOSOUND_NRT);
+    ApplyOutputProfile(system, LoadOutputProfile());
+    if (system->init(512, FMOD_INIT_NORMAL, nullptr) != FMOD_OK) { WriteLog("Bench voices: init failed"); system->release(); return; }
+    SampleTarget target = MixerSampleTarget(system, true);
+    std::vector<char> converted;
+    ConvertWav(raw, target, true, converted);
+
+    FMOD_VECTOR origin = { 0.0f, 0.0f, 0.0f }, zero = { 0.0f, 0.0f, 0.0f };
+    FMOD_VECTOR fwd = { 0.0f, 1.0f, 0.0f }, up = { 0.0f, 0.0f, 1.0f };
+    system->set3DListenerAttributes(0, &origin, &zero, &fwd, &up);
+
+    auto measure = [&](const std::vector<char>& wav, const char* label) {
+        FMOD_CREATESOUNDEXINFO ex = {};
+        ex.cbSize = sizeof(ex);
+        ex.length = (unsigned int)wav.size();
+        FMOD::Sound* snd = nullptr;
+        FMOD_MODE mode = static_cast<FMOD_MODE>(FMOD_OPENMEMORY | FMOD_CREATESAMPLE | FMOD_3D | FMOD_LOOP_NORMAL);
+        if (system->createSound(wav.data(), mode, &ex, &snd) != FMOD_OK || !snd) { WriteLog("Bench voices: %s createSound failed", label); return; }
+        std::vector<FMOD::Channel*> chans;
+        for (int v = 0; v < voices; ++v) {
+            FMOD::Channel* ch = nullptr;
+            if (system->playSound(snd, nullptr, true, &ch) != FMOD_OK || !ch) continue;
+            float a = v * 6.2831853f / voices;
+            FMOD_VECTOR pos = { 20.0f * std::cos(a), 20.0f * std::sin(a), 0.0f };
+            ch->set3DAttributes(&pos, &zero);
+            ch->set3DMinMaxDistance(1.0f, 300.0f);
+            ch->setPitch(0.8f + 0.6f * float(v) / voices);   // faixa tpica do loop de motor
+            ch->setPaused(false);
+            chans.push_back(ch);
+        }
+        system->update();
+        auto t0 = std::chrono::steady_clock::now();
+        for (int b = 0; b < blocks; ++b) system->update();
+        double us = ElapsedUs(t0);
+        FMOD_CPU_USAGE cpu = {};
+        system->getCPUUsage(&cpu);
+        for (FMOD::Channel* ch : chans) ch->stop();
+        snd->release();
+        WriteLog("Bench voices: %-12s %d voices %.3f us/voice/block dsp=%.1f%% (%zu bytes)",
+            label, (int)chans.size(), chans.empty() ? 0.0 : us / blocks / chans.size(), cpu.dsp, wav.size());
+    };
+    measure(raw, "44k-stereo");
+    if (!converted.empty()) measure(converted, target.asFloat ? "native-f32" : "native-s16");
+    system->close();
+    system->release();
+}
+
+// anlise de nvel sobre 10 s de estreo 48 kHz; os kernels SIMD tm de bater
+// com o escalar (loudness/pico exatos, RMS at arredondamento)
+static void BenchLoudnessAnalysis() {
+    PcmData pcm;
+    pcm.rate = 48000;
+    pcm.channels = 2;
+    pcm.samples.resize(size_t(pcm.rate) * 10 * 2);
+    unsigned int rng = 777u;
+    for (size_t f = 0; f < pcm.Frames(); ++f) {
+        rng = rng * 1664525u + 1013904223u;
+        float env = (f < pcm.Frames() / 2) ? 0.6f : 0.15f;      // metade alta, metade baixa (exercita o gate)
+        float tone = std::sin(float(f) * 0.0392699f);             // ~300 Hz
+        float noise = float(rng >> 8) / 8388608.0f - 1.0f;
+        pcm.samples[f * 2] = env * (0.8f * tone + 0.2f * noise);
+        pcm.samples[f * 2 + 1] = env * (0.8f * tone - 0.2f * noise);
+    }
+    double mb = double(pcm.samples.size() * sizeof(float)) / (1024.0 * 1024.0);
+
+    struct Kernel { const char* name; LevelKernelFn fn; bool available; };
+    CpuFeatures cpu = DetectCpuFeatures();
+    Kernel kernels[] = {
+        { "scalar", LevelKernelScalar, true },
+        { "SSE2", LevelKernelSSE2, cpu.sse2 },
+        { "AVX2", LevelKernelAVX2, cpu.avx2 },
+    };
+    SoundMetrics ref = AnalyzePcm(pcm, true, LevelKernelScalar);
+    const int reps = 20;
+    for (const Kernel& k : kernels) {
+        if (!k.available) { WriteLog("Bench loudness: %s not available", k.name); continue; }
+        SoundMetrics m;
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) m = AnalyzePcm(pcm, true, k.fn);
+        double us = ElapsedUs(t0);
+        float err = std::max(std::max(std::fabs(m.rmsDb - ref.rmsDb), std::fabs(m.peakDb - ref.peakDb)),
+            std::max(std::fabs(m.loudness - ref.loudness), std::fabs(m.seamRatio - ref.seamRatio) / std::max(1.0f, ref.seamRatio)));
+        WriteLog("Bench loudness: %-6s %.1f MB/s rms=%.2fdB peak=%.2fdB loudness=%.2f seam=%.2f maxErr=%.4f%s",
+            k.name, mb * reps / (us / 1e6), m.rmsDb, m.peakDb, m.loudness, m.seamRatio, err, (err > 0.01f) ? " (OUT OF TOLERANCE)" : "");
+    }
+}
+
+// leitores sob EpochGuard contra escritores que substituem/removem bancos. Cada banco
+// sinttico leva um checksum (soundMask = modelo, gearCount = modelo % 6 + 1); o deleter
+// do teste envenena a struct e guarda-a at ao fim, por isso uma libertao antecipada
+// aparece como leitura envenenada em vez de uso-aps-free silencioso.
+struct RegistryStress {
+    static const unsigned int POISON = 0xDEADBEEFu;
+    static std::mutex graveyardMutex;
+    static std::vector<WavBank*> graveyard;
+    static void Bury(void* p) {
+        WavBank* b = static_cast<WavBank*>(p);
+        b->soundMask = POISON;
+        b->transmission.gearCount = -1;
+        std::lock_guard<std::mutex> lk(graveyardMutex);
+        graveyard.push_back(b);
+    }
+    static WavBank* Make(int modelId) {
+        WavBank* b = new WavBank();
+        b->soundMask = (unsigned int)modelId;
+        b->transmission.gearCount = modelId % 6 + 1;
+        return b;
+    }
+    // 0 = ok, 1 = rasgado, 2 = libertado cedo
+    static int Check(const WavBank* b, int modelId) {
+        unsigned int mask = b->soundMask;
+        int gears = b->transmission.gearCount;
+        if (mask == POISON || gears == -1) return 2;
+        return (mask == (unsigned int)modelId && gears == modelId % 6 + 1) ? 0 : 1;
+    }
+};
+std::mutex RegistryStress::graveyardMutex;
+std::vector<WavBank*> RegistryStress::graveyard;
+
+static void BenchBankRegistry() {
+    const int models = 212;  // 400..611, como o SA
+    const int readers = 4;
+    const int writers = 2;
+    const auto duration = std::chrono::milliseconds(300);
+
+    EpochReclaimer epochs;
+    BankRegistry registry;
+    std::atomic<unsigned long long> created{ 0 }, reads{ 0 }, writes{ 0 }, torn{ 0 }, early{ 0 };
+    for (int m = 0; m < models; ++m) {
+        BankRegistry::Slot* s = registry.FindOrInsert(400 + m);
+        s->bank.store(RegistryStress::Make(400 + m), std::memory_order_release);
+        s->state.store(BANK_READY, std::memory_order_release);
+        ++created;
+    }
+
+    std::atomic<bool> stop{ false };
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            unsigned int rng = 0x9E3779B9u * (r + 1);
+            unsigned long long n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                EpochReclaimer::Guard guard(epochs);
+                for (int i = 0; i < 64; ++i) {
+                    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                    int modelId = 400 + int(rng % models);
+                    BankRegistry::Slot* s = registry.Find(modelId);
+                    WavBank* b = s ? s->bank.load(std::memory_order_acquire) : nullptr;
+                    if (!b) continue;
+                    int c = RegistryStress::Check(b, modelId);
+                    if (c == 1) ++torn;
+                    else if (c == 2) ++early;
+                }
+                n += 64;
+            }
+            reads += n;
+        });
+    }
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            unsigned int rng = 0x85EBCA6Bu * (w + 1);
+            unsigned long long n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                int modelId = 400 + int(rng % models);
+                BankRegistry::Slot* s = registry.Find(modelId);
+                // 1 em 4 remove, o resto substitui (hot reload / expirao de prefetch)
+                WavBank* fresh = (rng & 3) ? RegistryStress::Make(modelId) : nullptr;
+                if (fresh) ++created;
+                WavBank* old = s->bank.exchange(fresh, std::memory_order_acq_rel);
+                epochs.Retire(old, RegistryStress::Bury);
+                if ((++n & 31) == 0) epochs.Collect();
+            }
+            writes += n;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (std::thread& t : threads) t.join();
+    epochs.Collect();
+    size_t pending = epochs.Pending();
+
+    // o que sobra na tabela + o que passou pelo deleter tem de bater com o que foi criado
+    unsigned long long live = 0;
+    registry.ForEach([&live](BankRegistry::Slot& s) {
+        if (WavBank* b = s.bank.exchange(nullptr)) { ++live; delete b; }
+    });
+    epochs.Drain();
+    unsigned long long freed = RegistryStress::graveyard.size();
+    for (WavBank* b : RegistryStress::graveyard) delete b;
+    RegistryStress::graveyard.clear();
+    long long leaked = (long long)created.load() - (long long)(live + freed);
+
+    double sec = std::chrono::duration<double>(duration).count();
+    WriteLog("Bench registry: readers=%d writers=%d reads=%.1f M/s writes=%.1f K/s torn=%llu early=%llu leaked=%lld pendingAfterCollect=%zu%s",
+        readers, writers, reads / sec / 1e6, writes / sec / 1e3, torn.load(), early.load(), leaked, pending,
+        (torn || early || leaked) ? " (FAILED)" : "");
+
+    // referncia: o antigo mutex + std::map com a mesma carga (leitores e escritores);
+    // o escritor troca/remove sob o lock e apaga o antigo depois, como o cdigo antigo
+    std::mutex mapMutex;
+    std::map<int, WavBank*> map;
+    for (int m = 0; m < models; ++m) map[400 + m] = RegistryStress::Make(400 + m);
+    std::atomic<unsigned long long> mapReads{ 0 }, mapWrites{ 0 }, mapTorn{ 0 }, mapSink{ 0 };
+    stop.store(false);
+    threads.clear();
+    for (int r = 0; r < readers; ++r) {
+        threads.emplace_back([&, r] {
+            unsigned int rng = 0x9E3779B9u * (r + 1);
+            unsigned long long n = 0, sink = 0, bad = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; ++i) {
+                    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                    int modelId = 400 + int(rng % models);
+                    std::lock_guard<std::mutex> lk(mapMutex);
+                    auto it = map.find(modelId);
+                    if (it == map.end()) continue;
+                    sink += it->second->soundMask;
+                    if (RegistryStress::Check(it->second, modelId) != 0) ++bad;
+                }
+                n += 64;
+            }
+            mapReads += n;
+            mapTorn += bad;
+            mapSink += sink;  // mantm as leituras vivas no optimizador
+        });
+    }
+    for (int w = 0; w < writers; ++w) {
+        threads.emplace_back([&, w] {
+            unsigned int rng = 0x85EBCA6Bu * (w + 1);
+            unsigned long long n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                int modelId = 400 + int(rng % models);
+                WavBank* fresh = (rng & 3) ? RegistryStress::Make(modelId) : nullptr;
+                WavBank* old = nullptr;
+                {
+                    std::lock_guard<std::mutex> lk(mapMutex);
+                    auto it = map.find(modelId);
+                    if (it != map.end()) { old = it->second; map.erase(it); }
+                    if (fresh) map[modelId] = fresh;
+                }
+                delete old;
+                ++n;
+            }
+            mapWrites += n;
+        });
+    }
+    std::this_thread::sleep_for(duration);
+    stop.store(true);
+    for (std::thread& t : threads) t.join();
+    for (auto& kv : map) delete kv.second;
+    WriteLog("Bench registry: mutex+map baseline readers=%d writers=%d reads=%.1f M/s writes=%.1f K/s torn=%llu",
+        readers, writers, mapReads / sec / 1e6, mapWrites / sec / 1e3, mapTorn.load());
+}
+
+// quarteires em grelha  volta do ouvinte (AABB), para o ScheduleOcclusion correr sem o jogo
+class BoxOcclusionWorld : public OcclusionWorld {
+public:
+    struct Box { float lo[3], hi[3]; };
+    std::vector<Box> boxes;
+    unsigned long long rays = 0;
+
+    bool Occluded(const FMOD_VECTOR& from, const FMOD_VECTOR& to) override {
+        ++rays;
+        for (const Box& b : boxes) if (SegmentHits(from, to, b)) return true;
+        return false;
+    }
+
+    static bool SegmentHits(const FMOD_VECTOR& a, const FMOD_VECTOR& b, const Box& box) {
+        float o[3] = { a.x, a.y, a.z }, d[3] = { b.x - a.x, b.y - a.y, b.z - a.z };
+        float t0 = 0.0f, t1 = 1.0f;
+        for (int i = 0; i < 3; ++i) {
+            if (std::fabs(d[i]) < 1e-6f) {
+                if (o[i] < box.lo[i] || o[i] > box.hi[i]) return false;
+                continue;
+            }
+            float ta = (box.lo[i] - o[i]) / d[i], tb = (box.hi[i] - o[i]) / d[i];
+            if (ta > tb) std::swap(ta, tb);
+            t0 = std::max(t0, ta);
+            t1 = std::min(t1, tb);
+            if (t0 > t1) return false;
+        }
+        return true;
+    }
+};
+
+// carros em rbita  volta do ouvinte, entre quarteires de 24 m a cada 60 m. "Latncia
+// percebida" = desde que a linha de vista real muda at o valor suavizado passar a meio
+// caminho do novo estado; "erro" = frao ponderada pela audibilidade com cache errada.
+static void BenchOcclusion() {
+    const int vehicles = 64;
+    const int frames = 3600;  // 60 s a 60 FPS
+    const float dtSec = 1.0f / 60.0f;
+
+    BoxOcclusionWorld world;
+    for (int i = -4; i < 4; ++i)
+        for (int j = -4; j < 4; ++j) {
+            float cx = i * 60.0f + 30.0f, cy = j * 60.0f + 30.0f;
+            world.boxes.push_back({ { cx - 12.0f, cy - 12.0f, 0.0f }, { cx + 12.0f, cy + 12.0f, 30.0f } });
+        }
+    BoxOcclusionWorld truthWorld = world;
+    const FMOD_VECTOR listener = { 0.0f, 0.0f, 2.0f };
+
+    struct Config { int rays; unsigned int ttlMs; };
+    const Config configs[] = { { 1, 250 }, { 2, 250 }, { 4, 250 }, { 8, 250 }, { 8, 100 }, { 64, 0 } };
+    for (const Config& c : configs) {
+        OcclusionParams p;
+        p.raysPerFrame = c.rays;
+        p.ttlMs = c.ttlMs;
+        OcclusionStats stats;
+        world.rays = 0;
+        std::vector<OcclusionState> states(vehicles);
+        std::vector<OcclusionTarget> targets(vehicles);
+        std::vector<float> truthPrev(vehicles, -1.0f);
+        std::vector<int> changeFrame(vehicles, -1);
+        std::vector<float> latencies;
+        double errW = 0.0, totalW = 0.0, computeUs = 0.0;
+
+        for (int f = 0; f < frames; ++f) {
+            float t = f * dtSec;
+            for (int v = 0; v < vehicles; ++v) {
+                float radius = 15.0f + v * 4.0f;           // 15..267 m
+                float omega = (8.0f + (v % 7) * 3.0f) / radius * ((v & 1) ? 1.0f : -1.0f);  // 8..26 m/s
+                float a = v * 0.37f + omega * t;
+                targets[v].state = &states[v];
+                targets[v].pos = { radius * std::cos(a), radius * std::sin(a), OCCLUSION_EMITTER_HEIGHT };
+                targets[v].audibility = OcclusionAudibility(0.45f, radius);
+            }
+            auto t0 = std::chrono::steady_clock::now();
+            ScheduleOcclusion(world, listener, targets, p, 1000u + (unsigned int)(t * 1000.0f), dtSec, stats);
+            computeUs += ElapsedUs(t0);
+
+            for (int v = 0; v < vehicles; ++v) {
+                float truth = truthWorld.Occluded(listener, targets[v].pos) ? 1.0f : 0.0f;
+                if (truthPrev[v] >= 0.0f && truth != truthPrev[v]) changeFrame[v] = (changeFrame[v] >= 0) ? -1 : f;  // voltou atrs antes de ser visto: descarta
+                truthPrev[v] = truth;
+                if (changeFrame[v] >= 0 && std::fabs(states[v].current - truth) < 0.5f) {
+                    latencies.push_back((f - changeFrame[v]) * dtSec * 1000.0f);
+                    changeFrame[v] = -1;
+                }
+                totalW += targets[v].audibility;
+                if (states[v].target != truth) errW += targets[v].audibility;
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        double mean = 0.0;
+        for (float l : latencies) mean += l;
+        mean = latencies.empty() ? 0.0 : mean / latencies.size();
+        float p95 = latencies.empty() ? 0.0f : latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)];
+        WriteLog("Bench occlusion: budget=%2d ttl=%3u ms -> %.2f rays/frame, perceived latency avg %.0f ms p95 %.0f ms max %.0f ms (%zu changes), weighted error %.2f%%, %.2f us/frame",
+            c.rays, c.ttlMs, double(world.rays) / frames, mean, p95, latencies.empty() ? 0.0f : latencies.back(), latencies.size(),
+            totalW > 0.0 ? 100.0 * errW / totalW : 0.0, computeUs / frames);
+    }
+}
+
+// pool simulado de 500 carros (70% na cidade  volta do ouvinte, o resto espalhado pelo
+// mapa) a andar; compara a consulta de 300 m na grelha com o varrimento do pool inteiro
+static void BenchVehicleGrid() {
+    const int vehicles = 500;
+    const int frames = 2000;
+    const float dtSec = 1.0f / 60.0f;
+
+    struct SimCar { CVector pos, vel; };
+    std::vector<SimCar> cars(vehicles);
+    // o pool real guarda entidades de ~2.4 KB (CAutomobile): o varrimento toca uma linha de cache por carro
+    struct PoolSlot { CVector pos; char entity[2400]; };
+    std::vector<PoolSlot> pool(vehicles);
+    unsigned int rng = 4242u;
+    auto rnd = [&rng](float lo, float hi) { rng = rng * 1664525u + 1013904223u; return lo + (hi - lo) * float(rng >> 8) / 16777216.0f; };
+    for (int v = 0; v < vehicles; ++v) {
+        float span = (v % 10 < 7) ? 800.0f : 3000.0f;
+        cars[v].pos = CVector(rnd(-span, span), rnd(-span, span), rnd(0.0f, 20.0f));
+        float heading = rnd(0.0f, 6.2831853f), speed = rnd(0.0f, 30.0f);
+        cars[v].vel = CVector(std::cos(heading) * speed, std::sin(heading) * speed, 0.0f);
+    }
+    // chaves opacas: a grelha nunca desreferencia o veculo
+    auto key = [](int v) { return reinterpret_cast<CVehicle*>(uintptr_t(0x10000 + v * 0x40)); };
+
+    VehicleSpatialGrid grid;
+    for (int v = 0; v < vehicles; ++v) grid.Update(key(v), cars[v].pos);
+
+    std::vector<GridHit> hits, scan, nearest;
+    double updateUs = 0.0, queryUs = 0.0, nearestUs = 0.0, scanUs = 0.0;
+    unsigned long long candidates = 0, mismatches = 0;
+    for (int f = 0; f < frames; ++f) {
+        CVector listener(std::sin(f * 0.002f) * 200.0f, std::cos(f * 0.002f) * 200.0f, 5.0f);
+        for (SimCar& c : cars) {
+            c.pos.x += c.vel.x * dtSec;
+            c.pos.y += c.vel.y * dtSec;
+            if (std::fabs(c.pos.x) > 3000.0f) c.vel.x = -c.vel.x;
+            if (std::fabs(c.pos.y) > 3000.0f) c.vel.y = -c.vel.y;
+        }
+        for (int v = 0; v < vehicles; ++v) pool[v].pos = cars[v].pos;
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (int v = 0; v < vehicles; ++v) grid.Update(key(v), cars[v].pos);
+        updateUs += ElapsedUs(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        grid.Query(listener, AUDIBLE_RADIUS, 0, hits);
+        queryUs += ElapsedUs(t0);
+
+        t0 = std::chrono::steady_clock::now();
+        grid.Query(listener, AUDIBLE_RADIUS, 8, nearest);
+        nearestUs += ElapsedUs(t0);
+
+        // o que o OnProcess teria de fazer sem a grelha
+        t0 = std::chrono::steady_clock::now();
+        scan.clear();
+        for (int v = 0; v < vehicles; ++v) {
+            float d = (pool[v].pos - listener).Magnitude();
+            if (d <= AUDIBLE_RADIUS) scan.push_back({ d, key(v) });
+        }
+        std::sort(scan.begin(), scan.end());
+        scanUs += ElapsedUs(t0);
+
+        candidates += hits.size();
+        bool same = hits.size() == scan.size();
+        for (size_t i = 0; same && i < hits.size(); ++i) same = hits[i].veh == scan[i].veh && hits[i].dist == scan[i].dist;
+        same = same && nearest.size() == std::min<size_t>(8, scan.size());
+        for (size_t i = 0; same && i < nearest.size(); ++i) same = nearest[i].veh == scan[i].veh && nearest[i].dist == scan[i].dist;
+        if (!same) ++mismatches;
+    }
+    WriteLog("Bench grid: %d vehicles, %.1f candidates within %.0f m, %.2f cell moves/frame",
+        vehicles, double(candidates) / frames, AUDIBLE_RADIUS, double(grid.Moves()) / frames);
+    WriteLog("Bench grid: pool scan %.2f us/frame | grid query %.2f us/frame, nearest 8 %.2f us/frame, incremental update %.2f us/frame (%.3f us/vehicle) mismatches=%llu%s",
+        scanUs / frames, queryUs / frames, nearestUs / frames, updateUs / frames, updateUs / frames / vehicles, mismatches, mismatches ? " (FAILED)" : "");
+}
+
+// escritor contra um leitor numa vista prpria do mapping, como o TelemetryReader (num
+// mapping privado deste processo, nunca no do jogo, que pode estar a ser lido): em
+// rajada (o anel d voltas, o leitor perde registos) e ao ritmo do jogo (64 instncias a
+// cada 1 ms). Os campos de cada registo derivam do 'frame', por isso um registo rasgado
+// no passa na verificao; recebidos + perdidos tem de dar o total publicado.
+static void BenchTelemetry() {
+    struct Phase { const char* name; uint32_t records; bool slowReader; bool paced; };
+    const Phase phases[] = {
+        { "burst, fast reader", 1u << 21, false, false },
+        { "burst, slow reader", 1u << 21, true, false },
+        { "paced 64/ms", 64u * 500u, false, true },
+    };
+    char name[64];
+    snprintf(name, sizeof(name), "Local\\VehicleSFX_TelemetryBench_%lu", (unsigned long)GetCurrentProcessId());
+    for (const Phase& ph : phases) {
+        const uint32_t records = ph.records;
+        const bool slowReader = ph.slowReader;
+        TelemetryExport writer;
+        if (!writer.Open(name)) { WriteLog("Bench telemetry: mapping unavailable"); return; }
+
+        std::atomic<bool> done{ false };
+        unsigned long long received = 0, torn = 0;
+        uint64_t lost = 0;
+        std::thread reader([&] {
+            HANDLE h = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+            const VsfxTelemetryBlock* block = h ? static_cast<const VsfxTelemetryBlock*>(MapViewOfFile(h, FILE_MAP_READ, 0, 0, sizeof(VsfxTelemetryBlock))) : nullptr;
+            if (!VsfxTelemetryValid(block)) { if (block) UnmapViewOfFile(block); if (h) CloseHandle(h); return; }
+            static VsfxTelemetryRecord buf[256];
+            uint32_t next = block->header.head.load(std::memory_order_acquire);
+            for (;;) {
+                bool finished = done.load(std::memory_order_acquire);
+                uint32_t n = VsfxTelemetryRead(block, next, buf, 256, lost);
+                for (uint32_t i = 0; i < n; ++i) {
+                    const VsfxTelemetryRecord& r = buf[i];
+                    if (r.timeMs != r.frame * 7u || r.speed != float(r.frame & 0xFFFF) || r.windCurrent != -r.speed) ++torn;
+                }
+                received += n;
+                if (finished && next == block->header.head.load(std::memory_order_acquire)) break;
+                if (slowReader) std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                else if (!n) std::this_thread::yield();
+            }
+            UnmapViewOfFile(block);
+            CloseHandle(h);
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));  // leitor j ligado
+
+        VsfxTelemetryRecord r = {};
+        double us = 0.0;
+        for (uint32_t i = 0; i < records; i += 64) {
+            if (ph.paced && i) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            auto t0 = std::chrono::steady_clock::now();
+            for (uint32_t k = i; k < i + 64; ++k) {
+                r.frame = k;
+                r.timeMs = k * 7u;
+                r.speed = float(k & 0xFFFF);
+                r.windCurrent = -r.speed;
+                writer.Publish(r);
+            }
+            us += ElapsedUs(t0);
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        writer.Close();
+        WriteLog("Bench telemetry: %s, writer %.1f ns/record (%zu-byte memcpy), received=%llu lost=%llu torn=%llu accounted=%s%s",
+            ph.name, us * 1000.0 / records, sizeof(VsfxTelemetryRecord), received, (unsigned long long)lost, torn,
+            (received + lost == records) ? "yes" : "no", (torn || received + lost != records) ? " (FAILED)" : "");
+    }
+}
+
+// roda de prazos vs varrimento de timestamps por frame, com N instncias x L prazos pendentes.
+// Cada prazo que vence  rearmado (como um cooldown que volta a disparar) e 1/16 dos donos
+// reagenda um prazo por frame (cancel + schedule); o callback confere que dispara no tick exato.
+struct WheelBenchOwner {
+    uint32_t handle[IT_COUNT] = {};
+    uint32_t deadline[IT_COUNT] = {};
+};
+struct WheelBenchState {
+    unsigned long long fired = 0, wrongTime = 0;
+    std::vector<std::pair<WheelBenchOwner*, int>> due;
+};
+static WheelBenchState s_wheelBench;
+
+static void OnWheelBenchTimer(void* ctx, uint32_t timer, uint32_t nowMs) {
+    WheelBenchOwner& o = *static_cast<WheelBenchOwner*>(ctx);
+    o.handle[timer] = 0;
+    ++s_wheelBench.fired;
+    if (nowMs != o.deadline[timer]) ++s_wheelBench.wrongTime;
+    s_wheelBench.due.push_back({ &o, (int)timer });
+}
+
+static void BenchTimerWheel() {
+    const int counts[] = { 64, 256, 1024, 4096 };
+    const int loads[] = { 0, 1, IT_COUNT };
+    const int frames = 2000;
+    for (int vehicles : counts) {
+        for (int load : loads) {
+            unsigned int rng = 99u + vehicles + load;
+            auto rnd = [&rng](uint32_t lo, uint32_t hi) { rng = rng * 1664525u + 1013904223u; return lo + (rng >> 8) % (hi - lo); };
+            TimerWheel wheel;
+            std::vector<WheelBenchOwner> owners(vehicles);
+            s_wheelBench = WheelBenchState();
+            uint32_t now = 5000;
+            unsigned long long cancelled = 0, rearmed = 0;
+            auto arm = [&](WheelBenchOwner& o, int t) {
+                if (o.handle[t] && wheel.Cancel(o.handle[t])) ++cancelled;
+                uint32_t delay = rnd(20, 3000);  // de um cooldown curto a um fade de wind
+                o.deadline[t] = now + delay;
+                o.handle[t] = wheel.Schedule(now, delay, OnWheelBenchTimer, &o, (uint32_t)t);
+            };
+            for (WheelBenchOwner& o : owners) for (int t = 0; t < load; ++t) arm(o, t);
+
+            // o que cada instncia fazia antes: comparar todos os timestamps a cada frame
+            struct Stamps { uint32_t at[IT_COUNT]; uint32_t dur[IT_COUNT]; unsigned int active; };
+            std::vector<Stamps> stamps(vehicles);
+            for (Stamps& s : stamps) for (int t = 0; t < IT_COUNT; ++t) { s.at[t] = now; s.dur[t] = t < load ? rnd(20, 3000) : 0; }
+
+            double wheelUs = 0.0, scanUs = 0.0;
+            unsigned long long pendingSum = 0;
+            for (int f = 0; f < frames; ++f) {
+                now += rnd(15, 18);
+                auto t0 = std::chrono::steady_clock::now();
+                wheel.Advance(now);
+                for (auto& d : s_wheelBench.due) { arm(*d.first, d.second); ++rearmed; }
+                s_wheelBench.due.clear();
+                if (load) {
+                    for (int v = f % 16; v < vehicles; v += 16) { arm(owners[v], (int)rnd(0, load)); ++rearmed; }
+                }
+                wheelUs += ElapsedUs(t0);
+                pendingSum += wheel.Pending();
+
+                t0 = std::chrono::steady_clock::now();
+                for (Stamps& s : stamps) {
+                    unsigned int active = 0;
+                    for (int t = 0; t < IT_COUNT; ++t) {
+                        bool on = s.at[t] != 0 && (now - s.at[t]) < s.dur[t];
+                        if (!on && s.dur[t]) s.at[t] = now;  // venceu: rearma como a roda
+                        active |= (unsigned int)on << t;
+                    }
+                    s.active = active;
+                }
+                scanUs += ElapsedUs(t0);
+            }
+            // nada fica para trs: tudo o que ficou pendente vence dentro de 3 s
+            unsigned long long scheduledBefore = wheel.Scheduled();
+            now += 3000;
+            wheel.Advance(now);
+            s_wheelBench.due.clear();
+            bool drained = wheel.Pending() == 0 && s_wheelBench.fired + cancelled == scheduledBefore;
+            bool ok = drained && !s_wheelBench.wrongTime;
+            WriteLog("Bench timers: instances=%d timers/instance=%d pending=%.0f wheel %.2f us/frame (%.1f re-arms/frame, %.1f fired/frame) | timestamp scan %.2f us/frame wrongTick=%llu drained=%s%s",
+                vehicles, load, double(pendingSum) / frames, wheelUs / frames, double(rearmed) / frames, double(s_wheelBench.fired) / frames,
+                scanUs / frames, s_wheelBench.wrongTime, drained ? "yes" : "no", ok ? "" : " (FAILED)");
+        }
+    }
+}
+
+// overlay rules: regras padro == heurstica antiga; custo de 32 regras em 256 veculos
+static void BenchOverlayRules() {
+    unsigned int rng = 777u;
+    auto rnd = [&rng](float lo, float hi) { rng = rng * 1664525u + 1013904223u; return lo + (hi - lo) * float(rng >> 8) / 16777216.0f; };
+    auto randomSignals = [&](float* s) {
+        s[RS_SPEED] = rnd(0.0f, 1.2f);
+        s[RS_ACCEL] = rnd(-200.0f, 60.0f);
+        s[RS_RATIO] = rnd(0.0f, 1.0f);
+        s[RS_THROTTLE] = rnd(0.0f, 1.0f) < 0.6f ? 1.0f : 0.0f;
+        s[RS_PRESSED] = rnd(0.0f, 1.0f) < 0.05f ? 1.0f : 0.0f;
+        s[RS_RELEASED] = rnd(0.0f, 1.0f) < 0.05f ? 1.0f : 0.0f;
+        s[RS_SINCE_RELEASE] = rnd(0.0f, 1.0f) < 0.1f ? RULE_NEVER_RELEASED_MS : std::floor(rnd(0.0f, 2000.0f));
+        s[RS_WHEELSPIN] = rnd(0.0f, 1.0f) < 0.1f ? 1.0f : 0.0f;
+        s[RS_SPIN] = rnd(0.0f, 1.0f);
+        s[RS_GEAR] = std::floor(rnd(0.0f, 6.0f));
+        float step = rnd(0.0f, 1.0f);
+        s[RS_GEAR_UP] = step < 0.05f ? 1.0f : 0.0f;
+        s[RS_GEAR_DOWN] = step > 0.95f ? 1.0f : 0.0f;
+    };
+    // a heurstica que as regras padro substituem, escrita  mo
+    auto classicBackfire = [](const float* s) {
+        if (s[RS_WHEELSPIN] > 0.5f) return 3;
+        if (s[RS_ACCEL] < BACKFIRE_DECEL_PER_SEC && s[RS_RATIO] > 0.35f) return 4;
+        if (s[RS_SINCE_RELEASE] < 800.0f && s[RS_RATIO] > 0.20f) return 5;
+        return 0;
+    };
+
+    std::vector<std::pair<int, std::string>> source;
+    std::vector<std::string> def = DefaultOverlayRules();
+    for (size_t i = 0; i < def.size(); ++i) source.emplace_back((int)i + 1, def[i]);
+    OverlayRuleTable defaults;
+    CompileOverlayRules(defaults, source);
+
+    const int samples = 200000;
+    std::vector<float> sig(size_t(samples) * RS_COUNT);
+    for (int i = 0; i < samples; ++i) randomSignals(&sig[size_t(i) * RS_COUNT]);
+    unsigned long long mismatches = 0;
+    for (int i = 0; i < samples; ++i) {
+        const float* s = &sig[size_t(i) * RS_COUNT];
+        uint64_t m = EvaluateOverlayRules(defaults, s);
+        uint64_t bf = m & defaults.slotRules[SND_BACKFIRE];
+        int rule = bf ? defaults.rules[std::countr_zero(bf)].number : 0;
+        bool up = (m & defaults.slotRules[SND_SHIFTUP]) != 0, dn = (m & defaults.slotRules[SND_SHIFTDN]) != 0;
+        if (rule != classicBackfire(s) || up != (s[RS_GEAR_UP] > 0.5f) || dn != (s[RS_GEAR_DOWN] > 0.5f)) ++mismatches;
+    }
+    volatile unsigned long long sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; ++i) sink = sink + EvaluateOverlayRules(defaults, &sig[size_t(i) * RS_COUNT]);
+    double tableUs = ElapsedUs(t0);
+    t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; ++i) sink = sink + classicBackfire(&sig[size_t(i) * RS_COUNT]);
+    double classicUs = ElapsedUs(t0);
+    WriteLog("Bench overlay rules: default table vs hard-coded heuristic over %d samples: mismatches=%llu%s, table %.1f ns/vehicle, hard-coded %.1f ns/vehicle",
+        samples, mismatches, mismatches ? " (FAILED)" : "", tableUs * 1000.0 / samples, classicUs * 1000.0 / samples);
+
+    // IT_RELEASE_SIGNAL tem de durar at ao maior limite de sincerelease, inferior ou superior
+    const struct { const char* rule; uint32_t windowMs; } windows[] = {
+        { "backfire, 100, 0, sincerelease < 800", 801 },
+        { "backfire, 100, 0, sincerelease > 500", 501 },
+        { "backfire, 100, 0, sincerelease >= 200 & sincerelease <= 1200", 1202 },
+        { "backfire, 100, 0, ratio > 0.5", 0 },
+    };
+    int badWindows = 0;
+    for (const auto& w : windows) {
+        OverlayRuleTable t;
+        CompileOverlayRules(t, { { 1, w.rule } });
+        if (t.releaseWindowMs != w.windowMs) {
+            WriteLog("Bench overlay rules: '%s' release window %u ms, expected %u", w.rule, t.releaseWindowMs, w.windowMs);
+            ++badWindows;
+        }
+    }
+    WriteLog("Bench overlay rules: release window checks %d/%d%s", (int)std::size(windows) - badWindows, (int)std::size(windows), badWindows ? " (FAILED)" : "");
+
+    // 32 regras: as 5 padro + 27 sintticas com 1..3 condies sobre sinais variados
+    const char* const slots[] = { "shiftup", "shiftdn", "backfire" };
+    const char* const ops[] = { "<", "<=", ">", ">=" };
+    for (int n = (int)source.size() + 1; n <= 32; ++n) {
+        std::string text = std::string(slots[n % 3]) + ", " + std::to_string(10 + n * 3 % 90) + ", " + std::to_string(n * 37 % 500) + ", ";
+        int terms = 1 + n % 3;
+        for (int k = 0; k < terms; ++k) {
+            int s = (n * 7 + k * 5) % RS_COUNT;
+            char cond[64];
+            if (s == RS_THROTTLE || s == RS_PRESSED || s == RS_RELEASED || s == RS_WHEELSPIN || s == RS_GEAR_UP || s == RS_GEAR_DOWN)
+                snprintf(cond, sizeof(cond), "%s%s", (n + k) % 2 ? "!" : "", s_ruleSignalNames[s]);
+            else if (s == RS_GEAR)
+                snprintf(cond, sizeof(cond), "gear == %d", 1 + n % 5);
+            else {
+                float probe[RS_COUNT];
+                randomSignals(probe);
+                snprintf(cond, sizeof(cond), "%s %s %g", s_ruleSignalNames[s], ops[(n + k) % 4], probe[s]);
+            }
+            text += (k ? " & " : "") + std::string(cond);
+        }
+        source.emplace_back(n, text);
+    }
+    OverlayRuleTable table;
+    t0 = std::chrono::steady_clock::now();
+    CompileOverlayRules(table, source);
+    double compileUs = ElapsedUs(t0);
+
+    const int vehicles = 256;
+    const int frames = 2000;
+    std::vector<VehicleAudioInstance> insts(vehicles);
+    std::vector<float> live(size_t(vehicles) * RS_COUNT);
+    for (int v = 0; v < vehicles; ++v) randomSignals(&live[size_t(v) * RS_COUNT]);
+    unsigned long long matchedRules = 0, fired = 0;
+    double evalUs = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        // 1/8 dos veculos muda de estado por frame; o resto s varia um pouco
+        for (int v = f % 8; v < vehicles; v += 8) randomSignals(&live[size_t(v) * RS_COUNT]);
+        t0 = std::chrono::steady_clock::now();
+        for (int v = 0; v < vehicles; ++v) {
+            uint64_t m = EvaluateOverlayRules(table, &live[size_t(v) * RS_COUNT]);
+            matchedRules += std::popcount(m);
+            for (int slot = SND_SHIFTUP; m && slot <= SND_BACKFIRE; ++slot) {
+                uint64_t sm = m & table.slotRules[slot];
+                if (!sm) continue;
+                const OverlayRule& rule = table.rules[std::countr_zero(sm)];
+                if (rule.threshold == UINT32_MAX || NextOverlayRandom(insts[v], uintptr_t(0x10000 + v * 0x40)) < rule.threshold) ++fired;
+            }
+        }
+        evalUs += ElapsedUs(t0);
+    }
+    double perVehicleNs = evalUs * 1000.0 / (double(frames) * vehicles);
+    WriteLog("Bench overlay rules: %zu rules / %zu terms compiled in %.1f us; %d vehicles: %.2f us/frame, %.1f ns/vehicle, %.2f ns/rule; %.2f rules matched and %.2f overlays fired per vehicle-frame",
+        table.rules.size(), table.terms.size(), compileUs, vehicles, evalUs / frames, perVehicleNs, perVehicleNs / table.rules.size(),
+        double(matchedRules) / (double(frames) * vehicles), double(fired) / (double(frames) * vehicles));
+}
+
+// parque de estacionamento: 240 carros parados ao ralenti e 16 a circular. Mede a frame
+// (sonda + clculo + kernel + submisso mnima sem FMOD) sem e com dormncia; a meio,
+// 24 carros parados levam um toque e tm de acordar na prpria frame.
+static void BenchParkingLot() {
+    const int parked = 240, moving = 16, vehicles = parked + moving;
+    const int frames = 3000, steadyFrom = 1000, bumpFrame = 2000, bumpFrames = 30;
+    EnsureOverlayRules();
+
+    WavBank bank;
+    MakeSyntheticBank(bank);
+    static int channelTag = 0;
+    FMOD::Channel* fakeChannel = reinterpret_cast<FMOD::Channel*>(&channelTag);
+
+    float savedAfter = DORMANT_AFTER_MS, savedDist = DORMANT_RELEASE_DIST;
+    DormancyStats savedStats = g_dormancy;
+    DORMANT_RELEASE_DIST = 100.0f;
+    const FMOD_VECTOR listener = { 0.0f, 0.0f, 0.0f };
+
+    // o que a sonda l do veculo; os parados com v % 10 == 0 levam o toque
+    auto drive = [&](int v, int f, DormantProbe& p) {
+        p.valid = true;
+        if (v >= parked) {
+            p.throttle = ((f / 30 + v) % 3) != 0;
+            p.gear = 1 + ((f / 60 + v) % MAX_TRANSMISSION_GEARS);
+            p.speed = 5.0f + std::fmod(f * 0.7f + v * 3.0f, 55.0f);
+            return;
+        }
+        bool bump = v % 10 == 0 && f >= bumpFrame && f < bumpFrame + bumpFrames;
+        p.gear = 1;
+        p.throttle = false;
+        p.speed = bump ? 2.0f : 0.0f;
+    };
+
+    std::vector<VehicleAudioInstance> instances(vehicles);
+    std::vector<VehicleAudioInstance*> list;
+    std::vector<InstanceInputs> inputs;
+    std::vector<InstanceCommands> cmds;
+    SmoothingBatch batch;
+    WorkStealingPool pool;
+    pool.Start(0);
+
+    double steadyUs[2] = {};
+    for (int pass = 0; pass < 2; ++pass) {
+        DORMANT_AFTER_MS = pass ? 2000.0f : 0.0f;
+        g_dormancy = DormancyStats();
+        TimerWheel timers;
+        for (int v = 0; v < vehicles; ++v) {
+            instances[v] = VehicleAudioInstance();
+            instances[v].bank = &bank;
+            instances[v].currentVolume = 0.45f;
+        }
+
+        double totalUs = 0.0, activeSum = 0.0;
+        int wokeOnBump = 0, movingSlept = 0, dormantAtBump = 0;
+        for (int f = 0; f < frames; ++f) {
+            unsigned int now = 1000u + (unsigned int)f * 20u;
+            auto t0 = std::chrono::steady_clock::now();
+            list.clear();
+            inputs.clear();
+            for (int v = 0; v < vehicles; ++v) {
+                VehicleAudioInstance& inst = instances[v];
+                DormantProbe p;
+                drive(v, f, p);
+                if (inst.dormant) {
+                    if (f == bumpFrame && v < parked && v % 10 == 0) ++dormantAtBump;
+                    if (!DormantShouldWake(inst, p)) continue;
+                    WakeInstance(inst, WAKE_INPUT);
+                    if (f == bumpFrame && v < parked && v % 10 == 0) ++wokeOnBump;
+                }
+                list.push_back(&inst);
+                InstanceInputs& in = inputs.emplace_back();
+                in.active = true;
+                in.vehKey = 0x10000 + (uintptr_t)v * 0x40;
+                in.modelIndex = 400 + v % 200;
+                in.gasPressed = p.throttle;
+                in.gear = p.gear;
+                in.speed = p.speed;
+                in.timeStep = 1.0f;
+                in.nowMs = now;
+                in.emitter.pos = { (float)(v % 16) * 10.0f, (float)(v / 16) * 10.0f, 0.0f };  // at ~210 m do ouvinte
+            }
+            int n = (int)list.size();
+            cmds.resize(n);
+            batch.Resize(n);
+            timers.Advance(now);
+            ComputeInstances(pool, list, inputs, cmds, batch, 1);
+            RunSmoothingKernel(batch);
+
+            // "submisso" mnima, como no BenchParallelUpdate, mais o stop do wind parado
+            for (int i = 0; i < n; ++i) {
+                VehicleAudioInstance& inst = *list[i];
+                const InstanceCommands& cmd = cmds[i];
+                ArmInstanceTimers(timers, inst, cmd, now);
+                if (cmd.startLoop) { inst.loopMode = cmd.loopMode; inst.loopChannel = fakeChannel; }
+                if (cmd.startWind) { inst.windChannel = fakeChannel; StartWindFade(timers, inst, now); }
+                if (!cmd.hasLane) continue;
+                inst.currentPitch = batch.currentPitch[i];
+                inst.currentVolume = batch.currentVolume[i];
+                inst.currentWindVolume = batch.currentWind[i];
+                if (inst.windChannel && inst.currentWindVolume < WIND_STOP_THRESHOLD && !cmd.signals.throttle && cmd.signals.filteredSpeed < 0.5f) {
+                    inst.windChannel = nullptr;
+                    inst.currentWindVolume = inst.targetWindVolume = 0.0f;
+                    CancelInstanceTimer(timers, inst, IT_WIND_FADE);
+                }
+            }
+            // o fakeChannel no  um canal FMOD: quem vai adormecer larga-o antes, seno o
+            // SleepInstance (wind sempre, o resto se longe) chamava stop() nele. Quem dorme
+            // sem release mantm o loop, como no jogo
+            for (VehicleAudioInstance* inst : list) {
+                if (!inst->sleepPending) continue;
+                inst->loopChannel = inst->pendingLoopChannel = inst->windChannel = nullptr;
+                inst->attackChannel = inst->shiftChannel = nullptr;
+            }
+            SettleInstances(timers, list, inputs, listener);
+            for (VehicleAudioInstance* inst : list) {
+                if (inst->dormant && !inst->dormantReleased && inst->loopMode != LM_NONE) inst->loopChannel = fakeChannel;
+            }
+            double us = ElapsedUs(t0);
+            totalUs += us;
+            if (f >= steadyFrom && f < bumpFrame) {
+                steadyUs[pass] += us;
+                activeSum += n;
+            }
+            for (int v = parked; v < vehicles; ++v) movingSlept += instances[v].dormant ? 1 : 0;
+        }
+        // os que ficaram a dormir libertam os canais falsos (nada a parar de verdade)
+        for (VehicleAudioInstance& inst : instances) {
+            inst.loopChannel = inst.pendingLoopChannel = inst.windChannel = nullptr;
+            inst.attackChannel = inst.shiftChannel = nullptr;
+        }
+
+        int steadyFrames = bumpFrame - steadyFrom;
+        const DormancyStats& s = g_dormancy;
+        bool ok = !pass || (movingSlept == 0 && dormantAtBump == parked / 10 && wokeOnBump == dormantAtBump);
+        WriteLog("Bench parking lot: dormancy=%s vehicles=%d (parked=%d) %.1f us/frame, steady %.1f us/frame active=%.1f dormant=%.1f sleeps=%llu released=%llu wakes=%llu bumped woke %d/%d in-frame movingSlept=%d%s",
+            pass ? "on" : "off", vehicles, parked, totalUs / frames, steadyUs[pass] / steadyFrames, activeSum / steadyFrames,
+            vehicles - activeSum / steadyFrames, s.sleeps, s.released, s.wakes[WAKE_INPUT], wokeOnBump, dormantAtBump, movingSlept,
+            ok ? "" : " (FAILED)");
+    }
+    pool.Stop();
+    WriteLog("Bench parking lot: steady frame %.1fx cheaper with dormancy", steadyUs[1] > 0.0 ? steadyUs[0] / steadyUs[1] : 0.0);
+
+    DORMANT_AFTER_MS = savedAfter;
+    DORMANT_RELEASE_DIST = savedDist;
+    g_dormancy = savedStats;
+}
+
+static std::string g_benchTracePath;  // --trace: entradas gravadas para o check de FPS
+
+static void RunBenchmarks() {
+    WriteLog("RunBenchmarks: starting");
+    BenchResponseTables();
+    BenchSmoothingKernels();
+    BenchParallelUpdate();
+    CheckFrameRateConsistency(g_benchTracePath);
+    BenchOutputLatency();
+    BenchFMODAllocator();
+    BenchPreprocessedVoices();
+    BenchLoudnessAnalysis();
+    BenchBankRegistry();
+    BenchOcclusion();
+    BenchVehicleGrid();
+    BenchTelemetry();
+    BenchOverlayRules();
+    BenchTimerWheel();
+    BenchParkingLot();
+    WriteLog("RunBenchmarks: done");
+}
+
+
+struct BenchEntry {
+    const char* name;
+    void (*run)();
+};
+
+static const BenchEntry kBenches[] = {
+    { "tables", BenchResponseTables },
+    { "smoothing", BenchSmoothingKernels },
+    { "parallel", BenchParallelUpdate },
+    { "fps", [] { CheckFrameRateConsistency(g_benchTracePath); } },
+    { "latency", BenchOutputLatency },
+    { "allocator", BenchFMODAllocator },
+    { "voices", BenchPreprocessedVoices },
+    { "loudness", BenchLoudnessAnalysis },
+    { "registry", BenchBankRegistry },
+    { "occlusion", BenchOcclusion },
+    { "grid", BenchVehicleGrid },
+    { "telemetry", BenchTelemetry },
+    { "rules", BenchOverlayRules },
+    { "wheel", BenchTimerWheel },
+    { "parking", BenchParkingLot },
+};
+
+int main(int argc, char** argv) {
+    std::string iniPath = "VehicleSFX.ini";
+    std::vector<const BenchEntry*> selected;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "--ini") && i + 1 < argc) { iniPath = argv[++i]; continue; }
+        if (!strcmp(argv[i], "--trace") && i + 1 < argc) { g_benchTracePath = argv[++i]; continue; }
+        if (!strcmp(argv[i], "--list")) {
+            for (const BenchEntry& b : kBenches) std::printf("%s\n", b.name);
+            return 0;
+        }
+        const BenchEntry* found = nullptr;
+        for (const BenchEntry& b : kBenches) if (!strcmp(argv[i], b.name)) found = &b;
+        if (!found) {
+            std::fprintf(stderr, "benchmark desconhecido: %s (--list)\n", argv[i]);
+            return 1;
+        }
+        selected.push_back(found);
+    }
+
+    InitLog();
+    LoadConfig(iniPath);
+    InitParams();
+    InstallFMODMemory();
+    if (selected.empty()) {
+        RunBenchmarks();
+        return 0;
+    }
+    for (const BenchEntry* b : selected) b->run();
+    return 0;
+}